@@ -0,0 +1,180 @@
+/************************  bench/agg_bench.cpp  ************************
+ * Aggregates inside the engine against computing them in the client.
+ *
+ *   kernels   Mvalues/s of sum / min / max over an int32 array: a plain
+ *             loop against the agg:: kernels (AVX2 when the CPU has
+ *             it; the compiler may vectorize the loop as well)
+ *   groups    Mrows/s mapping INT keys to group numbers, 100 and 1M
+ *             distinct keys: std::unordered_map against AggHashTable
+ *   queries   ms per statement on a table of `rows` rows
+ *             (id INT, name CHAR(16), v INT), with the check of its
+ *             result (trivial but for the client's):
+ *               client       SELECT * and the figures worked out from
+ *                            the printed text, as before
+ *               count        SELECT COUNT(*): the scan alone
+ *               aggregates   COUNT, SUM, MIN, MAX, AVG of v
+ *               where        SUM of v over id < rows / 2 (a Filter below)
+ *               group v      GROUP BY v (100 groups)
+ *               group name   GROUP BY name (1000 CHAR groups)
+ *               group id     GROUP BY id (a group per row)
+ *
+ * Every engine result is checked against figures computed here.
+ *
+ *   usage: agg_bench [rows]      (default: 1000000)
+ ************************************************************************/
+#include "storage/disk_manager.hpp"
+#include "storage/buffer_pool_manager.hpp"
+#include "storage/replacer_factory.hpp"
+#include "storage/catalog.hpp"
+#include "parser/query_parser.hpp"
+#include "execution/query_executor.hpp"
+#include "execution/agg_kernels.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+static const char* DATA = "agg_bench.data";
+static constexpr size_t POOL = 32768;
+
+static size_t errors = 0;
+static volatile long long sink;
+
+template <typename F>
+static double seconds(F f) {
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(t1 - t0).count();
+}
+
+/* ---------- kernels ---------- */
+
+static void kernels() {
+    const size_t n = 1024, reps = 20000;
+    std::mt19937 rng(7);
+    std::vector<int32_t> v(n);
+    for (auto& x : v) x = static_cast<int32_t>(rng());
+
+    auto row = [&](const char* op, auto loop, auto kernel) {
+        double a = seconds([&] { for (size_t r = 0; r < reps; ++r) sink = loop(); });
+        double b = seconds([&] { for (size_t r = 0; r < reps; ++r) sink = kernel(); });
+        std::printf("%-8s %12.0f %12.0f\n", op, n * reps / a / 1e6, n * reps / b / 1e6);
+        errors += loop() != kernel();
+    };
+    std::printf("%-8s %12s %12s\n", "kernel", "loop Mv/s", "agg:: Mv/s");
+    row("sum", [&] { long long s = 0; for (int32_t x : v) s += x; return s; },
+               [&] { return static_cast<long long>(agg::sum(v.data(), n)); });
+    row("min", [&] { int32_t m = INT32_MAX; for (int32_t x : v) m = std::min(m, x); return static_cast<long long>(m); },
+               [&] { return static_cast<long long>(agg::min(v.data(), n, INT32_MAX)); });
+    row("max", [&] { int32_t m = INT32_MIN; for (int32_t x : v) m = std::max(m, x); return static_cast<long long>(m); },
+               [&] { return static_cast<long long>(agg::max(v.data(), n, INT32_MIN)); });
+}
+
+/* ---------- group numbering ---------- */
+
+static void groups(size_t rows) {
+    std::printf("\n%-8s %12s %12s\n", "keys", "map Mrows/s", "table Mrows/s");
+    for (size_t distinct : { size_t(100), size_t(1000000) }) {
+        std::mt19937 rng(11);
+        std::vector<int32_t> keys(rows);
+        for (auto& k : keys) k = static_cast<int32_t>(rng() % distinct);
+
+        std::vector<uint32_t> a(rows), b(rows);
+        double map_s = seconds([&] {
+            std::unordered_map<int32_t, uint32_t> m;
+            for (size_t r = 0; r < rows; ++r) a[r] = m.emplace(keys[r], static_cast<uint32_t>(m.size())).first->second;
+        });
+        double table_s = seconds([&] {
+            AggHashTable t(sizeof(int32_t));
+            for (size_t r = 0; r < rows; ++r) b[r] = t.find_or_insert(reinterpret_cast<const char*>(&keys[r]));
+        });
+        std::printf("%-8zu %12.1f %12.1f\n", distinct, rows / map_s / 1e6, rows / table_s / 1e6);
+        errors += a != b;
+    }
+}
+
+/* ---------- queries ---------- */
+
+int main(int argc, char** argv) {
+    size_t rows = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    kernels();
+    groups(rows);
+    std::remove(DATA);
+
+    {
+        auto dm = make_disk_manager(DATA, "pread");
+        BufferPoolManager bpm(POOL, dm.get(), make_replacer("clock", POOL));
+        Catalog catalog(&bpm);
+        QueryExecutor exec(&catalog);
+        auto run = [&](const std::string& sql) { return exec.execute(*QueryParser::parse(sql)).value_or(""); };
+
+        run("CREATE TABLE t (id INT, name CHAR(16), v INT);");
+        std::string batch;
+        long long sum = 0, half_sum = 0;
+        for (size_t i = 0; i < rows; ++i) {
+            batch += (batch.empty() ? "INSERT INTO t VALUES " : ", ");
+            batch += "(" + std::to_string(i) + ", 'name" + std::to_string(i % 1000) + "', " + std::to_string(i % 100) + ")";
+            sum += i % 100;
+            if (i < rows / 2) half_sum += i % 100;
+            if (i % 1000 == 999 || i + 1 == rows) {
+                run(batch + ";");
+                batch.clear();
+            }
+        }
+        std::printf("\n%-12s %10s\n", "query", "ms");
+        auto query = [&](const char* name, const std::string& sql, auto check) {
+            bool ok = false;
+            double s = seconds([&] { ok = check(run(sql)); });
+            std::printf("%-12s %10.1f\n", name, s * 1e3);
+            errors += !ok;
+        };
+
+        query("client", "SELECT * FROM t;", [&](const std::string& out) {
+            // What a client did before: parse every line, then add up
+            std::istringstream in(out);
+            long long id, v, n = 0, s = 0, lo = LLONG_MAX, hi = LLONG_MIN;
+            std::string name;
+            while (in >> id >> name >> v) ++n, s += v, lo = std::min(lo, v), hi = std::max(hi, v);
+            return static_cast<size_t>(n) == rows && s == sum && lo == 0 && hi == std::min<long long>(99, rows - 1);
+        });
+        query("count", "SELECT COUNT(*) FROM t;", [&](const std::string& out) {
+            return out == std::to_string(rows) + " \n";
+        });
+        query("aggregates", "SELECT COUNT(*), SUM(v), MIN(v), MAX(v), AVG(v) FROM t;", [&](const std::string& out) {
+            std::istringstream in(out);
+            long long n, s, lo, hi;
+            double a;
+            in >> n >> s >> lo >> hi >> a;
+            return static_cast<size_t>(n) == rows && s == sum && lo == 0 && hi == std::min<long long>(99, rows - 1) &&
+                   std::abs(a - static_cast<double>(sum) / rows) < 1e-9;
+        });
+        query("where", "SELECT SUM(v) FROM t WHERE id < " + std::to_string(rows / 2) + ";", [&](const std::string& out) {
+            return rows < 2 || out == std::to_string(half_sum) + " \n";
+        });
+        query("group v", "SELECT v, COUNT(*), SUM(id) FROM t GROUP BY v;", [&](const std::string& out) {
+            return static_cast<size_t>(std::count(out.begin(), out.end(), '\n')) == std::min<size_t>(100, rows);
+        });
+        query("group name", "SELECT name, COUNT(*), AVG(v) FROM t GROUP BY name;", [&](const std::string& out) {
+            return static_cast<size_t>(std::count(out.begin(), out.end(), '\n')) == std::min<size_t>(1000, rows);
+        });
+        query("group id", "SELECT id, MAX(v) FROM t GROUP BY id;", [&](const std::string& out) {
+            return static_cast<size_t>(std::count(out.begin(), out.end(), '\n')) == rows;
+        });
+    }
+    std::remove(DATA);
+
+    if (errors) {
+        std::fprintf(stderr, "FAILED: %zu results were wrong\n", errors);
+        return 1;
+    }
+    std::printf("OK\n");
+    return 0;
+}
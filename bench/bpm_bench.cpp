@@ -0,0 +1,112 @@
+/************************  bench/bpm_bench.cpp  ************************
+ * Multi-threaded stress + throughput benchmark for BufferPoolManager.
+ *
+ * Every page carries its own page id in the body. Worker threads fetch
+ * pages with a skewed (80/20) access pattern, verify the stamp under a
+ * read latch, occasionally bump a counter under the write latch, and
+ * unpin. Reports fetch/unpin pairs per second at 1..64 threads and exits
+ * non-zero if any page ever shows the wrong content.
+ *
+ *   usage: bpm_bench [ops_per_thread] [pool_frames] [pages] [policy] [io]
+ *   io: pread (default) | direct | uring | uring-direct | mmap
+ ************************************************************************/
+#include "storage/disk_manager.hpp"
+#include "storage/buffer_pool_manager.hpp"
+#include "storage/replacer_factory.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+static constexpr size_t STAMP_POS = 0;                 // body offset of page id stamp
+static constexpr size_t COUNTER_POS = sizeof(uint32_t); // body offset of write counter
+
+int main(int argc, char** argv) {
+    size_t ops = argc > 1 ? std::stoul(argv[1]) : 200000;
+    // Each of up to 64 threads holds one pin at a time; keep room to evict
+    size_t pool = std::max<size_t>(argc > 2 ? std::stoul(argv[2]) : 1024, 128);
+    size_t pages = argc > 3 ? std::stoul(argv[3]) : pool * 4;
+    std::string policy = argc > 4 ? argv[4] : "clock";
+    std::string io = argc > 5 ? argv[5] : "pread";
+
+    const char* file = "bpm_bench.data";
+    std::remove(file);
+    auto dm = make_disk_manager(file, io);
+    BufferPoolManager bpm(pool, dm.get(), make_replacer(policy, pool));
+
+    std::vector<uint32_t> ids(pages);
+    for (size_t i = 0; i < pages; ++i) {
+        Page* p = bpm.new_page(ids[i]);
+        if (!p) { std::fprintf(stderr, "new_page failed\n"); return 1; }
+        uint32_t zero = 0;
+        p->write_content(reinterpret_cast<const std::byte*>(&ids[i]), STAMP_POS, sizeof(uint32_t));
+        p->write_content(reinterpret_cast<const std::byte*>(&zero), COUNTER_POS, sizeof(uint32_t));
+        bpm.unpin_page(ids[i], true);
+    }
+    bpm.flush_all_pages();
+
+    std::atomic<size_t> errors{ 0 };
+    size_t hot = std::max<size_t>(1, pool / 2);
+
+    std::printf("policy=%s io=%s pool=%zu pages=%zu\n", policy.c_str(), dm->backend_name(), pool, pages);
+    std::printf("%8s %14s %12s\n", "threads", "ops/s", "dirty@end");
+    for (size_t threads = 1; threads <= 64; threads *= 2) {
+        std::vector<std::thread> workers;
+        auto t0 = std::chrono::steady_clock::now();
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                std::mt19937 rng(static_cast<uint32_t>(t * 7919 + threads));
+                std::uniform_int_distribution<size_t> pct(0, 99);
+                std::uniform_int_distribution<size_t> hot_pick(0, hot - 1);
+                std::uniform_int_distribution<size_t> any_pick(0, pages - 1);
+                for (size_t i = 0; i < ops; ++i) {
+                    uint32_t pid = ids[pct(rng) < 80 ? hot_pick(rng) : any_pick(rng)];
+                    Page* p = bpm.fetch_page(pid);
+                    bool write = pct(rng) < 10;
+                    uint32_t stamp;
+                    if (write) {
+                        p->w_latch();
+                        uint32_t cnt;
+                        p->read_content(reinterpret_cast<std::byte*>(&cnt), COUNTER_POS, sizeof(cnt));
+                        ++cnt;
+                        p->write_content(reinterpret_cast<const std::byte*>(&cnt), COUNTER_POS, sizeof(cnt));
+                        p->read_content(reinterpret_cast<std::byte*>(&stamp), STAMP_POS, sizeof(stamp));
+                        p->w_unlatch();
+                    }
+                    else {
+                        p->r_latch();
+                        p->read_content(reinterpret_cast<std::byte*>(&stamp), STAMP_POS, sizeof(stamp));
+                        p->r_unlatch();
+                    }
+                    if (stamp != pid) errors.fetch_add(1);
+                    bpm.unpin_page(pid, write);
+                }
+                });
+        }
+        for (auto& w : workers) w.join();
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        std::printf("%8zu %14.0f %12zu\n", threads, (threads * ops) / secs, bpm.dirty_pages());
+    }
+
+    // Every page must still be resident-or-readable with its own stamp
+    for (uint32_t pid : ids) {
+        Page* p = bpm.fetch_page(pid);
+        uint32_t stamp;
+        p->read_content(reinterpret_cast<std::byte*>(&stamp), STAMP_POS, sizeof(stamp));
+        if (stamp != pid) errors.fetch_add(1);
+        bpm.unpin_page(pid, false);
+    }
+
+    if (errors.load()) {
+        std::fprintf(stderr, "FAILED: %zu pages with wrong content\n", errors.load());
+        return 1;
+    }
+    std::printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,343 @@
+/************************  bench/btree_bench.cpp  ************************
+ * B+-tree insert / lookup throughput: the page-based tree at two fanouts
+ * against the old pointer-based tree (bench/legacy_bplus_tree.hpp), plus
+ * the in-node search kernel on its own (SIMD vs std::lower_bound), and
+ * bottom-up bulk_load (sorted input) against one-by-one inserts, the
+ * same keys as 16-byte strings in a byte-key tree (prefix-compressed
+ * nodes), and point-lookup throughput as reader threads are added (the
+ * tree's readers take no latches, so this should grow with the core count).
+ *
+ * Then a mixed stress run on a fanout-8 tree, so splits, merges, borrows
+ * and root changes happen all the time. Writer threads insert and remove
+ * disjoint sets of keys, spread over the whole key range, in rounds. A
+ * fixed set of keys (every 16th) stays in the tree throughout. Readers
+ * look up random keys: a stable key must be found, and any key found must
+ * carry its own value. A scanner walks the tree with an Iterator over and
+ * over: keys strictly increasing, every stable key seen. At the end only
+ * the stable keys may be left.
+ *
+ * Keys are a random permutation of 0..N-1; lookups probe random keys.
+ * The buffer pool is sized to hold the whole tree and the flusher is
+ * off, so the numbers are in-memory costs.
+ *
+ *   usage: btree_bench [keys...]      (default: 1000000)
+ *          e.g. btree_bench 1000000 10000000 100000000
+ *************************************************************************/
+#include "storage/disk_manager.hpp"
+#include "storage/buffer_pool_manager.hpp"
+#include "storage/bplus_tree.hpp"
+#include "storage/replacer_factory.hpp"
+#include "storage/rid.hpp"
+#include "legacy_bplus_tree.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+static double secs_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+struct Result { double insert_mops, lookup_mops; size_t misses; };
+
+template <typename Tree>
+static Result run(Tree& tree, const std::vector<int>& keys, const std::vector<int>& probes) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (int k : keys) tree.insert(k, RID(static_cast<uint32_t>(k), 0));
+    double ins = secs_since(t0);
+
+    size_t misses = 0;
+    t0 = std::chrono::steady_clock::now();
+    for (int k : probes) {
+        auto r = tree.search(k);
+        misses += !r || r->page_id() != static_cast<uint32_t>(k);
+    }
+    double look = secs_since(t0);
+    return { keys.size() / ins / 1e6, probes.size() / look / 1e6, misses };
+}
+
+// Insert column: one-by-one inserts, or bulk_load of the sorted keys
+template <size_t Fanout>
+static Result run_paged(const std::vector<int>& keys, const std::vector<int>& probes, bool bulk = false) {
+    using Tree = BPlusTree<int, RID, Fanout>;
+    const char* file = "btree_bench.data";
+    std::remove(file);
+    // Half-full leaves in the worst case, plus the internal levels
+    size_t pool = keys.size() / (Tree::LEAF_MAX / 2) * 5 / 4 + 1024;
+    auto dm = make_disk_manager(file, "pread");
+    Result r;
+    {
+        BufferPoolManager bpm(pool, dm.get(), make_replacer("clock", pool), pool, std::chrono::milliseconds(0));
+        Tree tree(&bpm);
+        if (!bulk) {
+            r = run(tree, keys, probes);
+        } else {
+            std::vector<std::pair<int, RID>> sorted;
+            sorted.reserve(keys.size());
+            for (int k : keys) sorted.emplace_back(k, RID(static_cast<uint32_t>(k), 0));
+            std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+            auto t0 = std::chrono::steady_clock::now();
+            tree.bulk_load(sorted.begin(), sorted.end());
+            double load = secs_since(t0);
+            r = run(tree, {}, probes);
+            r.insert_mops = keys.size() / load / 1e6;
+        }
+    }
+    std::remove(file);
+    return r;
+}
+
+// The keys as "key_0000000042": byte keys sharing long prefixes
+static Result run_bytes(const std::vector<int>& keys, const std::vector<int>& probes) {
+    using Tree = BPlusTree<std::string, RID>;
+    auto name = [](int k) {
+        char buf[17];
+        std::snprintf(buf, sizeof buf, "key_%010d", k);
+        return std::string(buf, 16);
+    };
+    std::vector<std::string> key_names, probe_names;
+    for (int k : keys) key_names.push_back(name(k));
+    for (int k : probes) probe_names.push_back(name(k));
+
+    const char* file = "btree_bench.data";
+    std::remove(file);
+    size_t pool = keys.size() / 50 + 1024;
+    auto dm = make_disk_manager(file, "pread");
+    Result r{};
+    {
+        BufferPoolManager bpm(pool, dm.get(), make_replacer("clock", pool), pool, std::chrono::milliseconds(0));
+        Tree tree(&bpm, KeyWidth{ 16 });
+        auto t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < keys.size(); ++i) tree.insert(key_names[i], RID(static_cast<uint32_t>(keys[i]), 0));
+        r.insert_mops = keys.size() / secs_since(t0) / 1e6;
+
+        t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < probes.size(); ++i) {
+            auto v = tree.search(probe_names[i]);
+            r.misses += !v || v->page_id() != static_cast<uint32_t>(probes[i]);
+        }
+        r.lookup_mops = probes.size() / secs_since(t0) / 1e6;
+    }
+    std::remove(file);
+    return r;
+}
+
+// Lookups from 1, 2, 4, ... threads (up to the core count) on one tree
+static size_t scaling_bench(const std::vector<int>& keys) {
+    using Tree = BPlusTree<int, RID>;
+    const char* file = "btree_bench.data";
+    std::remove(file);
+    size_t pool = keys.size() / Tree::LEAF_MAX * 5 / 4 + 1024;
+    auto dm = make_disk_manager(file, "pread");
+    size_t misses = 0;
+    {
+        BufferPoolManager bpm(pool, dm.get(), make_replacer("clock", pool), pool, std::chrono::milliseconds(0));
+        Tree tree(&bpm);
+        std::vector<std::pair<int, RID>> sorted;
+        for (int k : keys) sorted.emplace_back(k, RID(static_cast<uint32_t>(k), 0));
+        std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        tree.bulk_load(sorted.begin(), sorted.end());
+
+        const size_t per_thread = 500000;
+        unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<unsigned> counts;
+        for (unsigned t = 1; t < cores; t *= 2) counts.push_back(t);
+        counts.push_back(cores);
+        std::printf("\n%8s %14s %9s\n", "threads", "lookup Mops/s", "speedup");
+        double base = 0;
+        for (unsigned t : counts) {
+            std::vector<std::thread> threads;
+            std::vector<size_t> bad(t);
+            auto t0 = std::chrono::steady_clock::now();
+            for (unsigned i = 0; i < t; ++i) {
+                threads.emplace_back([&, i] {
+                    std::mt19937 rng(1000 + i);
+                    for (size_t j = 0; j < per_thread; ++j) {
+                        int k = static_cast<int>(rng() % keys.size());
+                        auto r = tree.search(k);
+                        bad[i] += !r || r->page_id() != static_cast<uint32_t>(k);
+                    }
+                });
+            }
+            for (auto& th : threads) th.join();
+            double mops = t * per_thread / secs_since(t0) / 1e6;
+            if (t == 1) base = mops;
+            std::printf("%8u %14.2f %8.2fx\n", t, mops, mops / base);
+            for (size_t b : bad) misses += b;
+        }
+    }
+    std::remove(file);
+    return misses;
+}
+
+// Mixed inserts, removes, lookups and scans on one tree. Returns the
+// number of invariant violations seen.
+static size_t stress_bench() {
+    using Tree = BPlusTree<int, RID, 8>;
+    constexpr int KEYS = 1 << 16;
+    constexpr int STABLE_EVERY = 16;
+    constexpr unsigned WRITERS = 4, READERS = 2;
+    constexpr int ROUNDS = 4;
+    const char* file = "btree_bench.data";
+    std::remove(file);
+    size_t pool = 16384;
+    auto dm = make_disk_manager(file, "pread");
+    std::atomic<size_t> errors{ 0 }, ops{ 0 }, scans{ 0 };
+    {
+        BufferPoolManager bpm(pool, dm.get(), make_replacer("clock", pool), pool, std::chrono::milliseconds(0));
+        Tree tree(&bpm);
+        for (int k = 0; k < KEYS; k += STABLE_EVERY) tree.insert(k, RID(static_cast<uint32_t>(k), 0));
+
+        std::atomic<unsigned> writing{ WRITERS };
+        std::vector<std::thread> threads;
+        auto t0 = std::chrono::steady_clock::now();
+        for (unsigned w = 0; w < WRITERS; ++w) {
+            threads.emplace_back([&, w] {
+                std::vector<int> mine;
+                for (int k = 0; k < KEYS; ++k)
+                    if (k % STABLE_EVERY != 0 && static_cast<unsigned>(k / STABLE_EVERY) % WRITERS == w) mine.push_back(k);
+                std::mt19937 rng(77 + w);
+                for (int round = 0; round < ROUNDS; ++round) {
+                    std::shuffle(mine.begin(), mine.end(), rng);
+                    for (int k : mine) errors += !tree.insert(k, RID(static_cast<uint32_t>(k), round));
+                    for (int k : mine) {
+                        auto v = tree.search(k);
+                        errors += !v || v->page_id() != static_cast<uint32_t>(k);
+                    }
+                    std::shuffle(mine.begin(), mine.end(), rng);
+                    for (int k : mine) errors += !tree.remove(k);
+                    ops += 3 * mine.size();
+                }
+                --writing;
+            });
+        }
+        for (unsigned r = 0; r < READERS; ++r) {
+            threads.emplace_back([&, r] {
+                std::mt19937 rng(300 + r);
+                size_t n = 0;
+                while (writing.load()) {
+                    int k = static_cast<int>(rng() % KEYS);
+                    auto v = tree.search(k);
+                    if (k % STABLE_EVERY == 0) errors += !v;
+                    if (v) errors += v->page_id() != static_cast<uint32_t>(k);
+                    ++n;
+                }
+                ops += n;
+            });
+        }
+        threads.emplace_back([&] {
+            while (writing.load()) {
+                int stable = 0;
+                bool first = true;
+                int last = 0;
+                for (auto it = tree.begin(); it.valid(); ++it) {
+                    int k = it.key();
+                    if (!first && k <= last) ++errors;       // out of order or repeated
+                    if (it.value().page_id() != static_cast<uint32_t>(k)) ++errors;
+                    stable += k % STABLE_EVERY == 0;
+                    first = false;
+                    last = k;
+                }
+                errors += stable != KEYS / STABLE_EVERY;
+                ++scans;
+            }
+        });
+        for (auto& th : threads) th.join();
+        double secs = secs_since(t0);
+
+        // Only the stable keys are left
+        int left = 0;
+        for (auto it = tree.begin(); it.valid(); ++it) {
+            errors += it.key() != left * STABLE_EVERY;
+            ++left;
+        }
+        errors += left != KEYS / STABLE_EVERY;
+        std::printf("\nstress: %u writers, %u readers, 1 scanner: %.2f Mops/s, %zu full scans, %zu errors\n",
+            WRITERS, READERS, ops.load() / secs / 1e6, scans.load(), errors.load());
+    }
+    std::remove(file);
+    return errors.load();
+}
+
+// In-node search on one full node's worth of sorted keys
+static void kernel_bench() {
+    constexpr size_t N = BPlusTree<int, RID>::INNER_MAX;
+    std::vector<int32_t> node(N);
+    for (size_t i = 0; i < N; ++i) node[i] = static_cast<int32_t>(i * 3);
+    std::mt19937 rng(7);
+    std::vector<int32_t> probes(1 << 20);
+    for (auto& p : probes) p = static_cast<int32_t>(rng() % (N * 3));
+
+    size_t sum = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int32_t p : probes) sum += std::lower_bound(node.begin(), node.end(), p) - node.begin();
+    double scalar = secs_since(t0);
+
+    size_t sum2 = 0;
+    t0 = std::chrono::steady_clock::now();
+    for (int32_t p : probes) sum2 += simd::lower_bound(node.data(), N, p);
+    double vec = secs_since(t0);
+
+    std::printf("node search (%zu keys): std::lower_bound %.1f ns, simd %.1f ns%s\n", N,
+        scalar / probes.size() * 1e9, vec / probes.size() * 1e9, sum == sum2 ? "" : "  MISMATCH");
+}
+
+int main(int argc, char** argv) {
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; ++i) sizes.push_back(std::stoul(argv[i]));
+    if (sizes.empty()) sizes.push_back(1000000);
+
+#if defined(__SSE2__)
+    std::printf("simd: %s\n", simd::has_avx2() ? "AVX2" : "SSE2");
+#else
+    std::printf("simd: %s\n", simd::has_avx2() ? "AVX2" : "scalar");
+#endif
+    kernel_bench();
+
+    size_t errors = 0;
+    std::printf("\n%12s %-22s %14s %14s\n", "keys", "tree", "insert Mops/s", "lookup Mops/s");
+    for (size_t n : sizes) {
+        std::vector<int> keys(n);
+        std::iota(keys.begin(), keys.end(), 0);
+        std::mt19937 rng(42);
+        std::shuffle(keys.begin(), keys.end(), rng);
+        std::vector<int> probes(std::min<size_t>(n, 2000000));
+        for (auto& p : probes) p = static_cast<int>(rng() % n);
+
+        auto report = [&](const char* name, Result r) {
+            std::printf("%12zu %-22s %14.2f %14.2f\n", n, name, r.insert_mops, r.lookup_mops);
+            errors += r.misses;
+        };
+        {
+            LegacyBPlusTree<RID> legacy;             // order 4, as the index used it
+            report("pointer tree (order 4)", run(legacy, keys, probes));
+        }
+        report("paged, page fanout", run_paged<0>(keys, probes));
+        report("paged, fanout 64", run_paged<64>(keys, probes));
+        report("paged, bulk load", run_paged<0>(keys, probes, true));
+        report("paged, 16-byte keys", run_bytes(keys, probes));
+    }
+    {
+        std::vector<int> keys(sizes.back());
+        std::iota(keys.begin(), keys.end(), 0);
+        errors += scaling_bench(keys);
+    }
+    size_t broken = stress_bench();
+
+    if (errors) {
+        std::fprintf(stderr, "FAILED: %zu lookups returned the wrong value\n", errors);
+        return 1;
+    }
+    if (broken) {
+        std::fprintf(stderr, "FAILED: %zu tree invariants broken under concurrent changes\n", broken);
+        return 1;
+    }
+    std::printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,134 @@
+/************************  bench/hash_bench.cpp  ************************
+ * Point-lookup latency: extendible hash table against the B+-tree, the
+ * two access methods an equality predicate can use. Each index maps the
+ * keys 0..N-1 (4-byte keys, as an INT column is indexed) to a RID; the
+ * trees are bulk loaded, the hash table is filled by inserts.
+ *
+ * Every lookup is timed on its own and the table reports the median,
+ * p99 and p99.9 in nanoseconds (clock overhead included, the same for
+ * all rows). Two pool sizes: one that holds every index page, and a
+ * tenth of that, where misses read the page back from the data file
+ * (usually from the OS page cache).
+ *
+ *   usage: hash_bench [keys]      (default: 1000000)
+ *************************************************************************/
+#include "storage/disk_manager.hpp"
+#include "storage/buffer_pool_manager.hpp"
+#include "storage/bplus_tree.hpp"
+#include "storage/extendible_hash.hpp"
+#include "storage/replacer_factory.hpp"
+#include "storage/rid.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// The INT key encoding of the byte-key indexes: big-endian, sign bit flipped
+static std::string encode(int k) {
+    uint32_t u = static_cast<uint32_t>(k) ^ 0x80000000u;
+    std::string out(4, '\0');
+    for (size_t i = 0; i < 4; ++i) out[i] = static_cast<char>(u >> (24 - 8 * i));
+    return out;
+}
+
+struct Latency { double p50, p99, p999; size_t misses; };
+
+// Times lookup(i) for every probe; lookup returns false on a wrong answer
+template <typename Lookup>
+static Latency measure(size_t probes, Lookup lookup) {
+    std::vector<uint32_t> ns(probes);
+    size_t misses = 0;
+    for (size_t i = 0; i < probes; ++i) {
+        auto t0 = std::chrono::steady_clock::now();
+        bool ok = lookup(i);
+        auto t1 = std::chrono::steady_clock::now();
+        ns[i] = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+        misses += !ok;
+    }
+    std::sort(ns.begin(), ns.end());
+    auto at = [&](double q) { return static_cast<double>(ns[std::min(probes - 1, static_cast<size_t>(q * probes))]); };
+    return { at(0.50), at(0.99), at(0.999), misses };
+}
+
+enum class Kind { INT_TREE, BYTE_TREE, HASH };
+
+// Index pages for n entries, if every page were half full
+static size_t index_pages(size_t n) { return n * (4 + sizeof(RID)) * 2 / Page::PAGE_SIZE + 64; }
+
+static Latency run(Kind kind, const std::vector<int>& probes, size_t n, bool small_pool) {
+    const char* file = "hash_bench.data";
+    std::remove(file);
+    size_t pages = index_pages(n);
+    size_t pool = small_pool ? std::max<size_t>(pages / 10, 64) : pages + 1024;
+    auto dm = make_disk_manager(file, "pread");
+    Latency r{};
+    {
+        BufferPoolManager bpm(pool, dm.get(), make_replacer("clock", pool), pool, std::chrono::milliseconds(0));
+        if (kind == Kind::INT_TREE) {
+            BPlusTree<int, RID> tree(&bpm);
+            std::vector<std::pair<int, RID>> sorted;
+            for (size_t k = 0; k < n; ++k) sorted.emplace_back(static_cast<int>(k), RID(static_cast<uint32_t>(k), 0));
+            tree.bulk_load(sorted.begin(), sorted.end());
+            r = measure(probes.size(), [&](size_t i) {
+                auto v = tree.search(probes[i]);
+                return v && v->page_id() == static_cast<uint32_t>(probes[i]);
+            });
+        } else if (kind == Kind::BYTE_TREE) {
+            BPlusTree<std::string, RID> tree(&bpm, KeyWidth{ 4 });
+            std::vector<std::pair<std::string, RID>> sorted;
+            for (size_t k = 0; k < n; ++k) sorted.emplace_back(encode(static_cast<int>(k)), RID(static_cast<uint32_t>(k), 0));
+            tree.bulk_load(sorted.begin(), sorted.end());
+            std::vector<std::string> keys;
+            for (int p : probes) keys.push_back(encode(p));
+            r = measure(probes.size(), [&](size_t i) {
+                auto v = tree.search(keys[i]);
+                return v && v->page_id() == static_cast<uint32_t>(probes[i]);
+            });
+        } else {
+            ExtendibleHash<RID> table(&bpm, KeyWidth{ 4 });
+            for (size_t k = 0; k < n; ++k) table.insert(encode(static_cast<int>(k)), RID(static_cast<uint32_t>(k), 0));
+            std::vector<std::string> keys;
+            for (int p : probes) keys.push_back(encode(p));
+            r = measure(probes.size(), [&](size_t i) {
+                auto v = table.find(keys[i]);
+                return v.size() == 1 && v[0].page_id() == static_cast<uint32_t>(probes[i]);
+            });
+        }
+    }
+    std::remove(file);
+    return r;
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    std::mt19937 rng(42);
+    std::vector<int> probes(std::min<size_t>(n * 2, 1000000));
+    for (auto& p : probes) p = static_cast<int>(rng() % n);
+
+    const std::pair<Kind, const char*> kinds[] = {
+        { Kind::INT_TREE, "B+-tree, int keys" },
+        { Kind::BYTE_TREE, "B+-tree, 4-byte keys" },
+        { Kind::HASH, "extendible hash" },
+    };
+    size_t errors = 0;
+    std::printf("%10s %-22s %-10s %9s %9s %9s\n", "keys", "index", "pool", "p50 ns", "p99 ns", "p99.9 ns");
+    for (bool small : { false, true }) {
+        for (auto [kind, name] : kinds) {
+            Latency l = run(kind, probes, n, small);
+            std::printf("%10zu %-22s %-10s %9.0f %9.0f %9.0f\n", n, name, small ? "1/10" : "all", l.p50, l.p99, l.p999);
+            errors += l.misses;
+        }
+    }
+
+    if (errors) {
+        std::fprintf(stderr, "FAILED: %zu lookups returned the wrong value\n", errors);
+        return 1;
+    }
+    std::printf("OK\n");
+    return 0;
+}
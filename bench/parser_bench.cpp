@@ -0,0 +1,212 @@
+/************************  bench/parser_bench.cpp  ************************
+ * Statements per second through QueryParser, against the std::regex
+ * parser it replaced (kept below as the reference, unchanged apart from
+ * its name). One line per kind of statement the REPL sees, plus a mix
+ * of them; each statement is parsed many times over, and both parsers
+ * must produce the same Query for it.
+ *
+ *   usage: parser_bench [iterations]      (default: 200000)
+ ****************************************************************************/
+#include "parser/query_parser.hpp"
+
+#include <chrono>
+#include <cctype>
+#include <cstdio>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/* ---------- the regex parser, for reference ---------- */
+
+namespace regex_parser {
+
+static inline void trim(std::string& s) {
+    while (!s.empty() && std::isspace(s.front())) s.erase(s.begin());
+    while (!s.empty() && std::isspace(s.back()))  s.pop_back();
+}
+
+static inline std::string unquote(std::string v) {
+    if (v.size() >= 2 && v.front() == '\'') v = v.substr(1, v.size() - 2);
+    return v;
+}
+
+// Range condition after WHERE: col op value, or col BETWEEN lo AND hi
+static bool parse_range(const std::string& cond, Range& r) {
+    static const std::regex rg_cmp(R"((\w+)\s*(<=|>=|<|>)\s*('?-?\w+'?))");
+    static const std::regex rg_between(R"((\w+)\s+BETWEEN\s+('?-?\w+'?)\s+AND\s+('?-?\w+'?))", std::regex::icase);
+    std::smatch m;
+    if (std::regex_match(cond, m, rg_between)) {
+        r.col = m[1];
+        r.lo = unquote(m[2]);
+        r.hi = unquote(m[3]);
+        return true;
+    }
+    if (std::regex_match(cond, m, rg_cmp)) {
+        r.col = m[1];
+        std::string op = m[2];
+        if (op[0] == '<') { r.hi = unquote(m[3]); r.hi_incl = op.size() == 2; }
+        else              { r.lo = unquote(m[3]); r.lo_incl = op.size() == 2; }
+        return true;
+    }
+    return false;
+}
+
+// Select list ("*" or comma-separated names) and the LIMIT count, if any
+static SelectOutput parse_output(const std::string& list, const std::ssub_match& limit) {
+    SelectOutput out;
+    if (list != "*") {
+        std::stringstream ss(list); std::string col;
+        while (std::getline(ss, col, ',')) {
+            trim(col);
+            out.columns.push_back(col);
+        }
+    }
+    if (limit.matched) out.limit = std::stoull(limit.str());
+    return out;
+}
+
+static ColumnType parse_type(const std::string& t, std::size_t& charLen) {
+    if (t == "int" || t == "INT") return ColumnType::INT;
+    std::smatch m;
+    std::regex rg(R"(CHAR\s*\(\s*(\d+)\s*\))", std::regex::icase);
+    if (std::regex_match(t, m, rg)) { charLen = std::stoul(m[1]); return ColumnType::CHAR; }
+    throw std::runtime_error("bad type");
+}
+
+std::optional<Query> parse(const std::string& in) {
+    std::string s = in; trim(s);
+
+    /* CREATE TABLE */
+    {
+        std::regex rg(R"(CREATE\s+TABLE\s+(\w+)\s*\((.+)\)\s*;?)", std::regex::icase);
+        std::smatch m;
+        if (std::regex_match(s, m, rg)) {
+            CreateTable q; q.table = m[1];
+            std::string cols = m[2];
+            std::stringstream ss(cols); std::string col;
+            while (std::getline(ss, col, ',')) {
+                trim(col);
+                auto pos = col.find(' ');
+                std::string name = col.substr(0, pos);
+                std::string typ = col.substr(pos + 1);
+                trim(typ);
+                std::size_t clen = 0;
+                ColumnType ct = parse_type(typ, clen);
+                q.columns.push_back({ name,ct,clen });
+            }
+            return q;
+        }
+    }
+    /* CREATE INDEX */
+    {
+        std::regex rg(R"(CREATE\s+INDEX\s+(\w+)\s+ON\s+(\w+)\s*\(\s*(\w+)\s*\)\s*(?:USING\s+(HASH|BTREE)\s*)?;?)",
+                      std::regex::icase);
+        std::smatch m;
+        if (std::regex_match(s, m, rg))
+            return CreateIndex{ m[1], m[2], m[3], m[4].matched && std::toupper(m.str(4)[0]) == 'H' };
+    }
+    /* INSERT */
+    {
+        std::regex rg(R"(INSERT\s+INTO\s+(\w+)\s+VALUES\s*\((.+)\)\s*;?)", std::regex::icase);
+        std::smatch m;
+        if (std::regex_match(s, m, rg)) {
+            Insert q; q.table = m[1];
+            std::string vals = m[2];
+            std::stringstream ss(vals); std::string tok;
+            while (std::getline(ss, tok, ',')) {
+                trim(tok);
+                if (tok.front() == '\'') tok = tok.substr(1, tok.size() - 2);
+                q.values.push_back(tok);
+            }
+            return q;
+        }
+    }
+    /* SELECT <* | col, ...> FROM t [WHERE ...] [LIMIT n] */
+    {
+        std::regex rg1(R"(SELECT\s+(\*|\w+(?:\s*,\s*\w+)*)\s+FROM\s+(\w+)(?:\s+LIMIT\s+(\d+))?\s*;?)", std::regex::icase);
+        std::regex rg2(R"(SELECT\s+(\*|\w+(?:\s*,\s*\w+)*)\s+FROM\s+(\w+)\s+WHERE\s+(\w+)\s*=\s*('?[\w\d]+'?)(?:\s+LIMIT\s+(\d+))?\s*;?)", std::regex::icase);
+        std::smatch m;
+        if (std::regex_match(s, m, rg2)) {
+            SelectWhere q{ m[2],m[3],m[4], parse_output(m[1], m[5]) };
+            if (q.value.front() == '\'') q.value = q.value.substr(1, q.value.size() - 2);
+            return q;
+        }
+        if (std::regex_match(s, m, rg1)) {
+            return SelectAll{ m[2], parse_output(m[1], m[3]) };
+        }
+        std::regex rg3(R"(SELECT\s+(\*|\w+(?:\s*,\s*\w+)*)\s+FROM\s+(\w+)\s+WHERE\s+(.+?)(?:\s+LIMIT\s+(\d+))?\s*;?)", std::regex::icase);
+        SelectRange q;
+        if (std::regex_match(s, m, rg3) && parse_range(m[3], q.range)) {
+            q.table = m[2];
+            q.output = parse_output(m[1], m[4]);
+            return q;
+        }
+    }
+    /* DELETE */
+    {
+        std::regex rg(R"(DELETE\s+FROM\s+(\w+)\s+WHERE\s+(\w+)\s*=\s*('?[\w\d]+'?)\s*;?)", std::regex::icase);
+        std::smatch m;
+        if (std::regex_match(s, m, rg)) {
+            DeleteWhere q{ m[1],m[2],m[3] };
+            if (q.value.front() == '\'') q.value = q.value.substr(1, q.value.size() - 2);
+            return q;
+        }
+        std::regex rg2(R"(DELETE\s+FROM\s+(\w+)\s+WHERE\s+(.+?)\s*;?)", std::regex::icase);
+        DeleteRange q;
+        if (std::regex_match(s, m, rg2) && parse_range(m[2], q.range)) {
+            q.table = m[1];
+            return q;
+        }
+    }
+    return std::nullopt;          // parse error
+}
+
+} // namespace regex_parser
+
+/* ---------- timing ---------- */
+
+template <typename Parse>
+static double stmts_per_s(const std::vector<std::string>& stmts, size_t iterations, Parse parse) {
+    size_t parsed = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) parsed += parse(stmts[i % stmts.size()]).has_value();
+    auto t1 = std::chrono::steady_clock::now();
+    if (parsed != iterations) std::fprintf(stderr, "  %zu of %zu did not parse\n", iterations - parsed, iterations);
+    return iterations / std::chrono::duration<double>(t1 - t0).count();
+}
+
+int main(int argc, char** argv) {
+    size_t iterations = argc > 1 ? std::stoul(argv[1]) : 200000;
+
+    const std::pair<const char*, std::vector<std::string>> kinds[] = {
+        { "point select", { "SELECT * FROM users WHERE id = 4711;" } },
+        { "range select", { "SELECT id, name FROM users WHERE age BETWEEN 20 AND 30 LIMIT 10;" } },
+        { "insert", { "INSERT INTO users VALUES (4711, 'alice', 34, 'NYC');" } },
+        { "delete", { "DELETE FROM users WHERE age < 18;" } },
+        { "create table", { "CREATE TABLE users (id INT, name CHAR(20), age INT, city CHAR(16));" } },
+    };
+    std::vector<std::string> mix;
+    for (const auto& [name, stmts] : kinds) mix.insert(mix.end(), stmts.begin(), stmts.end());
+
+    size_t mismatches = 0;
+    for (const auto& s : mix)
+        if (regex_parser::parse(s) != QueryParser::parse(s)) ++mismatches;
+
+    auto row = [&](const char* name, const std::vector<std::string>& stmts) {
+        size_t regex_iters = iterations / 500 + 1;     // the regex parser is far slower
+        double before = stmts_per_s(stmts, regex_iters, regex_parser::parse);
+        double after = stmts_per_s(stmts, iterations, [](const std::string& s) { return QueryParser::parse(s); });
+        std::printf("%-14s %14.0f %14.0f %8.1fx\n", name, before, after, after / before);
+    };
+    std::printf("%-14s %14s %14s %9s\n", "statement", "regex stmt/s", "lexer stmt/s", "speedup");
+    for (const auto& [name, stmts] : kinds) row(name, stmts);
+    row("mix", mix);
+
+    if (mismatches) {
+        std::fprintf(stderr, "FAILED: %zu statements parsed differently\n", mismatches);
+        return 1;
+    }
+    std::printf("OK\n");
+    return 0;
+}
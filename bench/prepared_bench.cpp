@@ -0,0 +1,107 @@
+/**********************  bench/prepared_bench.cpp  ***********************
+ * Statements per second through the executor: ad hoc text against
+ * prepared statements.
+ *
+ *   ad hoc    the text parsed and planned, then executed, every time
+ *   cached    the text through QueryExecutor::prepare, which finds it in
+ *             the plan cache (each was PREPAREd once: text without
+ *             parameters is not cached otherwise), so it is neither
+ *             parsed nor planned
+ *   bound     one prepared statement, the values bound with bind();
+ *             an INSERT's typed values go straight to the row encoder
+ *
+ * for point SELECTs on the primary key of a table of `rows` rows (256
+ * distinct keys, the same on every path), and for INSERTs into a second
+ * table (no cached row: each INSERT text is new). There is no log, so
+ * the figures are the statement path alone, without a commit's fsync.
+ * The bound SELECTs are checked against the ad hoc ones.
+ *
+ *   usage: prepared_bench [rows]      (default: 100000)
+ ************************************************************************/
+#include "storage/disk_manager.hpp"
+#include "storage/buffer_pool_manager.hpp"
+#include "storage/replacer_factory.hpp"
+#include "storage/catalog.hpp"
+#include "parser/query_parser.hpp"
+#include "execution/query_executor.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static const char* DATA = "prepared_bench.data";
+static constexpr size_t POOL = 8192;
+
+template <typename F>
+static double stmts_per_s(size_t n, F f) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; ++i) f(i);
+    auto t1 = std::chrono::steady_clock::now();
+    return n / std::chrono::duration<double>(t1 - t0).count();
+}
+
+static void print(const char* stmt, const char* how, double rate) {
+    std::printf("%-14s %-8s %12.0f\n", stmt, how, rate);
+}
+
+int main(int argc, char** argv) {
+    size_t rows = argc > 1 ? std::stoul(argv[1]) : 100000;
+    std::remove(DATA);
+
+    size_t errors = 0;
+    {
+        auto dm = make_disk_manager(DATA, "pread");
+        BufferPoolManager bpm(POOL, dm.get(), make_replacer("clock", POOL));
+        Catalog catalog(&bpm);
+        QueryExecutor exec(&catalog);
+        auto run = [&](const std::string& sql) { return exec.execute(*QueryParser::parse(sql)).value_or(""); };
+
+        run("CREATE TABLE t (id INT, name CHAR(16), v INT);");
+        run("CREATE TABLE u (id INT, name CHAR(16), v INT);");
+        Statement fill = exec.prepare("INSERT INTO t VALUES ($1, $2, $3);");
+        for (size_t i = 0; i < rows; ++i) {
+            int id = static_cast<int>(i);
+            fill.bind(1, id).bind(2, "name" + std::to_string(i % 1000)).bind(3, id % 100).execute();
+        }
+
+        std::printf("%-14s %-8s %12s\n", "statement", "path", "stmts/s");
+        // The same 256 keys on every path, so each touches the same pages
+        auto key = [&](size_t i) { return static_cast<int>(((i % 256) * 7919) % rows); };
+        std::vector<std::string> texts;
+        for (size_t i = 0; i < 256; ++i) texts.push_back("SELECT * FROM t WHERE id = " + std::to_string(key(i)) + ";");
+
+        /* point SELECT */
+        print("point select", "ad hoc", stmts_per_s(rows, [&](size_t i) { run(texts[i % 256]); }));
+        for (size_t i = 0; i < 256; ++i) run("PREPARE q" + std::to_string(i) + " AS " + texts[i]);
+        print("point select", "cached", stmts_per_s(rows, [&](size_t i) { exec.prepare(texts[i % 256]).execute(); }));
+        Statement sel = exec.prepare("SELECT * FROM t WHERE id = $1;");
+        print("point select", "bound", stmts_per_s(rows, [&](size_t i) { sel.bind(1, key(i)).execute(); }));
+        for (size_t i = 0; i < 1000; ++i) {
+            std::string want = run(texts[i % 256]);
+            errors += sel.bind(1, key(i)).execute().value_or("") != want || want == "NOT FOUND\n";
+        }
+
+        /* INSERT */
+        print("insert", "ad hoc", stmts_per_s(rows, [&](size_t i) {
+            run("INSERT INTO u VALUES (" + std::to_string(i) + ", 'name" + std::to_string(i % 1000) + "', " +
+                std::to_string(i % 100) + ");");
+        }));
+        Statement ins = exec.prepare("INSERT INTO u VALUES ($1, $2, $3);");
+        std::vector<std::string> names;
+        for (size_t i = 0; i < 1000; ++i) names.push_back("name" + std::to_string(i));
+        print("insert", "bound", stmts_per_s(rows, [&](size_t i) {
+            int id = static_cast<int>(rows + i);
+            errors += ins.bind(1, id).bind(2, names[i % 1000]).bind(3, id % 100).execute() != "Inserted 1\n";
+        }));
+        errors += catalog.get("u").heap->row_count() != 2 * rows;
+    }
+    std::remove(DATA);
+
+    if (errors) {
+        std::fprintf(stderr, "FAILED: %zu statements gave the wrong result\n", errors);
+        return 1;
+    }
+    std::printf("OK\n");
+    return 0;
+}
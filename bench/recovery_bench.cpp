@@ -0,0 +1,281 @@
+/**********************  bench/recovery_bench.cpp  **********************
+ * Restart time against the log written since the last checkpoint, for a
+ * small and a large database.
+ *
+ * A child process loads `db rows` rows (~100 bytes, 1000 per commit),
+ * flushes the pool and takes a checkpoint. It then commits `since ckpt`
+ * more rows (100 per commit), leaves one 100-row transaction uncommitted
+ * with its records on disk, and dies without flushing anything else.
+ * The parent drops both files from the OS cache, then times opening the
+ * log and the pool and running RecoveryManager::recover(): analysis,
+ * redo, undo of the loser and the final checkpoint. Afterwards it checks
+ * that exactly the committed rows are in the heap.
+ *
+ * Restart time should follow the log since the checkpoint and stay flat
+ * as the database grows.
+ *
+ * Then a churn check: a child fills a table, deletes every row and puts
+ * as many new ones back, a few rounds over, and crashes. The table must
+ * not have grown past its first fill plus a page (deleted space is
+ * compacted and reused), and after recovery exactly the last round's rows
+ * must be there.
+ *
+ *   usage: recovery_bench [db_rows...] -- [rows_since_checkpoint...]
+ *          (default: 20000 200000 -- 0 5000 20000 80000)
+ ************************************************************************/
+#include "storage/disk_manager.hpp"
+#include "storage/buffer_pool_manager.hpp"
+#include "storage/replacer_factory.hpp"
+#include "storage/table_heap.hpp"
+#include "recovery/log_manager.hpp"
+#include "recovery/recovery_manager.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static const char* DATA = "recovery_bench.data";
+static const char* LOG = "recovery_bench.log";
+static constexpr size_t POOL = 1024;
+
+static double ms_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Push the file out of the OS page cache
+static void drop_cache(const char* file) {
+    int fd = ::open(file, O_RDONLY);
+    if (fd < 0) return;
+    ::fdatasync(fd);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+}
+
+static void insert_rows(TableHeap& heap, LogManager& log, size_t first, size_t count, size_t per_commit, bool commit) {
+    for (size_t done = 0; done < count;) {
+        Txn txn = log.begin();
+        for (size_t i = 0; i < per_commit && done < count; ++i, ++done) {
+            char row[100];
+            std::snprintf(row, sizeof row, "row %zu", first + done);
+            RID rid;
+            heap.insert_tuple(Tuple(std::string(row, sizeof row)), rid, &txn);
+        }
+        if (commit) log.commit(txn);
+    }
+}
+
+// Child: build the database, checkpoint, keep going, then crash. Sends
+// the heap's first page id and free-space map root through fd.
+[[noreturn]] static void crash_after(size_t db_rows, size_t since, int fd) {
+    auto dm = make_disk_manager(DATA, "pread");
+    auto* log = new LogManager(LOG);
+    auto* bpm = new BufferPoolManager(POOL, dm.get(), make_replacer("clock", POOL));
+    bpm->set_log_manager(log);
+    auto* recovery = new RecoveryManager(bpm, log);
+    recovery->recover();
+    auto* heap = new TableHeap(bpm, log);
+
+    insert_rows(*heap, *log, 0, db_rows, 1000, true);
+    bpm->flush_all_pages();
+    recovery->checkpoint();
+
+    insert_rows(*heap, *log, db_rows, since, 100, true);
+    insert_rows(*heap, *log, db_rows + since, 100, 100, false);   // the loser
+    log->flush_all();
+
+    uint32_t ids[2] = { heap->first_page(), heap->fsm_root() };
+    if (::write(fd, ids, sizeof ids) != sizeof ids) _exit(1);
+    _exit(0);                     // no destructors: nothing else is flushed
+}
+
+static constexpr size_t CHURN_ROWS = 2000;
+static constexpr size_t CHURN_ROUNDS = 5;
+
+static void churn_row(char (&row)[100], size_t round, size_t i) {
+    std::memset(row, 0, sizeof row);
+    std::snprintf(row, sizeof row, "round %zu row %zu", round, i);
+}
+
+// Child: fill, then delete everything and refill CHURN_ROUNDS times, then
+// crash. Sends the first page id, the page counts after the first fill
+// and after the last round, and the free-space map root through fd.
+[[noreturn]] static void churn_then_crash(int fd) {
+    auto dm = make_disk_manager(DATA, "pread");
+    auto* log = new LogManager(LOG);
+    auto* bpm = new BufferPoolManager(POOL, dm.get(), make_replacer("clock", POOL));
+    bpm->set_log_manager(log);
+    auto* recovery = new RecoveryManager(bpm, log);
+    recovery->recover();
+    auto* heap = new TableHeap(bpm, log);
+
+    std::vector<RID> rids(CHURN_ROWS);
+    uint32_t out[4] = { heap->first_page(), 0, 0, heap->fsm_root() };
+    for (size_t round = 0; round <= CHURN_ROUNDS; ++round) {
+        if (round > 0) {
+            Txn txn = log->begin();
+            for (const RID& rid : rids) heap->delete_tuple(rid, &txn);
+            log->commit(txn);
+        }
+        Txn txn = log->begin();
+        for (size_t i = 0; i < CHURN_ROWS; ++i) {
+            char row[100];
+            churn_row(row, round, i);
+            heap->insert_tuple(Tuple(std::string(row, sizeof row)), rids[i], &txn);
+        }
+        log->commit(txn);
+        if (round == 0) out[1] = static_cast<uint32_t>(heap->chain_pages(0, SIZE_MAX).size());
+    }
+    out[2] = static_cast<uint32_t>(heap->chain_pages(0, SIZE_MAX).size());
+    log->flush_all();
+    if (::write(fd, out, sizeof out) != sizeof out) _exit(1);
+    _exit(0);
+}
+
+static bool churn_check() {
+    std::remove(DATA);
+    std::remove(LOG);
+    int fds[2];
+    if (::pipe(fds) != 0) return false;
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        ::close(fds[0]);
+        churn_then_crash(fds[1]);
+    }
+    ::close(fds[1]);
+    uint32_t got[4] = {};
+    bool read_all = ::read(fds[0], got, sizeof got) == sizeof got;
+    ::close(fds[0]);
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    if (!read_all || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        std::fprintf(stderr, "FAILED: churn child did not get to the crash\n");
+        return false;
+    }
+
+    bool ok = true;
+    std::printf("churn: %u pages after the first fill, %u after %zu rounds\n", got[1], got[2], CHURN_ROUNDS);
+    if (got[2] > got[1] + 1) {
+        std::fprintf(stderr, "FAILED: churn grew the table from %u to %u pages\n", got[1], got[2]);
+        ok = false;
+    }
+
+    auto dm = make_disk_manager(DATA, "pread");
+    LogManager log(LOG);
+    BufferPoolManager bpm(POOL, dm.get(), make_replacer("clock", POOL));
+    bpm.set_log_manager(&log);
+    RecoveryManager recovery(&bpm, &log);
+    recovery.recover();
+
+    // Reopening fills the old free-space map again instead of a new one
+    uint32_t pages = bpm.next_page_id();
+    TableHeap heap(&bpm, &log, got[0], got[3]);
+    if (bpm.next_page_id() != pages) {
+        std::fprintf(stderr, "FAILED: reopening after the crash allocated %u pages\n", bpm.next_page_id() - pages);
+        ok = false;
+    }
+    std::vector<bool> seen(CHURN_ROWS);
+    size_t rows = 0, wrong = 0;
+    auto it = heap.scan();
+    Tuple t;
+    RID rid;
+    while (it.next(t, rid)) {
+        ++rows;
+        size_t round = 0, i = 0;
+        char row[100];
+        if (std::sscanf(reinterpret_cast<const char*>(t.data()), "round %zu row %zu", &round, &i) != 2 || round != CHURN_ROUNDS ||
+            i >= CHURN_ROWS || seen[i]) {
+            ++wrong;
+            continue;
+        }
+        churn_row(row, round, i);
+        if (t.size() != sizeof row || std::memcmp(t.data(), row, sizeof row) != 0) ++wrong;
+        seen[i] = true;
+    }
+    if (rows != CHURN_ROWS || wrong) {
+        std::fprintf(stderr, "FAILED: %zu rows after churn and recovery (%zu wrong), expected %zu\n",
+            rows, wrong, CHURN_ROWS);
+        ok = false;
+    }
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    std::vector<size_t> db_sizes, sinces;
+    bool after = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--") == 0) after = true;
+        else (after ? sinces : db_sizes).push_back(std::stoul(argv[i]));
+    }
+    if (db_sizes.empty()) db_sizes = { 20000, 200000 };
+    if (sinces.empty()) sinces = { 0, 5000, 20000, 80000 };
+
+    bool ok = true;
+    std::printf("%10s %11s %12s %8s %7s %11s\n", "db rows", "since ckpt", "log read MB", "redone", "undone", "restart ms");
+    for (size_t db_rows : db_sizes) {
+        for (size_t since : sinces) {
+            std::remove(DATA);
+            std::remove(LOG);
+            int fds[2];
+            if (::pipe(fds) != 0) return 1;
+            pid_t pid = ::fork();
+            if (pid == 0) {
+                ::close(fds[0]);
+                crash_after(db_rows, since, fds[1]);
+            }
+            ::close(fds[1]);
+            uint32_t ids[2] = {};
+            bool got = ::read(fds[0], ids, sizeof ids) == sizeof ids;
+            ::close(fds[0]);
+            int status = 0;
+            ::waitpid(pid, &status, 0);
+            if (!got || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                std::fprintf(stderr, "FAILED: child did not get to the crash\n");
+                return 1;
+            }
+            drop_cache(DATA);
+            drop_cache(LOG);
+
+            size_t rows = 0;
+            {
+                auto t0 = std::chrono::steady_clock::now();
+                auto dm = make_disk_manager(DATA, "pread");
+                LogManager log(LOG);
+                BufferPoolManager bpm(POOL, dm.get(), make_replacer("clock", POOL));
+                bpm.set_log_manager(&log);
+                RecoveryManager recovery(&bpm, &log);
+                RecoveryManager::Stats stats = recovery.recover();
+                double ms = ms_since(t0);
+
+                uint32_t pages = bpm.next_page_id();
+                TableHeap heap(&bpm, &log, ids[0], ids[1]);
+                if (bpm.next_page_id() != pages) {
+                    std::fprintf(stderr, "FAILED: reopening after the crash allocated %u pages\n", bpm.next_page_id() - pages);
+                    ok = false;
+                }
+                auto it = heap.scan();
+                Tuple t;
+                RID rid;
+                while (it.next(t, rid)) ++rows;
+                std::printf("%10zu %11zu %12.1f %8zu %7zu %11.1f\n", db_rows, since,
+                    stats.log_bytes / 1048576.0, stats.redone, stats.undone, ms);
+            }
+            if (rows != db_rows + since) {
+                std::fprintf(stderr, "FAILED: %zu rows after recovery, expected %zu\n", rows, db_rows + since);
+                ok = false;
+            }
+        }
+    }
+    if (!churn_check()) ok = false;
+    std::remove(DATA);
+    std::remove(LOG);
+
+    if (!ok) return 1;
+    std::printf("OK\n");
+    return 0;
+}
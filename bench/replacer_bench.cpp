@@ -0,0 +1,136 @@
+/************************  bench/replacer_bench.cpp  ************************
+ * Hit ratios of the buffer-pool replacement policies on a mixed trace.
+ *
+ * The trace interleaves bursts of point lookups over a small hot set
+ * (think index / lookup pages, sized to fit in the pool) with sequential
+ * scans over a table several times larger than the pool. A scan-resistant
+ * policy keeps the hot set resident across scans.
+ *
+ * Each policy is then checked for a race the pool has to live with: a
+ * victim() whose frame is pinned again before the pool re-checks it. The
+ * replacer must end up as if the page had simply been fetched once more,
+ * so its later victims come in the same order as in a replay without the
+ * race.
+ *
+ *   usage: replacer_bench [pool_frames] [rounds]
+ ****************************************************************************/
+#include "storage/disk_manager.hpp"
+#include "storage/buffer_pool_manager.hpp"
+#include "storage/replacer_factory.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Frame f holds page f throughout. `plain` sees fetches only; `raced`
+// sees some of them right after victim() picked the frame, as when the
+// pool's re-check finds it pinned and keeps the page. Afterwards both
+// must give up their frames in the same order.
+static bool victim_race(const char* policy, size_t pool) {
+    auto plain = make_replacer(policy, pool), raced = make_replacer(policy, pool);
+    auto fetch = [](Replacer& r, size_t f) {
+        r.erase(f);
+        r.record_access(f, static_cast<uint32_t>(f));
+        r.insert(f);
+    };
+    for (size_t f = 0; f < pool; ++f) {
+        plain->record_access(f, static_cast<uint32_t>(f));
+        plain->insert(f);
+        raced->record_access(f, static_cast<uint32_t>(f));
+        raced->insert(f);
+    }
+    std::mt19937 rng(9);
+    for (size_t i = 0; i < pool * 8; ++i) {
+        size_t f = rng() % pool;
+        if (i % 4 == 0 && !raced->victim(f)) return false;
+        fetch(*plain, f);
+        fetch(*raced, f);
+    }
+    size_t a, b;
+    while (plain->victim(a)) {
+        if (!raced->victim(b) || a != b) return false;
+        plain->forget(a);
+        raced->forget(b);
+    }
+    return !raced->victim(b);
+}
+
+int main(int argc, char** argv) {
+    size_t pool = argc > 1 ? std::stoul(argv[1]) : 256;
+    size_t rounds = argc > 2 ? std::stoul(argv[2]) : 50;
+
+    const size_t hot_pages = pool * 3 / 4;
+    const size_t table_pages = pool * 16;
+    const size_t lookups_per_round = pool * 8;
+    const size_t scan_per_round = pool * 4;
+
+    // Build the trace once so every policy replays the same accesses
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<size_t> hot_pick(0, hot_pages - 1);
+    std::vector<uint32_t> trace;
+    std::vector<bool> is_lookup;
+    size_t scan_pos = 0;
+    for (size_t r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < lookups_per_round; ++i) {
+            trace.push_back(static_cast<uint32_t>(hot_pick(rng)));
+            is_lookup.push_back(true);
+        }
+        for (size_t i = 0; i < scan_per_round; ++i) {
+            trace.push_back(static_cast<uint32_t>(hot_pages + scan_pos));
+            is_lookup.push_back(false);
+            scan_pos = (scan_pos + 1) % table_pages;
+        }
+    }
+
+    std::printf("pool=%zu hot=%zu table=%zu accesses=%zu\n",
+        pool, hot_pages, table_pages, trace.size());
+    std::printf("%-8s %12s %12s %12s\n", "policy", "hit ratio", "lookup hits", "ns/access");
+
+    for (const char* policy : { "lru", "clock", "lru-k", "2q" }) {
+        const char* file = "replacer_bench.data";
+        std::remove(file);
+        DiskManager dm(file);
+        BufferPoolManager bpm(pool, &dm, make_replacer(policy, pool), 0,
+            std::chrono::milliseconds(0));
+
+        // Materialize every page once so misses read real data
+        for (size_t i = 0; i < hot_pages + table_pages; ++i) {
+            uint32_t pid;
+            bpm.new_page(pid);
+            bpm.unpin_page(pid, true);
+        }
+        bpm.flush_all_pages();
+
+        size_t lookups = 0, lookup_hits = 0;
+        size_t base_hits = bpm.hits(), base_misses = bpm.misses();
+        auto t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < trace.size(); ++i) {
+            size_t before = bpm.hits();
+            bpm.fetch_page(trace[i]);
+            bpm.unpin_page(trace[i], false);
+            if (is_lookup[i]) {
+                ++lookups;
+                lookup_hits += bpm.hits() - before;
+            }
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+
+        size_t hits = bpm.hits() - base_hits, misses = bpm.misses() - base_misses;
+        std::printf("%-8s %11.1f%% %11.1f%% %12.0f\n", policy,
+            100.0 * hits / (hits + misses), 100.0 * lookup_hits / lookups, ns / trace.size());
+    }
+
+    // CLOCK is left out: its hand sweeps on every victim() by design
+    bool ok = true;
+    for (const char* policy : { "lru", "lru-k", "2q" }) {
+        if (victim_race(policy, pool)) continue;
+        std::fprintf(stderr, "FAILED: %s victim order changed by a victim() kept after all\n", policy);
+        ok = false;
+    }
+    if (!ok) return 1;
+    std::printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,214 @@
+/************************  bench/scan_bench.cpp  ************************
+ * Open + full sequential scan of a warm data file through a small pool,
+ * per I/O mode.
+ *
+ * The file is written once (and is therefore in the page cache). Each
+ * mode then opens it with a 32-frame pool, scans every page twice, and
+ * checks the page-id stamp of each page. Over mmap the pool hands out
+ * pointers into the mapping, so a scan copies nothing.
+ *
+ * A second pass measures TableHeap scans with a cold OS cache. Two tables
+ * are filled in turn so that their page chains interleave on disk. Each
+ * table is then walked twice: page by page with plain fetch_page, and
+ * with TableIterator, which reads ahead along the chain.
+ *
+ * A third pass scans a table the pool holds entirely, reading an INT at
+ * the start of each row: copied out into a Tuple, and in place through a
+ * TupleView. It counts heap allocations per row (operator new is counted
+ * in this program; the pool uses CLOCK, whose bookkeeping allocates
+ * nothing, so what is left is per page).
+ *
+ *   usage: scan_bench [pages] [modes...]   (default: pread uring mmap)
+ ************************************************************************/
+#include "storage/disk_manager.hpp"
+#include "storage/buffer_pool_manager.hpp"
+#include "storage/replacer_factory.hpp"
+#include "storage/table_heap.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+static std::atomic<size_t> allocations{ 0 };
+
+void* operator new(size_t n) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+static double ms_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Push the file out of the OS page cache
+static void drop_cache(const char* file) {
+    int fd = ::open(file, O_RDONLY);
+    if (fd < 0) return;
+    ::fdatasync(fd);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+}
+
+// Cold scans of one of two interleaved tables, without and with readahead
+static size_t heap_scans(const std::string& mode, size_t pages) {
+    const char* file = "scan_bench.heap";
+    std::remove(file);
+    auto dm = make_disk_manager(file, mode);
+    BufferPoolManager bpm(256, dm.get());
+    TableHeap a(&bpm), b(&bpm);
+
+    const Tuple row(std::string(400, 'x'));
+    RID rid;
+    size_t rows = 0;
+    while (a.chain_pages(0, SIZE_MAX).size() < pages) {
+        for (int i = 0; i < 40; ++i) { a.insert_tuple(row, rid); b.insert_tuple(row, rid); }
+        rows += 40;
+    }
+    std::vector<uint32_t> chain = a.chain_pages(0, SIZE_MAX);
+
+    // Evict table a from the pool (b is scanned last) and from the OS cache
+    auto make_cold = [&] {
+        bpm.flush_all_pages();
+        Tuple t;
+        for (auto it = b.scan(); it.next(t, rid);) {}
+        drop_cache(file);
+    };
+
+    size_t errors = 0;
+    make_cold();
+    auto t0 = std::chrono::steady_clock::now();
+    size_t seen = 0;
+    for (uint32_t pid : chain) {
+        Page* p = bpm.fetch_page(pid);
+        seen += p->get_page_id() == pid;
+        bpm.unpin_page(pid, false);
+    }
+    double plain_ms = ms_since(t0);
+    if (seen != chain.size()) ++errors;
+
+    make_cold();
+    size_t prefetched = bpm.prefetches();
+    t0 = std::chrono::steady_clock::now();
+    Tuple t;
+    size_t n = 0;
+    for (auto it = a.scan(); it.next(t, rid);) ++n;
+    double ra_ms = ms_since(t0);
+    if (n != rows) ++errors;
+
+    std::printf("%-14s %10zu %12.2f %12.2f %12zu\n", dm->backend_name(), chain.size(),
+        plain_ms, ra_ms, bpm.prefetches() - prefetched);
+    std::remove(file);
+    return errors;
+}
+
+// Warm scans: copy every row out, or read it where it is
+static size_t warm_scans(size_t rows) {
+    const char* file = "scan_bench.heap";
+    std::remove(file);
+    auto dm = make_disk_manager(file, "pread");
+    size_t frames = rows * 104 / Page::PAGE_SIZE + 64;
+    BufferPoolManager bpm(frames, dm.get(), make_replacer("clock", frames));
+    TableHeap heap(&bpm);
+
+    std::string row(100, 'x');
+    RID rid;
+    for (size_t i = 0; i < rows; ++i) {
+        int v = static_cast<int>(i);
+        std::memcpy(row.data(), &v, sizeof v);
+        heap.insert_tuple(Tuple(row), rid);
+    }
+    long long want = static_cast<long long>(rows) * (rows - 1) / 2;
+
+    size_t errors = 0;
+    for (int pass = 0; pass < 2; ++pass) {
+        bool view = pass == 1;
+        long long sum = 0;
+        size_t allocs = allocations.load();
+        auto t0 = std::chrono::steady_clock::now();
+        auto it = heap.scan();
+        int v;
+        if (view) {
+            for (TupleView t; it.next(t, rid);) { std::memcpy(&v, t.data(), sizeof v); sum += v; }
+        } else {
+            for (Tuple t; it.next(t, rid);) { std::memcpy(&v, t.data(), sizeof v); sum += v; }
+        }
+        double ms = ms_since(t0);
+        double per_row = double(allocations.load() - allocs) / rows;
+        std::printf("%-14s %10zu %12.2f %12.1f %12.2f\n", view ? "TupleView" : "Tuple copy", rows, ms,
+            rows / ms / 1000.0, per_row);
+        if (sum != want) ++errors;
+    }
+    std::remove(file);
+    return errors;
+}
+
+int main(int argc, char** argv) {
+    size_t pages = argc > 1 ? std::stoul(argv[1]) : 32768;
+    std::vector<std::string> modes;
+    for (int i = 2; i < argc; ++i) modes.push_back(argv[i]);
+    if (modes.empty()) modes = { "pread", "uring", "mmap" };
+
+    const char* file = "scan_bench.data";
+    std::remove(file);
+    {
+        auto dm = make_disk_manager(file, "pread");
+        BufferPoolManager bpm(256, dm.get());
+        for (size_t i = 0; i < pages; ++i) {
+            uint32_t pid;
+            Page* p = bpm.new_page(pid);
+            p->write_content(reinterpret_cast<const std::byte*>(&pid), 0, sizeof(pid));
+            bpm.unpin_page(pid, true);
+        }
+    }
+
+    size_t errors = 0;
+    std::printf("pages=%zu (%zu MB), pool=32\n", pages, pages * Page::PAGE_SIZE >> 20);
+    std::printf("%-14s %10s %12s %12s\n", "io", "open ms", "scan1 ms", "scan2 ms");
+    for (const std::string& mode : modes) {
+        auto t0 = std::chrono::steady_clock::now();
+        auto dm = make_disk_manager(file, mode);
+        BufferPoolManager bpm(32, dm.get());
+        double open_ms = ms_since(t0);
+
+        double scan_ms[2];
+        for (double& ms : scan_ms) {
+            t0 = std::chrono::steady_clock::now();
+            for (uint32_t pid = 0; pid < pages; ++pid) {
+                Page* p = bpm.fetch_page(pid);
+                uint32_t stamp;
+                p->read_content(reinterpret_cast<std::byte*>(&stamp), 0, sizeof(stamp));
+                if (stamp != pid) ++errors;
+                bpm.unpin_page(pid, false);
+            }
+            ms = ms_since(t0);
+        }
+        std::printf("%-14s %10.2f %12.2f %12.2f\n", dm->backend_name(), open_ms, scan_ms[0], scan_ms[1]);
+    }
+    std::remove(file);
+
+    size_t heap_pages = std::min<size_t>(pages, 4096);
+    std::printf("\ncold heap scan, two interleaved tables, pool=256\n");
+    std::printf("%-14s %10s %12s %12s %12s\n", "io", "pages", "fetch ms", "readahead ms", "async reads");
+    for (const std::string& mode : modes) errors += heap_scans(mode, heap_pages);
+
+    std::printf("\nwarm heap scan, whole table in the pool\n");
+    std::printf("%-14s %10s %12s %12s %12s\n", "rows as", "rows", "scan ms", "Mrows/s", "allocs/row");
+    errors += warm_scans(heap_pages * 38);
+
+    if (errors) {
+        std::fprintf(stderr, "FAILED: %zu pages with wrong content\n", errors);
+        return 1;
+    }
+    std::printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,90 @@
+/*********************  execution/agg_hash_table.hpp  *********************
+ * Open-addressing hash table for GROUP BY: maps a group key to its group
+ * number, 0, 1, ... in order of first appearance, so the aggregates can
+ * keep their running values in plain arrays indexed by group.
+ *
+ * Keys are fixed width (an INT's 4 bytes, a CHAR(n)'s n bytes as padded
+ * in the row) and are stored back to back in one arena. The slot array
+ * holds (group, hash tag) pairs and is probed linearly; a key is
+ * compared only when the tag matches. It doubles at half full.
+ *************************************************************************/
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+class AggHashTable {
+public:
+    explicit AggHashTable(size_t key_width)
+        : width_(key_width), slots_(INITIAL_SLOTS), mask_(INITIAL_SLOTS - 1) {}
+
+    // Group number of the key (key_width bytes at key), a new one if unseen
+    uint32_t find_or_insert(const char* key) {
+        uint64_t h = hash(key);
+        uint32_t tag = static_cast<uint32_t>(h >> 32);
+        for (size_t i = h & mask_;; i = (i + 1) & mask_) {
+            Slot& s = slots_[i];
+            if (s.group == EMPTY) {
+                uint32_t g = static_cast<uint32_t>(groups_);
+                s = Slot{ g, tag };
+                keys_.insert(keys_.end(), key, key + width_);
+                if (++groups_ * 2 > slots_.size()) grow();
+                return g;
+            }
+            if (s.tag == tag && std::memcmp(keys_.data() + s.group * width_, key, width_) == 0) return s.group;
+        }
+    }
+
+    size_t size() const { return groups_; }
+    // The key of group g
+    const char* key(uint32_t g) const { return keys_.data() + g * width_; }
+
+private:
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+    static constexpr size_t INITIAL_SLOTS = 64;
+
+    struct Slot {
+        uint32_t group = EMPTY;
+        uint32_t tag = 0;       // high half of the key's hash
+    };
+
+    // 8 bytes at a time, then a 64-bit finalizer (MurmurHash3's)
+    uint64_t hash(const char* key) const {
+        uint64_t h = width_;
+        size_t i = 0;
+        for (; i + 8 <= width_; i += 8) {
+            uint64_t w;
+            std::memcpy(&w, key + i, 8);
+            h = (h ^ w) * 0x9E3779B97F4A7C15ull;
+            h ^= h >> 29;
+        }
+        if (i < width_) {
+            uint64_t w = 0;
+            std::memcpy(&w, key + i, width_ - i);
+            h = (h ^ w) * 0x9E3779B97F4A7C15ull;
+        }
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDull;
+        h ^= h >> 33;
+        h *= 0xC4CEB9FE1A85EC53ull;
+        h ^= h >> 33;
+        return h;
+    }
+
+    void grow() {
+        slots_.assign(slots_.size() * 2, Slot{});
+        mask_ = slots_.size() - 1;
+        for (uint32_t g = 0; g < groups_; ++g) {
+            uint64_t h = hash(key(g));
+            size_t i = h & mask_;
+            while (slots_[i].group != EMPTY) i = (i + 1) & mask_;
+            slots_[i] = Slot{ g, static_cast<uint32_t>(h >> 32) };
+        }
+    }
+
+    size_t            width_;
+    std::vector<Slot> slots_;
+    size_t            mask_;
+    std::vector<char> keys_;
+    size_t            groups_ = 0;
+};
@@ -0,0 +1,78 @@
+/**********************  execution/agg_kernels.hpp  **********************
+ * Sum, minimum and maximum of an INT column vector, for aggregates
+ * without GROUP BY.
+ *
+ * AVX2 takes 8 values per step: the sum widens them into two vectors
+ * of int64 lanes, so it is as exact as the scalar one; min and max keep
+ * 8 running lanes and fold them at the end. Without AVX2 the loops
+ * are scalar. The AVX2 loops are chosen at run time, as in
+ * simd_search.hpp (simd::has_avx2).
+ *************************************************************************/
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include "storage/simd_search.hpp"
+
+namespace agg {
+
+namespace detail {
+
+#if defined(MYDB_SIMD_X86)
+// Sum of the leading multiple of 8 values; i ends after them
+MYDB_TARGET_AVX2 inline int64_t sum_avx2(const int32_t* v, size_t n, size_t& i) {
+    __m256i lo = _mm256_setzero_si256(), hi = _mm256_setzero_si256();
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + i));
+        lo = _mm256_add_epi64(lo, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(x)));
+        hi = _mm256_add_epi64(hi, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(x, 1)));
+    }
+    alignas(32) int64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), _mm256_add_epi64(lo, hi));
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+// extreme over the leading multiple of 8 values (n >= 8); i ends after them
+template <bool Max>
+MYDB_TARGET_AVX2 inline int32_t extreme_avx2(const int32_t* v, size_t n, int32_t init, size_t& i) {
+    int32_t m = init;
+    __m256i acc = _mm256_set1_epi32(init);
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + i));
+        acc = Max ? _mm256_max_epi32(acc, x) : _mm256_min_epi32(acc, x);
+    }
+    alignas(32) int32_t lanes[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    for (int32_t l : lanes) m = Max ? std::max(m, l) : std::min(m, l);
+    return m;
+}
+#endif
+
+} // namespace detail
+
+inline int64_t sum(const int32_t* v, size_t n) {
+    size_t i = 0;
+    int64_t s = 0;
+#if defined(MYDB_SIMD_X86)
+    if (simd::has_avx2()) s = detail::sum_avx2(v, n, i);
+#endif
+    for (; i < n; ++i) s += v[i];
+    return s;
+}
+
+// Smallest (Max = false) or largest of init and the n values
+template <bool Max>
+inline int32_t extreme(const int32_t* v, size_t n, int32_t init) {
+    size_t i = 0;
+    int32_t m = init;
+#if defined(MYDB_SIMD_X86)
+    if (n >= 8 && simd::has_avx2()) m = detail::extreme_avx2<Max>(v, n, init, i);
+#endif
+    for (; i < n; ++i) m = Max ? std::max(m, v[i]) : std::min(m, v[i]);
+    return m;
+}
+
+inline int32_t min(const int32_t* v, size_t n, int32_t init) { return extreme<false>(v, n, init); }
+inline int32_t max(const int32_t* v, size_t n, int32_t init) { return extreme<true>(v, n, init); }
+
+} // namespace agg
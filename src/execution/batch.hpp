@@ -0,0 +1,130 @@
+/************************  execution/batch.hpp  ***********************
+ * The unit operators pass to each other: up to CAPACITY rows, stored
+ * column by column with their RIDs.
+ *
+ * A column holds typed values, never text: INT as int32_t, CHAR(n) as
+ * n-byte slots '\0'-padded exactly as in the tuple, so a row decodes
+ * into a batch with plain copies and a predicate compares in place.
+ * Values are turned into text only by whoever prints the result.
+ * Aggregates add BIGINT (int64_t) and DOUBLE columns, and NULLs.
+ *****************************************************************/
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+#include "parser/query.hpp"
+#include "storage/rid.hpp"
+
+struct ColumnVector {
+    ColumnType           type = ColumnType::INT;
+    size_t               width = sizeof(int32_t);   // bytes per value
+    std::vector<int32_t> ints;                      // INT
+    std::vector<char>    chars;                     // CHAR(n): width bytes per row
+    std::vector<int64_t> longs;                     // BIGINT
+    std::vector<double>  reals;                     // DOUBLE
+    std::vector<uint8_t> nulls;                     // 1 where NULL; empty if none is
+
+    explicit ColumnVector(const ColumnDef& col) : type(col.type), width(value_width(col)) {}
+
+    static size_t value_width(const ColumnDef& col) {
+        switch (col.type) {
+            case ColumnType::INT:    return sizeof(int32_t);
+            case ColumnType::BIGINT: return sizeof(int64_t);
+            case ColumnType::DOUBLE: return sizeof(double);
+            default:                 return col.len;
+        }
+    }
+
+    int32_t get_int(size_t row) const { return ints[row]; }
+    int64_t get_long(size_t row) const { return longs[row]; }
+    double get_double(size_t row) const { return reals[row]; }
+    bool is_null(size_t row) const { return !nulls.empty() && nulls[row]; }
+    // The CHAR value without its padding
+    std::string_view get_char(size_t row) const {
+        const char* p = chars.data() + row * width;
+        return std::string_view(p, ::strnlen(p, width));
+    }
+
+    // Append one value as stored in a tuple (width bytes at p)
+    void append_raw(const std::byte* p) {
+        if (type == ColumnType::INT) {
+            int32_t v;
+            std::memcpy(&v, p, sizeof v);
+            ints.push_back(v);
+        } else {
+            const char* c = reinterpret_cast<const char*>(p);
+            chars.insert(chars.end(), c, c + width);
+        }
+    }
+
+    // Keep the rows listed in sel (ascending), in that order
+    void compact(const std::vector<uint32_t>& sel) {
+        auto keep = [&](auto& v) {
+            if (v.empty()) return;
+            for (size_t i = 0; i < sel.size(); ++i) v[i] = v[sel[i]];
+            v.resize(sel.size());
+        };
+        keep(ints);
+        keep(longs);
+        keep(reals);
+        keep(nulls);
+        if (type == ColumnType::CHAR) {
+            for (size_t i = 0; i < sel.size(); ++i)
+                if (i != sel[i]) std::memcpy(chars.data() + i * width, chars.data() + sel[i] * width, width);
+            chars.resize(sel.size() * width);
+        }
+    }
+
+    // Keep only the first n rows
+    void truncate(size_t n) {
+        auto keep = [&](auto& v) { if (v.size() > n) v.resize(n); };
+        keep(ints);
+        keep(longs);
+        keep(reals);
+        keep(nulls);
+        if (type == ColumnType::CHAR) chars.resize(n * width);
+    }
+
+    void clear() { ints.clear(); chars.clear(); longs.clear(); reals.clear(); nulls.clear(); }
+};
+
+struct Batch {
+    static constexpr size_t CAPACITY = 1024;
+
+    std::vector<ColumnVector> columns;
+    std::vector<RID>          rids;        // where each row lives in its heap
+
+    size_t size() const { return rids.size(); }
+    bool empty() const { return rids.empty(); }
+
+    // Empty batch with one column per definition (keeps the buffers when
+    // the layout is the same)
+    void reset(const std::vector<ColumnDef>& cols) {
+        bool same = columns.size() == cols.size();
+        for (size_t i = 0; same && i < cols.size(); ++i)
+            same = columns[i].type == cols[i].type && columns[i].width == ColumnVector(cols[i]).width;
+        if (!same) {
+            columns.clear();
+            for (const ColumnDef& c : cols) columns.emplace_back(c);
+        }
+        clear();
+    }
+
+    void compact(const std::vector<uint32_t>& sel) {
+        for (auto& c : columns) c.compact(sel);
+        for (size_t i = 0; i < sel.size(); ++i) rids[i] = rids[sel[i]];
+        rids.resize(sel.size());
+    }
+
+    void truncate(size_t n) {
+        if (n >= size()) return;
+        for (auto& c : columns) c.truncate(n);
+        rids.resize(n);
+    }
+
+    void clear() {
+        for (auto& c : columns) c.clear();
+        rids.clear();
+    }
+};
@@ -0,0 +1,145 @@
+/**********************  execution/csv_reader.hpp  **********************
+ * Streaming CSV reader for COPY. The file is read CHUNK bytes at a time
+ * and a record's fields are string_views into the buffer, good until the
+ * next call; nothing is allocated per record.
+ *
+ *   record  one line; a '\r' before the '\n' is dropped, blank lines
+ *           are skipped, the last line needs no '\n'
+ *   field   separated by ','; "..." may hold ',', newlines and "" for a
+ *           quote (unescaped in place)
+ *
+ * A line without a quote is split with memchr; only quoted records are
+ * walked a character at a time.
+ *************************************************************************/
+#pragma once
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class CsvReader {
+public:
+    static constexpr size_t CHUNK = size_t(1) << 20;   // bytes per read
+
+    // Throws if path cannot be opened
+    explicit CsvReader(const std::string& path)
+        : file_(std::fopen(path.c_str(), "rb"), &std::fclose), buf_(CHUNK) {
+        if (!file_) throw std::runtime_error("cannot open " + path);
+    }
+
+    // The next record's fields; false at the end of the file. Throws on a
+    // quote that is never closed.
+    bool next(std::vector<std::string_view>& fields) {
+        for (;;) {
+            bool quoted = false, open = false;
+            size_t end = record_end(quoted, open);
+            if (end == NONE) {
+                if (fill()) continue;
+                if (pos_ == end_) return false;
+                if (open) throw std::runtime_error("line " + std::to_string(line_) + ": unterminated quote");
+                end = end_;                         // last line, no '\n'
+            }
+            size_t start = pos_;
+            pos_ = std::min(end + 1, end_);
+            record_line_ = line_;
+            line_ += quoted ? 1 + std::count(buf_.data() + start, buf_.data() + end, '\n') : 1;
+
+            if (end > start && buf_[end - 1] == '\r') --end;
+            if (end == start) continue;             // blank line
+            fields.clear();
+            if (quoted) split_quoted(start, end, fields);
+            else split(start, end, fields);
+            return true;
+        }
+    }
+
+    // Line the last record started on (from 1)
+    size_t line() const { return record_line_; }
+
+private:
+    static constexpr size_t NONE = SIZE_MAX;
+
+    // Offset of the '\n' ending the record at pos_, or NONE if the buffer
+    // does not hold all of it. quoted: it has a quote; open: one is open
+    // at the end of the buffer.
+    size_t record_end(bool& quoted, bool& open) const {
+        const char* b = buf_.data();
+        const char* nl = static_cast<const char*>(std::memchr(b + pos_, '\n', end_ - pos_));
+        size_t line_end = nl ? nl - b : end_;
+        if (!std::memchr(b + pos_, '"', line_end - pos_)) return nl ? line_end : NONE;
+
+        quoted = true;
+        for (size_t i = pos_; i < end_; ++i) {
+            if (b[i] == '"') open = !open;
+            else if (b[i] == '\n' && !open) return i;
+        }
+        return NONE;
+    }
+
+    void split(size_t start, size_t end, std::vector<std::string_view>& fields) const {
+        const char* b = buf_.data();
+        for (;;) {
+            const char* comma = static_cast<const char*>(std::memchr(b + start, ',', end - start));
+            size_t stop = comma ? comma - b : end;
+            fields.emplace_back(b + start, stop - start);
+            if (!comma) return;
+            start = stop + 1;
+        }
+    }
+
+    // Quotes come out and "" becomes one; the text only shrinks, so it is
+    // rewritten where it lies
+    void split_quoted(size_t start, size_t end, std::vector<std::string_view>& fields) {
+        char* b = buf_.data();
+        size_t i = start;
+        for (;;) {
+            size_t field = i, w = i;
+            bool open = false;
+            for (; i < end; ++i) {
+                char c = b[i];
+                if (c == '"') {
+                    if (open && i + 1 < end && b[i + 1] == '"') b[w++] = b[i++];
+                    else open = !open;
+                } else if (c == ',' && !open) {
+                    break;
+                } else {
+                    b[w++] = c;
+                }
+            }
+            fields.emplace_back(b + field, w - field);
+            if (i >= end) return;
+            ++i;
+        }
+    }
+
+    // Keep the unread part, read behind it; grows the buffer for a record
+    // longer than it. False at the end of the file.
+    bool fill() {
+        if (eof_) return false;
+        if (pos_ > 0) {
+            std::memmove(buf_.data(), buf_.data() + pos_, end_ - pos_);
+            end_ -= pos_;
+            pos_ = 0;
+        }
+        if (end_ == buf_.size()) buf_.resize(buf_.size() * 2);
+        size_t n = std::fread(buf_.data() + end_, 1, buf_.size() - end_, file_.get());
+        if (n == 0) {
+            if (std::ferror(file_.get())) throw std::runtime_error("read error");
+            eof_ = true;
+            return false;
+        }
+        end_ += n;
+        return true;
+    }
+
+    std::unique_ptr<std::FILE, int (*)(std::FILE*)> file_;
+    std::vector<char> buf_;
+    size_t            pos_ = 0, end_ = 0;   // unread bytes
+    bool              eof_ = false;
+    size_t            line_ = 1;            // of the record at pos_
+    size_t            record_line_ = 0;
+};
@@ -0,0 +1,335 @@
+#include "operators.hpp"
+#include "agg_kernels.hpp"
+#include <algorithm>
+#include <charconv>
+#include <climits>
+
+// Decode a tuple into the batch's columns, straight from its bytes
+static void append_row(Batch& out, TupleView t, const RID& rid) {
+    const std::byte* p = t.data();
+    for (auto& col : out.columns) {
+        col.append_raw(p);
+        p += col.width;
+    }
+    out.rids.push_back(rid);
+}
+
+std::string value_string(const ColumnVector& col, size_t row) {
+    if (col.is_null(row)) return "NULL";
+    if (col.type == ColumnType::CHAR) return std::string(col.get_char(row));
+    char buf[32];
+    char* end = buf;
+    switch (col.type) {
+        case ColumnType::BIGINT: end = std::to_chars(buf, buf + sizeof buf, col.get_long(row)).ptr; break;
+        case ColumnType::DOUBLE: end = std::to_chars(buf, buf + sizeof buf, col.get_double(row)).ptr; break;
+        default:                 end = std::to_chars(buf, buf + sizeof buf, col.get_int(row)).ptr; break;
+    }
+    return std::string(buf, end);
+}
+
+/* ---------- scans ---------- */
+
+SeqScan::SeqScan(TableMeta& tm) : tm_(tm), it_(tm.heap->scan()) {
+    output_ = tm.schema.columns();
+}
+
+bool SeqScan::next(Batch& out) {
+    out.reset(output_);
+    TupleView t;
+    RID rid;
+    while (out.size() < Batch::CAPACITY && it_.next(t, rid)) append_row(out, t, rid);
+    return !out.empty();
+}
+
+IndexScan::IndexScan(TableMeta& tm, Index* index, Bounds bounds)
+    : tm_(tm), index_(index), bounds_(std::move(bounds)) {
+    output_ = tm.schema.columns();
+}
+
+bool IndexScan::next(Batch& out) {
+    if (!started_) {
+        rids_ = index_->scan(bounds_);
+        started_ = true;
+    }
+    out.reset(output_);
+    TupleView t;
+    for (; pos_ < rids_.size() && out.size() < Batch::CAPACITY; ++pos_)
+        if (tm_.heap->get_tuple(rids_[pos_], t, page_)) append_row(out, t, rids_[pos_]);
+    page_.reset();              // no pin held between batches
+    return !out.empty();
+}
+
+/* ---------- filter ---------- */
+
+Filter::Filter(std::unique_ptr<Operator> child, size_t column, const Bounds& bounds)
+    : child_(std::move(child)), column_(column) {
+    output_ = child_->output();
+    if (column_ >= output_.size()) throw std::runtime_error("filter column out of range");
+    if (bounds.lo) lo_ = bound(*bounds.lo, bounds.lo_incl);
+    if (bounds.hi) hi_ = bound(*bounds.hi, bounds.hi_incl);
+}
+
+Filter::Bound Filter::bound(const Param& value, bool incl) const {
+    Bound b;
+    b.incl = incl;
+    if (output_[column_].type == ColumnType::INT) b.i = bound_int(value);
+    else b.s = std::get<std::string>(value);
+    return b;
+}
+
+bool Filter::next(Batch& out) {
+    while (child_->next(out)) {
+        select(out.columns[column_], out.size());
+        if (sel_.empty()) continue;
+        if (sel_.size() < out.size()) out.compact(sel_);
+        return true;
+    }
+    return false;
+}
+
+void Filter::select(const ColumnVector& col, size_t n) {
+    sel_.clear();
+    if (col.type == ColumnType::INT) {
+        // Closed bounds; a strict bound moves one step inwards
+        long long lo = lo_ ? lo_->i + !lo_->incl : LLONG_MIN;
+        long long hi = hi_ ? hi_->i - !hi_->incl : LLONG_MAX;
+        const int32_t* v = col.ints.data();
+        for (size_t r = 0; r < n; ++r)
+            if (v[r] >= lo && v[r] <= hi) sel_.push_back(static_cast<uint32_t>(r));
+        return;
+    }
+    for (size_t r = 0; r < n; ++r) {
+        std::string_view v = col.get_char(r);
+        if (lo_) {
+            int c = v.compare(lo_->s);
+            if (c < 0 || (c == 0 && !lo_->incl)) continue;
+        }
+        if (hi_) {
+            int c = v.compare(hi_->s);
+            if (c > 0 || (c == 0 && !hi_->incl)) continue;
+        }
+        sel_.push_back(static_cast<uint32_t>(r));
+    }
+}
+
+/* ---------- projection, limit ---------- */
+
+Projection::Projection(std::unique_ptr<Operator> child, std::vector<size_t> columns)
+    : child_(std::move(child)), columns_(std::move(columns)) {
+    const auto& in = child_->output();
+    for (size_t c : columns_) {
+        if (c >= in.size()) throw std::runtime_error("projected column out of range");
+        output_.push_back(in[c]);
+    }
+}
+
+bool Projection::next(Batch& out) {
+    if (!child_->next(in_)) return false;
+    out.reset(output_);
+    // A column listed twice is copied; otherwise its buffers move over
+    for (size_t i = 0; i < columns_.size(); ++i) {
+        size_t c = columns_[i];
+        bool again = std::count(columns_.begin() + i + 1, columns_.end(), c) > 0;
+        if (again) out.columns[i] = in_.columns[c];
+        else std::swap(out.columns[i], in_.columns[c]);
+    }
+    std::swap(out.rids, in_.rids);
+    return true;
+}
+
+Limit::Limit(std::unique_ptr<Operator> child, size_t limit) : child_(std::move(child)), left_(limit) {
+    output_ = child_->output();
+}
+
+bool Limit::next(Batch& out) {
+    if (left_ == 0 || !child_->next(out)) return false;
+    out.truncate(left_);
+    left_ -= out.size();
+    return true;
+}
+
+/* ---------- delete ---------- */
+
+Delete::Delete(std::unique_ptr<Operator> child, TableMeta& tm, LogManager* log)
+    : child_(std::move(child)), tm_(tm), log_(log) {
+    if (child_->output().size() != tm_.schema.columns().size())
+        throw std::runtime_error("delete needs every column of the row");
+    output_ = { ColumnDef{ "deleted", ColumnType::INT, 0 } };
+}
+
+bool Delete::next(Batch& out) {
+    if (done_) return false;
+    done_ = true;
+
+    // Collect first: the index and heap are not modified under a cursor
+    std::vector<Batch> rows;
+    for (Batch b; child_->next(b);) rows.push_back(std::move(b));
+
+    int32_t count = 0;
+    if (!rows.empty()) {
+        Txn txn = log_ ? log_->begin() : Txn{};
+        for (const Batch& b : rows) {
+            for (size_t r = 0; r < b.size(); ++r) {
+                for (auto& idx : tm_.indexes) idx->remove(value_string(b.columns[idx->column()], r), b.rids[r]);
+                tm_.heap->delete_tuple(b.rids[r], &txn);
+                ++count;
+            }
+        }
+        if (log_) log_->commit(txn);
+    }
+
+    out.reset(output_);
+    out.columns[0].ints.push_back(count);
+    out.rids.emplace_back();
+    return true;
+}
+
+/* ---------- aggregates ---------- */
+
+// The column an aggregation returns for spec, over the child's columns in
+static ColumnDef agg_output(const AggSpec& spec, const std::vector<ColumnDef>& in) {
+    static constexpr const char* NAMES[] = { "", "COUNT", "SUM", "MIN", "MAX", "AVG" };
+    if (spec.column >= in.size()) throw std::runtime_error("aggregate column out of range");
+    const ColumnDef& col = in[spec.column];
+    const char* name = NAMES[static_cast<size_t>(spec.func)];
+    if (spec.func == AggFunc::NONE) return col;
+    if (spec.func == AggFunc::COUNT) return ColumnDef{ "count", ColumnType::BIGINT, 0 };
+    if (col.type != ColumnType::INT) throw std::runtime_error(std::string(name) + " needs an INT column");
+    if (spec.func == AggFunc::SUM) return ColumnDef{ "sum", ColumnType::BIGINT, 0 };
+    if (spec.func == AggFunc::AVG) return ColumnDef{ "avg", ColumnType::DOUBLE, 0 };
+    return ColumnDef{ spec.func == AggFunc::MIN ? "min" : "max", ColumnType::INT, 0 };
+}
+
+static std::runtime_error not_grouped(const ColumnDef& col) {
+    return std::runtime_error("column " + col.name + " must be in GROUP BY or an aggregate");
+}
+
+Aggregate::Aggregate(std::unique_ptr<Operator> child, std::vector<AggSpec> specs)
+    : child_(std::move(child)), specs_(std::move(specs)) {
+    for (const AggSpec& s : specs_) {
+        output_.push_back(agg_output(s, child_->output()));
+        if (s.func == AggFunc::NONE) throw not_grouped(output_.back());
+    }
+}
+
+// Whole column vectors at a time, through the SIMD kernels
+bool Aggregate::next(Batch& out) {
+    if (done_) return false;
+    done_ = true;
+
+    int64_t rows = 0;
+    std::vector<int64_t> sum(specs_.size(), 0);
+    std::vector<int32_t> lo(specs_.size(), INT32_MAX), hi(specs_.size(), INT32_MIN);
+    Batch in;
+    while (child_->next(in)) {
+        size_t n = in.size();
+        rows += n;
+        for (size_t i = 0; i < specs_.size(); ++i) {
+            const int32_t* v = in.columns[specs_[i].column].ints.data();
+            switch (specs_[i].func) {
+                case AggFunc::SUM:
+                case AggFunc::AVG: sum[i] += agg::sum(v, n); break;
+                case AggFunc::MIN: lo[i] = agg::min(v, n, lo[i]); break;
+                case AggFunc::MAX: hi[i] = agg::max(v, n, hi[i]); break;
+                default:           break;
+            }
+        }
+    }
+
+    out.reset(output_);
+    for (size_t i = 0; i < specs_.size(); ++i) {
+        ColumnVector& col = out.columns[i];
+        switch (specs_[i].func) {
+            case AggFunc::COUNT: col.longs.push_back(rows); break;
+            case AggFunc::SUM:   col.longs.push_back(sum[i]); break;
+            case AggFunc::MIN:   col.ints.push_back(lo[i]); break;
+            case AggFunc::MAX:   col.ints.push_back(hi[i]); break;
+            case AggFunc::AVG:   col.reals.push_back(rows ? static_cast<double>(sum[i]) / rows : 0); break;
+            default:             break;
+        }
+        if (rows == 0 && specs_[i].func != AggFunc::COUNT) col.nulls.push_back(1);
+    }
+    out.rids.emplace_back();
+    return true;
+}
+
+HashAggregate::HashAggregate(std::unique_ptr<Operator> child, size_t group, std::vector<AggSpec> specs)
+    : child_(std::move(child)), group_(group), specs_(std::move(specs)),
+      table_(ColumnVector::value_width(child_->output().at(group))), acc_(specs_.size()) {
+    for (const AggSpec& s : specs_) {
+        output_.push_back(agg_output(s, child_->output()));
+        if (s.func == AggFunc::NONE && s.column != group_) throw not_grouped(output_.back());
+    }
+}
+
+// The group key as it lies in the column vector
+static const char* group_key(const ColumnVector& col, size_t row) {
+    if (col.type == ColumnType::INT) return reinterpret_cast<const char*>(col.ints.data() + row);
+    return col.chars.data() + row * col.width;
+}
+
+// Each batch: the group of every row first, then each aggregate over the
+// batch, one column at a time
+void HashAggregate::build() {
+    built_ = true;
+    Batch in;
+    while (child_->next(in)) {
+        size_t n = in.size();
+        const ColumnVector& key = in.columns[group_];
+        groups_.resize(n);
+        for (size_t r = 0; r < n; ++r) groups_[r] = table_.find_or_insert(group_key(key, r));
+        if (table_.size() > rows_.size()) {
+            rows_.resize(table_.size(), 0);
+            for (size_t i = 0; i < specs_.size(); ++i) {
+                AggFunc f = specs_[i].func;
+                acc_[i].resize(table_.size(), f == AggFunc::MIN ? INT64_MAX : f == AggFunc::MAX ? INT64_MIN : 0);
+            }
+        }
+
+        const uint32_t* g = groups_.data();
+        for (size_t r = 0; r < n; ++r) ++rows_[g[r]];
+        for (size_t i = 0; i < specs_.size(); ++i) {
+            int64_t* acc = acc_[i].data();
+            const int32_t* v = in.columns[specs_[i].column].ints.data();
+            switch (specs_[i].func) {
+                case AggFunc::SUM:
+                case AggFunc::AVG:
+                    for (size_t r = 0; r < n; ++r) acc[g[r]] += v[r];
+                    break;
+                case AggFunc::MIN:
+                    for (size_t r = 0; r < n; ++r) acc[g[r]] = std::min<int64_t>(acc[g[r]], v[r]);
+                    break;
+                case AggFunc::MAX:
+                    for (size_t r = 0; r < n; ++r) acc[g[r]] = std::max<int64_t>(acc[g[r]], v[r]);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+bool HashAggregate::next(Batch& out) {
+    if (!built_) build();
+    if (pos_ >= table_.size()) return false;
+
+    size_t end = std::min(table_.size(), pos_ + Batch::CAPACITY);
+    out.reset(output_);
+    for (size_t i = 0; i < specs_.size(); ++i) {
+        ColumnVector& col = out.columns[i];
+        const std::vector<int64_t>& acc = acc_[i];
+        for (size_t g = pos_; g < end; ++g) {
+            switch (specs_[i].func) {
+                case AggFunc::NONE:  col.append_raw(reinterpret_cast<const std::byte*>(table_.key(static_cast<uint32_t>(g)))); break;
+                case AggFunc::COUNT: col.longs.push_back(rows_[g]); break;
+                case AggFunc::SUM:   col.longs.push_back(acc[g]); break;
+                case AggFunc::MIN:
+                case AggFunc::MAX:   col.ints.push_back(static_cast<int32_t>(acc[g])); break;
+                case AggFunc::AVG:   col.reals.push_back(static_cast<double>(acc[g]) / rows_[g]); break;
+            }
+        }
+    }
+    out.rids.resize(end - pos_);
+    pos_ = end;
+    return true;
+}
@@ -0,0 +1,172 @@
+/**********************  execution/operators.hpp  *********************
+ * Physical operators. A plan is a tree of them; the root is pulled with
+ * next() until it returns false, and every call hands back a Batch of up
+ * to Batch::CAPACITY rows (never an empty one while rows remain).
+ *
+ *   SeqScan     every live row of a heap, in chain order
+ *   IndexScan   the rows an index returns for a range, in index order
+ *   Filter      rows whose column satisfies a range, compared as typed
+ *               values (INT numerically, CHAR bytewise without padding)
+ *   Projection  a subset of the child's columns, in a given order
+ *   Limit       the first n rows
+ *   Delete      removes every row the child returns from the indexes and
+ *               the heap as one transaction; returns one row, the count
+ *   Aggregate   COUNT / SUM / MIN / MAX / AVG over all the child's rows;
+ *               returns one row
+ *   HashAggregate  the same per value of a group column; one row per
+ *               group, in order of first appearance
+ *
+ * The scans decode rows straight from the pinned page (TupleView), so a
+ * row is copied once, into the batch's column vectors.
+ *
+ * Operators keep their child's column order; output() describes it.
+ * The aggregates return theirs: COUNT and SUM as BIGINT, MIN and MAX as
+ * INT, AVG as DOUBLE; over no rows at all, all but COUNT are NULL.
+ *****************************************************************/
+#pragma once
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "execution/agg_hash_table.hpp"
+#include "execution/batch.hpp"
+#include "storage/catalog.hpp"
+
+class Operator {
+public:
+    virtual ~Operator() = default;
+
+    // Next batch of rows into out (cleared first); false once exhausted
+    virtual bool next(Batch& out) = 0;
+
+    // The columns of the batches this operator returns
+    const std::vector<ColumnDef>& output() const { return output_; }
+
+protected:
+    std::vector<ColumnDef> output_;
+};
+
+class SeqScan : public Operator {
+public:
+    explicit SeqScan(TableMeta& tm);
+    bool next(Batch& out) override;
+
+private:
+    TableMeta&    tm_;
+    TableIterator it_;
+};
+
+class IndexScan : public Operator {
+public:
+    IndexScan(TableMeta& tm, Index* index, Bounds bounds);
+    bool next(Batch& out) override;
+
+private:
+    TableMeta&       tm_;
+    Index*           index_;
+    Bounds           bounds_;
+    bool             started_ = false;
+    std::vector<RID> rids_;
+    size_t           pos_ = 0;
+    PageGuard        page_;        // page of the last row fetched
+};
+
+class Filter : public Operator {
+public:
+    // Keeps the rows whose column `column` lies within bounds
+    Filter(std::unique_ptr<Operator> child, size_t column, const Bounds& bounds);
+    bool next(Batch& out) override;
+
+private:
+    // A bound ready to compare: INT widened so that one past the int range
+    // compares correctly (bound_int), CHAR as given
+    struct Bound {
+        long long   i = 0;
+        std::string s;
+        bool        incl = true;
+    };
+    Bound bound(const Param& value, bool incl) const;
+    void select(const ColumnVector& col, size_t n);
+
+    std::unique_ptr<Operator> child_;
+    size_t                    column_;
+    std::optional<Bound>      lo_, hi_;
+    std::vector<uint32_t>     sel_;      // rows of the current batch that pass
+};
+
+class Projection : public Operator {
+public:
+    Projection(std::unique_ptr<Operator> child, std::vector<size_t> columns);
+    bool next(Batch& out) override;
+
+private:
+    std::unique_ptr<Operator> child_;
+    std::vector<size_t>       columns_;
+    Batch                     in_;
+};
+
+class Limit : public Operator {
+public:
+    Limit(std::unique_ptr<Operator> child, size_t limit);
+    bool next(Batch& out) override;
+
+private:
+    std::unique_ptr<Operator> child_;
+    size_t                    left_;
+};
+
+class Delete : public Operator {
+public:
+    // With a log, the deletes are one transaction, durable when next() returns
+    Delete(std::unique_ptr<Operator> child, TableMeta& tm, LogManager* log);
+    bool next(Batch& out) override;
+
+private:
+    std::unique_ptr<Operator> child_;
+    TableMeta&                tm_;
+    LogManager*               log_;
+    bool                      done_ = false;
+};
+
+// An output column of an aggregation: func over the child's column
+// `column` (any for COUNT), or for NONE the group column itself
+struct AggSpec {
+    AggFunc func = AggFunc::NONE;
+    size_t  column = 0;
+};
+
+class Aggregate : public Operator {
+public:
+    // SUM, MIN, MAX and AVG need INT columns
+    Aggregate(std::unique_ptr<Operator> child, std::vector<AggSpec> specs);
+    bool next(Batch& out) override;
+
+private:
+    std::unique_ptr<Operator> child_;
+    std::vector<AggSpec>      specs_;
+    bool                      done_ = false;
+};
+
+class HashAggregate : public Operator {
+public:
+    // Groups on the child's column `group` (INT or CHAR); a NONE spec
+    // must name it
+    HashAggregate(std::unique_ptr<Operator> child, size_t group, std::vector<AggSpec> specs);
+    bool next(Batch& out) override;
+
+private:
+    void build();
+
+    std::unique_ptr<Operator>         child_;
+    size_t                            group_;
+    std::vector<AggSpec>              specs_;
+    AggHashTable                      table_;
+    std::vector<int64_t>              rows_;     // per group
+    std::vector<std::vector<int64_t>> acc_;      // per spec, per group: sum, min or max
+    std::vector<uint32_t>             groups_;   // group of each row of the batch
+    bool                              built_ = false;
+    size_t                            pos_ = 0;  // next group to return
+};
+
+// Text of value `row` of a column, as Schema::deserialize gives it
+std::string value_string(const ColumnVector& col, size_t row);
@@ -1,25 +1,148 @@
 #include "query_executor.hpp"
-#include <sstream>
+#include "../parser/query_parser.hpp"
+#include "csv_reader.hpp"
+#include <charconv>
+#include <iostream>
 
 std::optional<std::string> QueryExecutor::execute(const Query& q) {
         try {
-            return std::visit([&](auto&& cmd)->std::optional<std::string> {
-                using T = std::decay_t<decltype(cmd)>;
-                if constexpr (std::is_same_v<T, CreateTable>)   return exec_create(cmd);
-                if constexpr (std::is_same_v<T, Insert>)        return exec_insert(cmd);
-                if constexpr (std::is_same_v<T, SelectAll>)     return exec_select_all(cmd);
-                if constexpr (std::is_same_v<T, SelectWhere>)   return exec_select_where(cmd);
-                if constexpr (std::is_same_v<T, DeleteWhere>)   return exec_delete_where(cmd);
-                return std::nullopt;
-                }, q);
+            Plan p;
+            make_plan(q, p);
+            return reply(run(q, p));
         }
         catch (const std::exception& e) {
             std::cerr << "Error: " << e.what() << std::endl;
-            return std::string("ERR: ") + e.what();
+            return reply(std::string("ERR: ") + e.what());
         }
 
 }
 
+std::string QueryExecutor::run(const Query& q, const Plan& p) {
+    return std::visit([&](auto&& cmd) -> std::string {
+        using T = std::decay_t<decltype(cmd)>;
+        if constexpr (std::is_same_v<T, CreateTable>)   return exec_create(cmd);
+        if constexpr (std::is_same_v<T, CreateIndex>)   return exec_create_index(cmd);
+        if constexpr (std::is_same_v<T, Insert>)        return exec_insert(cmd, p);
+        if constexpr (std::is_same_v<T, SelectAll>)     return exec_select_all(cmd, p);
+        if constexpr (std::is_same_v<T, SelectWhere>)   return exec_select_where(cmd, p);
+        if constexpr (std::is_same_v<T, DeleteWhere>)   return exec_delete_where(cmd, p);
+        if constexpr (std::is_same_v<T, SelectRange>)   return exec_select_range(cmd, p);
+        if constexpr (std::is_same_v<T, DeleteRange>)   return exec_delete_range(cmd, p);
+        if constexpr (std::is_same_v<T, Prepare>)       return exec_prepare(cmd);
+        if constexpr (std::is_same_v<T, Execute>)       return exec_execute(cmd);
+        if constexpr (std::is_same_v<T, Copy>)          return exec_copy(cmd, p);
+        }, q);
+}
+
+/* ---------- prepared statements ---------- */
+
+Statement QueryExecutor::prepare(const std::string& sql) { return prepare(sql, false); }
+
+Statement QueryExecutor::prepare(const std::string& sql, bool keep) {
+    if (auto it = plans_.find(sql); it != plans_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return Statement(this, it->second->second);
+    }
+
+    auto prep = std::make_shared<Prepared>();
+    auto q = QueryParser::parse(sql, &prep->params);
+    if (!q) return Statement();
+    prep->query = std::move(*q);
+    for (uint16_t n : prep->params) prep->param_count = std::max<size_t>(prep->param_count, n);
+
+    if (keep || prep->param_count) {
+        if (lru_.size() >= PLAN_CACHE_SIZE) {
+            plans_.erase(lru_.back().first);
+            lru_.pop_back();
+        }
+        lru_.emplace_front(sql, prep);
+        plans_.emplace(lru_.front().first, lru_.begin());
+    }
+    return Statement(this, std::move(prep));
+}
+
+// The literal a bound value stands for
+static std::string param_text(const Param& p) {
+    if (auto* s = std::get_if<std::string>(&p)) return *s;
+    char buf[16];
+    return std::string(buf, std::to_chars(buf, buf + sizeof buf, std::get<int32_t>(p)).ptr);
+}
+static const std::string& param_text(const std::string& s) { return s; }
+
+// A WHERE value in its column's type, as Bounds holds it: INT as a number
+// (kept as text past the int range), CHAR as text
+static Param to_bound(const Param& v, ColumnType type) {
+    if (type != ColumnType::INT) return std::holds_alternative<std::string>(v) ? v : Param(param_text(v));
+    long long n = bound_int(v);
+    if (n < INT32_MIN || n > INT32_MAX) return v;
+    return static_cast<int32_t>(n);
+}
+
+// The plan is made on first use (the table may not exist when the
+// statement is prepared) and again after the catalog changes. Bound values
+// are used as they are: an INSERT's go to the schema's encoder, a WHERE's
+// into the plan's bounds. The text is never rewritten or parsed again.
+std::optional<std::string> QueryExecutor::execute(Prepared& prep, const std::vector<std::optional<Param>>& args) {
+    try {
+        if (prep.plan.version != cat_->version()) {
+            prep.plan = Plan{};
+            make_plan(prep.query, prep.plan, &prep.params);
+            prep.plan.version = cat_->version();
+        }
+        if (prep.param_count == 0) return reply(run(prep.query, prep.plan));
+
+        for (uint16_t n : prep.params)
+            if (n && !args[n - 1]) throw std::runtime_error("parameter $" + std::to_string(n) + " not bound");
+        if (auto* in = std::get_if<Insert>(&prep.query); in && prep.plan.table) {
+            std::vector<Param> values;
+            values.reserve(in->values.size());
+            for (size_t i = 0; i < in->values.size(); ++i)
+                values.push_back(prep.params[i] ? *args[prep.params[i] - 1] : Param(in->values[i]));
+            return reply(insert_values(*in, *prep.plan.table, values));
+        }
+
+        Plan& p = prep.plan;
+        if (p.table) {
+            ColumnType type = p.table->schema.columns()[p.column].type;
+            if (p.lo_param) p.where.lo = to_bound(*args[p.lo_param - 1], type);
+            if (p.hi_param) p.where.hi = to_bound(*args[p.hi_param - 1], type);
+        }
+        return reply(run(prep.query, p));
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return reply(std::string("ERR: ") + e.what());
+    }
+}
+
+std::optional<std::string> Statement::execute() {
+    if (!prep_) return std::nullopt;
+    return exec_->execute(*prep_, args_);
+}
+
+Statement& Statement::set(size_t i, Param v) {
+    if (i == 0 || i > args_.size()) throw std::out_of_range("no parameter $" + std::to_string(i));
+    args_[i - 1] = std::move(v);
+    return *this;
+}
+
+std::string QueryExecutor::exec_prepare(const Prepare& p) {
+    Statement st = prepare(p.sql, true);
+    if (!st) return "ERR: bad statement";
+    named_[p.name] = std::move(st);
+    return "Prepared";
+}
+
+std::string QueryExecutor::exec_execute(const Execute& e) {
+    auto it = named_.find(e.name);
+    if (it == named_.end()) return "ERR: no prepared statement " + e.name;
+    Statement& st = it->second;
+    if (e.args.size() != st.param_count())
+        return "ERR: " + e.name + " takes " + std::to_string(st.param_count()) + " parameters";
+    for (size_t i = 0; i < e.args.size(); ++i) st.bind(i + 1, e.args[i]);
+    return st.execute().value_or("");
+}
+
 /* ---------- helper impls ---------- */
 
 std::string QueryExecutor::exec_create(const CreateTable& c) {
@@ -28,70 +151,269 @@ std::string QueryExecutor::exec_create(const CreateTable& c) {
     return "Table created";
 }
 
-std::string QueryExecutor::exec_insert(const Insert& in) {
-    if (!cat_->exists(in.table)) return "ERR: no table";
-    auto& tm = cat_->get(in.table);
+std::string QueryExecutor::exec_create_index(const CreateIndex& c) {
+    if (!cat_->exists(c.table)) return "ERR: no table";
+    cat_->create_index(c.table, c.index, c.column, c.hash);
+    return "Index created";
+}
 
-    Tuple tup = tm.schema.serialize(in.values);
-    RID rid;                       // insert into heap
-    if (!tm.heap->insert_tuple(tup, rid)) return "ERR: heap full";
+// "Inserted 3", with ", 1 duplicate key skipped" if a row was left out
+static std::string loaded(const char* verb, size_t rows, size_t dropped) {
+    std::string out = std::string(verb) + " " + std::to_string(rows);
+    if (dropped) out += ", " + std::to_string(dropped) + (dropped == 1 ? " duplicate key" : " duplicate keys") + " skipped";
+    return out;
+}
+
+// Several rows go through the bulk path, which skips a row whose primary
+// key is taken instead of failing the statement
+std::string QueryExecutor::exec_insert(const Insert& in, const Plan& p) {
+    if (!p.table) return "ERR: no table";
+    return insert_values(in, *p.table, in.values);
+}
+
+template <class V>
+std::string QueryExecutor::insert_values(const Insert& in, TableMeta& tm, const std::vector<V>& values) {
+    if (in.rows == 1) return insert_row(tm, values);
 
-    int key = std::stoi(in.values[0]);   // primary key = first INT col
-    tm.index->insert(key, rid);
-    return "Inserted";
+    const Schema& schema = tm.schema;
+    size_t width = schema.columns().size();
+    if (values.size() != in.rows * width) throw std::runtime_error("value/column count mismatch");
+    size_t r = 0, dropped = 0;
+    size_t n = bulk_insert(in.table, [&](std::byte* out) {
+        if (r == in.rows) return false;
+        schema.encode(values.data() + r++ * width, out);
+        return true;
+    }, dropped);
+    return loaded("Inserted", n, dropped);
 }
 
-std::string QueryExecutor::exec_select_all(const SelectAll& s) {
-    if (!cat_->exists(s.table)) return "ERR: no table";
-    auto& tm = cat_->get(s.table);
+// COPY t FROM 'file': records are encoded straight from the read buffer
+std::string QueryExecutor::exec_copy(const Copy& c, const Plan& p) {
+    if (!p.table) return "ERR: no table";
 
-    std::stringstream out;
-    uint32_t page_id = tm.heap->first_page();
+    const Schema& schema = p.table->schema;
+    size_t width = schema.columns().size();
+    CsvReader csv(c.file);
+    std::vector<std::string_view> fields;
+    if (c.header) csv.next(fields);
+    size_t dropped = 0;
+    size_t n = bulk_insert(c.table, [&](std::byte* out) {
+        if (!csv.next(fields)) return false;
+        auto where = [&] { return "line " + std::to_string(csv.line()) + ": "; };
+        if (fields.size() != width)
+            throw std::runtime_error(where() + std::to_string(fields.size()) + " fields, table has " + std::to_string(width));
+        try {
+            schema.encode(fields.data(), out);
+        } catch (const std::exception& e) {
+            throw std::runtime_error(where() + e.what());
+        }
+        return true;
+    }, dropped);
+    return loaded("Copied", n, dropped);
+}
 
-    /* pin first page */
-    Page* page = tm.heap->bpm_->fetch_page(page_id);
-    if (!page) return "ERR: fetch failed";
+template <class V>
+std::string QueryExecutor::insert_row(TableMeta& tm, const std::vector<V>& values) {
+    row_.resize(tm.schema.row_size());
+    tm.schema.encode(values, row_.data());
+    Txn txn = begin();
+    RID rid;                       // insert into heap
+    if (!tm.heap->insert_tuple(TupleView(row_.data(), row_.size()), rid, &txn)) {
+        commit(txn);
+        return "ERR: heap full";
+    }
 
-    const std::byte* raw = page->data();
-    uint16_t slot_cnt = *reinterpret_cast<const uint16_t*>(raw + 2); // slot-count at offset 2
+    // every index; a primary key clash takes the row back out
+    for (size_t i = 0; i < tm.indexes.size(); ++i) {
+        auto& idx = tm.indexes[i];
+        if (idx->insert(param_text(values[idx->column()]), rid)) continue;
+        for (size_t j = 0; j < i; ++j) tm.indexes[j]->remove(param_text(values[tm.indexes[j]->column()]), rid);
+        tm.heap->delete_tuple(rid, &txn);
+        commit(txn);
+        return "ERR: duplicate key";
+    }
+    commit(txn);
+    return "Inserted 1";
+}
 
-    for (uint16_t slot = 0; slot < slot_cnt; ++slot) {
-        RID r(page_id, slot);
-        Tuple t;
-        if (!tm.heap->get_tuple(r, t)) continue;          // skip deleted / empty
-        for (auto& v : tm.schema.deserialize(t)) out << v << ' ';
-        out << '\n';
+template <class Next>
+size_t QueryExecutor::bulk_insert(const std::string& table, Next next, size_t& dropped) {
+    TableMeta& tm = cat_->get(table);
+    row_.resize(tm.schema.row_size());
+    Txn txn = begin();
+    TableHeap::Appender app(*tm.heap, &txn);
+    try {
+        RID rid;
+        while (next(row_.data()))
+            if (!app.append(TupleView(row_.data(), row_.size()), rid)) throw std::runtime_error("heap full");
+        app.finish();
+    } catch (...) {
+        // Take back what was appended; the indexes never saw it
+        app.finish();
+        auto it = tm.heap->scan(app.first_pos());
+        RID rid;
+        TupleView t;
+        while (it.next(t, rid)) tm.heap->delete_tuple(rid, &txn);
+        commit(txn);
+        throw;
     }
+    dropped = cat_->index_appended(table, app.first_pos(), app.rows(), &txn);
+    commit(txn);
+    return app.rows() - dropped;
+}
+
+/* ---------- plans ---------- */
+
+// An equality predicate goes to a hash index on the column if there is one
+// (a single bucket read); otherwise an ordered index on the column is
+// walked from the lower bound to the upper one and rows come in value
+// order; with neither the heap is scanned and filtered. A prepared
+// BETWEEN $1 AND $2 is planned as a range, BETWEEN $1 AND $1 as equality.
+// Constant bounds are converted to the column's type here, once.
+void QueryExecutor::make_plan(const Query& q, Plan& p, const std::vector<uint16_t>* params) {
+    auto table = [&](const std::string& name) {
+        p.table = cat_->exists(name) ? &cat_->get(name) : nullptr;
+        return p.table != nullptr;
+    };
+    // Parameter number of literal i
+    auto param = [&](size_t i) -> uint16_t { return params && i < params->size() ? (*params)[i] : 0; };
+    auto where = [&](const Range& r, uint16_t lo_param, uint16_t hi_param) {
+        p.column = p.table->column(r.col);
+        bool equality = r.lo && r.hi && r.lo_incl && r.hi_incl && *r.lo == *r.hi;
+        p.index = p.table->index_on(p.column, equality);
+
+        ColumnType type = p.table->schema.columns()[p.column].type;
+        p.where.lo_incl = r.lo_incl;
+        p.where.hi_incl = r.hi_incl;
+        if (r.lo) {
+            p.lo_param = lo_param;
+            if (!lo_param) p.where.lo = to_bound(*r.lo, type);
+        }
+        if (r.hi) {
+            p.hi_param = hi_param;
+            if (!hi_param) p.where.hi = to_bound(*r.hi, type);
+        }
+    };
+    // A range's literals are its bounds, lo first
+    auto range = [&](const Range& r) { where(r, param(0), param(r.lo ? 1 : 0)); };
+    auto select = [&](const SelectOutput& o) {
+        for (const auto& name : o.columns) p.projection.push_back(p.table->column(name));
+        for (const auto& a : o.aggregates) p.aggregates.push_back(AggSpec{ a.func, a.col.empty() ? 0 : p.table->column(a.col) });
+        if (o.group_by) p.group = p.table->column(*o.group_by);
+    };
+    std::visit([&](auto&& cmd) {
+        using T = std::decay_t<decltype(cmd)>;
+        if constexpr (std::is_same_v<T, Insert> || std::is_same_v<T, Copy>) table(cmd.table);
+        if constexpr (std::is_same_v<T, SelectAll>) {
+            if (table(cmd.table)) select(cmd.output);
+        }
+        if constexpr (std::is_same_v<T, SelectWhere>) {
+            if (table(cmd.table)) where(Range{ cmd.col, cmd.value, cmd.value }, param(0), param(0)), select(cmd.output);
+        }
+        if constexpr (std::is_same_v<T, SelectRange>) {
+            if (table(cmd.table)) range(cmd.range), select(cmd.output);
+        }
+        if constexpr (std::is_same_v<T, DeleteWhere>) {
+            if (table(cmd.table)) where(Range{ cmd.col, cmd.value, cmd.value }, param(0), param(0));
+        }
+        if constexpr (std::is_same_v<T, DeleteRange>) {
+            if (table(cmd.table)) range(cmd.range);
+        }
+        }, q);
+}
+
+std::unique_ptr<Operator> QueryExecutor::plan_rows(const Plan& p, bool where) {
+    TableMeta& tm = *p.table;
+    if (!where) return std::make_unique<SeqScan>(tm);
+    if (p.index) return std::make_unique<IndexScan>(tm, p.index, p.where);
+    return std::make_unique<Filter>(std::make_unique<SeqScan>(tm), p.column, p.where);
+}
+
+std::unique_ptr<Operator> QueryExecutor::plan_output(const Plan& p, std::unique_ptr<Operator> rows, const SelectOutput& o) {
+    if (p.group) rows = std::make_unique<HashAggregate>(std::move(rows), *p.group, p.aggregates);
+    else if (!p.aggregates.empty()) rows = std::make_unique<Aggregate>(std::move(rows), p.aggregates);
+    if (!p.projection.empty()) rows = std::make_unique<Projection>(std::move(rows), p.projection);
+    if (o.limit) rows = std::make_unique<Limit>(std::move(rows), *o.limit);
+    return rows;
+}
+
+/* ---------- sink ---------- */
+
+// Every reply is whole lines, each ended by '\n': a SELECT's rows, or one
+// message ("Inserted 1", "Deleted 3", "NOT FOUND", "ERR: ..."). A reply
+// that already is one (a nested EXECUTE) is left as it is.
+std::string QueryExecutor::reply(std::string out) {
+    if (out.empty() || out.back() != '\n') out += '\n';
+    return out;
+}
 
-    tm.heap->bpm_->unpin_page(page_id, false);            // dont mark dirty
-    return out.str();
+// A SELECT's rows, one per line, each value followed by a space; "NOT
+// FOUND" if there are none
+static std::string print_rows(Operator& plan) {
+    std::string out;
+    Batch b;
+    while (plan.next(b)) {
+        for (size_t r = 0; r < b.size(); ++r) {
+            for (const ColumnVector& col : b.columns) {
+                if (col.is_null(r)) {
+                    out += "NULL";
+                } else if (col.type == ColumnType::CHAR) {
+                    out += col.get_char(r);
+                } else {
+                    char buf[32];
+                    char* end;
+                    if (col.type == ColumnType::INT)         end = std::to_chars(buf, buf + sizeof buf, col.get_int(r)).ptr;
+                    else if (col.type == ColumnType::BIGINT) end = std::to_chars(buf, buf + sizeof buf, col.get_long(r)).ptr;
+                    else                                     end = std::to_chars(buf, buf + sizeof buf, col.get_double(r)).ptr;
+                    out.append(buf, end);
+                }
+                out += ' ';
+            }
+            out += '\n';
+        }
+    }
+    return out.empty() ? "NOT FOUND" : out;
 }
 
+std::string QueryExecutor::exec_select_all(const SelectAll& s, const Plan& p) {
+    if (!p.table) return "ERR: no table";
+    return print_rows(*plan_output(p, plan_rows(p, false), s.output));
+}
 
+std::string QueryExecutor::exec_select_where(const SelectWhere& sw, const Plan& p) {
+    if (!p.table) return "ERR: no table";
+    return print_rows(*plan_output(p, plan_rows(p, true), sw.output));
+}
 
-std::string QueryExecutor::exec_select_where(const SelectWhere& sw) {
-    if (!cat_->exists(sw.table)) return "ERR: no table";
-    auto& tm = cat_->get(sw.table);
+std::string QueryExecutor::exec_select_range(const SelectRange& sr, const Plan& p) {
+    if (!p.table) return "ERR: no table";
+    return print_rows(*plan_output(p, plan_rows(p, true), sr.output));
+}
 
-    int key = std::stoi(sw.value);
-    auto ridOpt = tm.index->search(key);
-    if (!ridOpt) return "NOT FOUND";
+std::string QueryExecutor::exec_delete_where(const DeleteWhere&, const Plan& p) {
+    if (!p.table) return "ERR: no table";
+    return delete_where(p);
+}
 
-    Tuple t; tm.heap->get_tuple(*ridOpt, t);
-    std::stringstream ss;
-    for (auto& v : tm.schema.deserialize(t)) ss << v << ' ';
-    return ss.str();
+std::string QueryExecutor::exec_delete_range(const DeleteRange&, const Plan& p) {
+    if (!p.table) return "ERR: no table";
+    return delete_where(p);
 }
 
-std::string QueryExecutor::exec_delete_where(const DeleteWhere& dw) {
-    if (!cat_->exists(dw.table)) return "ERR: no table";
-    auto& tm = cat_->get(dw.table);
+// Remove the rows from every index, then from the heap, as one transaction
+std::string QueryExecutor::delete_where(const Plan& p) {
+    Delete plan(plan_rows(p, true), *p.table, cat_->log());
+    Batch b;
+    plan.next(b);
+    int32_t n = b.columns[0].get_int(0);
+    if (n == 0) return "NOT FOUND";
+    return "Deleted " + std::to_string(n);
+}
 
-    int key = std::stoi(dw.value);
-    auto ridOpt = tm.index->search(key);
-    if (!ridOpt) return "NOT FOUND";
+Txn QueryExecutor::begin() {
+    return cat_->log() ? cat_->log()->begin() : Txn{};
+}
 
-    tm.heap->delete_tuple(*ridOpt);
-    tm.index->remove(key);
-    return "Deleted";
+void QueryExecutor::commit(Txn& txn) {
+    if (cat_->log()) cat_->log()->commit(txn);
 }
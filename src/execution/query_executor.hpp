@@ -1,21 +1,153 @@
 #pragma once
+#include <list>
 #include <string>
+#include <string_view>
 #include <optional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 #include "../storage/catalog.hpp"          // ? root-level catalog
 #include "../parser/query.hpp"
+#include "operators.hpp"
+
+class QueryExecutor;
+
+// What planning decides for a statement: its table, the access path for
+// its WHERE and the columns it returns. A prepared statement keeps its
+// plan until the catalog changes; values bound to a WHERE's parameters
+// are written into where before each execution.
+struct Plan {
+    uint64_t            version = 0;       // Catalog::version() it was made for; 0: none yet
+    TableMeta*          table = nullptr;   // null: no such table
+    size_t              column = 0;        // the WHERE column
+    Index*              index = nullptr;   // answers the WHERE; null: scan and filter
+    Bounds              where;             // the WHERE's bounds, in the column's type
+    uint16_t            lo_param = 0;      // the $n a bound is bound to; 0: a constant
+    uint16_t            hi_param = 0;
+    std::vector<size_t> projection;        // the SELECT list; empty: every column
+    std::vector<AggSpec> aggregates;       // an aggregate SELECT's list
+    std::optional<size_t> group;           // its GROUP BY column
+};
+
+// A statement parsed once, with its plan; shared by the plan cache and
+// every Statement made from the same text
+struct Prepared {
+    Query                 query;
+    std::vector<uint16_t> params;          // per literal, its parameter number (0: a constant)
+    size_t                param_count = 0; // highest $n
+    Plan                  plan;
+};
+
+/*
+ * A prepared statement: bind values to its parameters ($1, $2, ...),
+ * execute, bind again. Bindings are kept until replaced or cleared.
+ * False if the text did not parse.
+ *
+ *   Statement st = exec.prepare("INSERT INTO t VALUES ($1, $2)");
+ *   st.bind(1, 42).bind(2, "alice");
+ *   st.execute();
+ */
+class Statement {
+public:
+    Statement() = default;
+
+    explicit operator bool() const { return prep_ != nullptr; }
+    size_t param_count() const { return prep_ ? prep_->param_count : 0; }
+
+    // Value of parameter $i (from 1); throws std::out_of_range past param_count()
+    Statement& bind(size_t i, int32_t v) { return set(i, Param(v)); }
+    Statement& bind(size_t i, std::string v) { return set(i, Param(std::move(v))); }
+    void clear_bindings() { args_.assign(args_.size(), std::nullopt); }
+
+    // As QueryExecutor::execute; an unbound parameter is an error
+    std::optional<std::string> execute();
+
+private:
+    friend class QueryExecutor;
+    Statement(QueryExecutor* exec, std::shared_ptr<Prepared> prep)
+        : exec_(exec), prep_(std::move(prep)), args_(prep_->param_count) {}
+    Statement& set(size_t i, Param v);
+
+    QueryExecutor*                    exec_ = nullptr;
+    std::shared_ptr<Prepared>         prep_;
+    std::vector<std::optional<Param>> args_;
+};
 
 class QueryExecutor {
 public:
+    static constexpr size_t PLAN_CACHE_SIZE = 1024;   // statements
+
     explicit QueryExecutor(Catalog* cat) : cat_(cat) {}
+    // The reply to q: its rows or a message, each line ended by '\n'
     std::optional<std::string> execute(const Query& q);
 
+    // The statement for sql: from the plan cache, which is keyed by the
+    // text, or parsed. Only a statement with parameters is added to the
+    // cache (and any PREPAREd one): ad hoc text is seldom seen twice.
+    // Empty if sql does not parse.
+    Statement prepare(const std::string& sql);
+
 private:
+    friend class Statement;
+
     Catalog* cat_;
+    std::vector<std::byte> row_;   // the row being inserted, encoded
+    // Parsed statements by text, the most recently used first; when full
+    // the least recently used is dropped (Statements made from it keep it
+    // alive). The map's keys are the list's strings.
+    using CachedPlan = std::pair<std::string, std::shared_ptr<Prepared>>;
+    std::list<CachedPlan>                                            lru_;
+    std::unordered_map<std::string_view, std::list<CachedPlan>::iterator> plans_;
+    std::unordered_map<std::string, Statement>                       named_;   // PREPARE name
+
+    // As prepare(sql); keep: cache it even without parameters
+    Statement prepare(const std::string& sql, bool keep);
+    std::optional<std::string> execute(Prepared& p, const std::vector<std::optional<Param>>& args);
+
+    // Resolve q's table, WHERE column, bounds and index, and SELECT list
+    // into p. params: per literal, its parameter number (as in Prepared);
+    // a parameter's bound is left for execute() to fill.
+    void make_plan(const Query& q, Plan& p, const std::vector<uint16_t>* params = nullptr);
+    std::string run(const Query& q, const Plan& p);
+    // What execute() returns for a result of run(): whole lines
+    static std::string reply(std::string out);
 
     /* helpers */
     std::string exec_create(const CreateTable&);
-    std::string exec_insert(const Insert&);
-    std::string exec_select_all(const SelectAll&);
-    std::string exec_select_where(const SelectWhere&);
-    std::string exec_delete_where(const DeleteWhere&);
+    std::string exec_create_index(const CreateIndex&);
+    std::string exec_insert(const Insert&, const Plan&);
+    std::string exec_select_all(const SelectAll&, const Plan&);
+    std::string exec_select_where(const SelectWhere&, const Plan&);
+    std::string exec_delete_where(const DeleteWhere&, const Plan&);
+    std::string exec_select_range(const SelectRange&, const Plan&);
+    std::string exec_delete_range(const DeleteRange&, const Plan&);
+    std::string exec_prepare(const Prepare&);
+    std::string exec_execute(const Execute&);
+    std::string exec_copy(const Copy&, const Plan&);
+
+    // in's rows from values, row after row, into tm; V is std::string or Param
+    template <class V>
+    std::string insert_values(const Insert& in, TableMeta& tm, const std::vector<V>& values);
+    // One row into the heap and every index
+    template <class V>
+    std::string insert_row(TableMeta& tm, const std::vector<V>& values);
+    // Rows from next(out), which encodes one at out and returns false
+    // after the last, appended to the heap as one transaction; then the
+    // indexes catch up. If next throws, no row is kept. Returns the rows
+    // kept, and dropped has those whose primary key was taken.
+    template <class Next>
+    size_t bulk_insert(const std::string& table, Next next, size_t& dropped);
+
+    // The plan's rows, restricted to its WHERE bounds if where: through its
+    // index, else a heap scan under a filter
+    std::unique_ptr<Operator> plan_rows(const Plan& p, bool where);
+    // The rows topped with the SELECT's projection or aggregation, and limit
+    std::unique_ptr<Operator> plan_output(const Plan& p, std::unique_ptr<Operator> rows, const SelectOutput& o);
+    // DELETE of the rows within the plan's WHERE bounds; the reply names the count
+    std::string delete_where(const Plan& p);
+
+    // Each statement that changes rows is one transaction: begin() logs its
+    // BEGIN, commit() returns once its COMMIT is durable (no-ops without a log)
+    Txn begin();
+    void commit(Txn& txn);
 };
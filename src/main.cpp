@@ -1,21 +1,59 @@
 #include "storage/disk_manager.hpp"
 #include "storage/buffer_pool_manager.hpp"
+#include "storage/replacer_factory.hpp"
 #include "storage/catalog.hpp"
+#include "recovery/log_manager.hpp"
+#include "recovery/recovery_manager.hpp"
 #include "parser/query_parser.hpp"
 #include "execution/query_executor.hpp"
 
-int main() {
-    DiskManager dm("mydb.data");
-    BufferPoolManager bpm(32, &dm);
-    Catalog catalog(&bpm);
+#include <iostream>
+
+int main(int argc, char** argv) {
+    // Optional arguments: number of buffer-pool frames, replacement policy,
+    // I/O mode (pread, direct, uring, uring-direct). Not mmap: the kernel
+    // writes mapped pages back before their log records are durable.
+    size_t pool_frames = argc > 1 ? std::stoul(argv[1]) : 32;
+    std::string policy = argc > 2 ? argv[2] : "lru";
+    std::string io = argc > 3 ? argv[3] : "pread";
+
+    // The log is declared first so that it outlives the pool's final flush
+    auto dm = make_disk_manager("mydb.data", io);
+    if (dm->mapped()) {
+        std::cerr << "mmap cannot keep the write-ahead log; use pread, direct, uring or uring-direct\n";
+        return 1;
+    }
+    LogManager log("mydb.log");
+    BufferPoolManager bpm(pool_frames, dm.get(), make_replacer(policy, pool_frames));
+    bpm.set_log_manager(&log);
+
+    // Bring the data file back to the state of the log, then keep restart short
+    RecoveryManager recovery(&bpm, &log);
+    auto stats = recovery.recover();
+    if (stats.redone || stats.losers) {
+        std::cout << "recovered: " << stats.redone << " changes redone, "
+            << stats.losers << " transactions rolled back\n";
+    }
+    recovery.start_checkpoints(std::chrono::seconds(5));
+
+    // Tables from the header and catalog pages; their indexes are rebuilt
+    // only if the last run did not shut down cleanly
+    Catalog catalog(&bpm, &log);
     QueryExecutor exec(&catalog);
 
     std::string line;
     std::cout << "Mini-SQL> ";
     while (std::getline(std::cin, line)) {
+        // Ad hoc text is parsed every time: only statements with parameters
+        // and PREPAREd ones go through the plan cache
         auto q = QueryParser::parse(line);
         if (!q) { std::cout << "parse error\nMini-SQL> "; continue; }
-        if (auto res = exec.execute(*q)) std::cout << *res << "\n";
+        if (auto res = exec.execute(*q)) std::cout << *res;
         std::cout << "Mini-SQL> ";
     }
+
+    // Clean shutdown: nothing for the next restart to redo or rebuild
+    bpm.flush_all_pages();
+    recovery.checkpoint();
+    catalog.close();
 }
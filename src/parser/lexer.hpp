@@ -0,0 +1,81 @@
+/*************************  parser/lexer.hpp  *************************
+ * Single-pass tokenizer for the SQL subset. Tokens are string_views into
+ * the statement, so lexing allocates nothing (and the statement must
+ * outlive its tokens).
+ *
+ *   SYMBOL  ( ) , ; * = < > <= >=
+ *   STRING  '...'; text is what lies between the quotes (no escapes)
+ *   WORD    any other run of characters up to blank or a symbol:
+ *           keywords, names, numbers, bare literals such as -5
+ *   END     end of the statement
+ *   BAD     a quote that is never closed
+ *****************************************************************/
+#pragma once
+#include <cstdint>
+#include <string_view>
+
+enum class TokenKind : uint8_t { END, WORD, STRING, SYMBOL, BAD };
+
+struct Token {
+    TokenKind        kind = TokenKind::END;
+    std::string_view text;
+
+    bool is(char symbol) const { return kind == TokenKind::SYMBOL && text.size() == 1 && text[0] == symbol; }
+    // A WORD equal to kw (upper case) ignoring case
+    bool is_keyword(std::string_view kw) const {
+        if (kind != TokenKind::WORD || text.size() != kw.size()) return false;
+        for (size_t i = 0; i < kw.size(); ++i)
+            if ((text[i] & ~0x20) != kw[i]) return false;    // ASCII upper-casing
+        return true;
+    }
+    // A WORD of letters, digits and '_' (what \w+ used to accept)
+    bool is_name() const {
+        if (kind != TokenKind::WORD) return false;
+        for (char c : text)
+            if (!is_name_char(c)) return false;
+        return true;
+    }
+
+    static bool is_name_char(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    }
+};
+
+class Lexer {
+public:
+    explicit Lexer(std::string_view s) : s_(s) {}
+
+    std::string_view source() const { return s_; }
+
+    Token next() {
+        while (pos_ < s_.size() && is_blank(s_[pos_])) ++pos_;
+        if (pos_ == s_.size()) return { TokenKind::END, {} };
+
+        size_t start = pos_;
+        char c = s_[pos_++];
+        if (c == '\'') {
+            size_t close = s_.find('\'', pos_);
+            if (close == std::string_view::npos) {
+                pos_ = s_.size();
+                return { TokenKind::BAD, s_.substr(start) };
+            }
+            pos_ = close + 1;
+            return { TokenKind::STRING, s_.substr(start + 1, close - start - 1) };
+        }
+        if (is_symbol(c)) {
+            if ((c == '<' || c == '>') && pos_ < s_.size() && s_[pos_] == '=') ++pos_;
+            return { TokenKind::SYMBOL, s_.substr(start, pos_ - start) };
+        }
+        while (pos_ < s_.size() && !is_blank(s_[pos_]) && !is_symbol(s_[pos_]) && s_[pos_] != '\'') ++pos_;
+        return { TokenKind::WORD, s_.substr(start, pos_ - start) };
+    }
+
+private:
+    static bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v'; }
+    static bool is_symbol(char c) {
+        return c == '(' || c == ')' || c == ',' || c == ';' || c == '*' || c == '=' || c == '<' || c == '>';
+    }
+
+    std::string_view s_;
+    size_t           pos_ = 0;
+};
@@ -2,22 +2,124 @@
 #include <string>
 #include <vector>
 #include <variant>
+#include <optional>
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
 
-enum class ColumnType { INT, CHAR };
+// BIGINT and DOUBLE are never a table's: only aggregates return them
+enum class ColumnType { INT, CHAR, BIGINT, DOUBLE };
 
-struct ColumnDef { std::string name; ColumnType type; std::size_t len; };
+struct ColumnDef {
+    std::string name; ColumnType type; std::size_t len;
+    bool operator==(const ColumnDef&) const = default;
+};
 
 /*  AST  */
 struct CreateTable {
     std::string              table;
     std::vector<ColumnDef>   columns;
+    bool operator==(const CreateTable&) const = default;
+};
+struct CreateIndex {
+    std::string              index;
+    std::string              table;
+    std::string              column;
+    bool                     hash = false;   // USING HASH: equality lookups only
+    bool operator==(const CreateIndex&) const = default;
 };
+// INSERT INTO t VALUES (...), (...): every row has the same number of values
 struct Insert {
     std::string              table;
-    std::vector<std::string> values;   // raw literals
+    std::vector<std::string> values;   // raw literals, row after row
+    size_t                   rows = 1;
+    bool operator==(const Insert&) const = default;
+};
+// COPY t FROM 'file': one row per CSV record
+struct Copy {
+    std::string              table;
+    std::string              file;
+    bool                     header = false;   // HEADER: the first record is not a row
+    bool operator==(const Copy&) const = default;
 };
-struct SelectAll { std::string table; };
-struct SelectWhere { std::string table; std::string col; std::string value; };
-struct DeleteWhere { std::string table; std::string col; std::string value; };
+// One item of an aggregate SELECT list: COUNT(*) (col empty), f(col), or
+// (NONE) the GROUP BY column itself
+enum class AggFunc : uint8_t { NONE, COUNT, SUM, MIN, MAX, AVG };
+struct AggItem {
+    AggFunc     func = AggFunc::NONE;
+    std::string col;
+    bool operator==(const AggItem&) const = default;
+};
+
+// What a SELECT returns: the named columns in that order (none: SELECT *),
+// or one row per group of the aggregates (a single group without GROUP
+// BY); and at most limit rows
+struct SelectOutput {
+    std::vector<std::string>   columns;
+    std::optional<size_t>      limit;
+    std::vector<AggItem>       aggregates;   // an aggregate SELECT's list, in place of columns
+    std::optional<std::string> group_by;
+    bool operator==(const SelectOutput&) const = default;
+};
+struct SelectAll { std::string table; SelectOutput output; bool operator==(const SelectAll&) const = default; };
+struct SelectWhere { std::string table; std::string col; std::string value; SelectOutput output; bool operator==(const SelectWhere&) const = default; };
+struct DeleteWhere { std::string table; std::string col; std::string value; bool operator==(const DeleteWhere&) const = default; };
+
+// col < / <= / > / >= value, or col BETWEEN lo AND hi; a missing bound is open
+struct Range {
+    std::string                col;
+    std::optional<std::string> lo, hi;   // raw literals
+    bool                       lo_incl = true, hi_incl = true;
+    bool operator==(const Range&) const = default;
+};
+struct SelectRange { std::string table; Range range; SelectOutput output; bool operator==(const SelectRange&) const = default; };
+struct DeleteRange { std::string table; Range range; bool operator==(const DeleteRange&) const = default; };
+
+// PREPARE name AS statement: the statement's text, in which a bare $n is
+// parameter n (from 1)
+struct Prepare { std::string name; std::string sql; bool operator==(const Prepare&) const = default; };
+// EXECUTE name(v, ...): the literals for $1, $2, ...
+struct Execute {
+    std::string              name;
+    std::vector<std::string> args;     // raw literals
+    bool operator==(const Execute&) const = default;
+};
+
+using Query = std::variant<CreateTable, CreateIndex, Insert, SelectAll, SelectWhere, DeleteWhere,
+                           SelectRange, DeleteRange, Prepare, Execute, Copy>;
+
+// A value bound to a parameter: an INT as a number, or text as the
+// statement would have spelled the literal
+using Param = std::variant<int32_t, std::string>;
+
+// A WHERE's bounds as the plan hands them to Filter and Index::scan, in
+// the column's type: a number for INT (text only for a literal past the
+// int range), text for CHAR. A missing bound is open.
+struct Bounds {
+    std::optional<Param> lo, hi;
+    bool                 lo_incl = true, hi_incl = true;
+};
+
+// An INT bound as a number; a literal past the int range is clamped to one
+// past it, which matches the same values and leaves room for a strict
+// bound's step inwards
+inline long long bound_int(const Param& p) {
+    if (auto* v = std::get_if<int32_t>(&p)) return *v;
+    return std::clamp<long long>(std::stoll(std::get<std::string>(p)), INT32_MIN - 1LL, INT32_MAX + 1LL);
+}
 
-using Query = std::variant<CreateTable, Insert, SelectAll, SelectWhere, DeleteWhere>;
+// f(literal) for every literal of q, in the order they appear in the text
+template <class F>
+void for_each_literal(Query& q, F&& f) {
+    std::visit([&](auto& s) {
+        using T = std::decay_t<decltype(s)>;
+        auto range = [&](Range& r) {
+            if (r.lo) f(*r.lo);
+            if (r.hi) f(*r.hi);
+        };
+        if constexpr (std::is_same_v<T, Insert>)       for (auto& v : s.values) f(v);
+        if constexpr (std::is_same_v<T, Execute>)      for (auto& v : s.args) f(v);
+        if constexpr (std::is_same_v<T, SelectWhere> || std::is_same_v<T, DeleteWhere>) f(s.value);
+        if constexpr (std::is_same_v<T, SelectRange> || std::is_same_v<T, DeleteRange>) range(s.range);
+    }, q);
+}
@@ -1,84 +1,300 @@
 #include "query_parser.hpp"
-#include <regex>
-#include <sstream>
-#include <cctype>
+#include "lexer.hpp"
+#include <algorithm>
+#include <charconv>
 
-static inline void trim(std::string& s) {
-    while (!s.empty() && std::isspace(s.front())) s.erase(s.begin());
-    while (!s.empty() && std::isspace(s.back()))  s.pop_back();
-}
+/*
+ * Recursive descent over the Lexer's tokens, one token of lookahead.
+ * Keywords are case-insensitive; names are \w+ words; a literal is a
+ * quoted string or any bare word (the executor checks it against the
+ * column's type). A statement may end in ';'.
+ *
+ * With a params list, a bare $n literal is parameter n: the list gets
+ * one entry per literal, in for_each_literal order, holding n for a
+ * parameter and 0 for a constant.
+ */
+namespace {
 
-static ColumnType parse_type(const std::string& t, std::size_t& charLen) {
-    if (t == "int" || t == "INT") return ColumnType::INT;
-    std::smatch m;
-    std::regex rg(R"(CHAR\s*\(\s*(\d+)\s*\))", std::regex::icase);
-    if (std::regex_match(t, m, rg)) { charLen = std::stoul(m[1]); return ColumnType::CHAR; }
-    throw std::runtime_error("bad type");
-}
+struct ParseError {};
 
-std::optional<Query> QueryParser::parse(const std::string& in) {
-    std::string s = in; trim(s);
-
-    /* CREATE TABLE */
-    {
-        std::regex rg(R"(CREATE\s+TABLE\s+(\w+)\s*\((.+)\)\s*;?)", std::regex::icase);
-        std::smatch m;
-        if (std::regex_match(s, m, rg)) {
-            CreateTable q; q.table = m[1];
-            std::string cols = m[2];
-            std::stringstream ss(cols); std::string col;
-            while (std::getline(ss, col, ',')) {
-                trim(col);
-                auto pos = col.find(' ');
-                std::string name = col.substr(0, pos);
-                std::string typ = col.substr(pos + 1);
-                trim(typ);
-                std::size_t clen = 0;
-                ColumnType ct = parse_type(typ, clen);
-                q.columns.push_back({ name,ct,clen });
-            }
-            return q;
+class Parser {
+public:
+    Parser(std::string_view s, std::vector<uint16_t>* params) : lex_(s), params_(params) { tok_ = lex_.next(); }
+
+    Query statement() {
+        if (accept_keyword("PREPARE")) return prepare();
+        if (accept_keyword("EXECUTE")) return finish(execute());
+        return inner_statement();
+    }
+
+private:
+    /* ---------- statements ---------- */
+
+    // Any statement but PREPARE and EXECUTE
+    Query inner_statement() {
+        if (accept_keyword("CREATE")) {
+            if (accept_keyword("TABLE")) return finish(create_table());
+            expect_keyword("INDEX");
+            return finish(create_index());
         }
+        if (accept_keyword("INSERT")) return finish(insert());
+        if (accept_keyword("SELECT")) return finish(select());
+        if (accept_keyword("DELETE")) return finish(del());
+        if (accept_keyword("COPY")) return finish(copy());
+        throw ParseError{};
     }
-    /* INSERT */
-    {
-        std::regex rg(R"(INSERT\s+INTO\s+(\w+)\s+VALUES\s*\((.+)\)\s*;?)", std::regex::icase);
-        std::smatch m;
-        if (std::regex_match(s, m, rg)) {
-            Insert q; q.table = m[1];
-            std::string vals = m[2];
-            std::stringstream ss(vals); std::string tok;
-            while (std::getline(ss, tok, ',')) {
-                trim(tok);
-                if (tok.front() == '\'') tok = tok.substr(1, tok.size() - 2);
-                q.values.push_back(tok);
+
+    // PREPARE name AS statement; the statement must parse on its own
+    Prepare prepare() {
+        Prepare q;
+        q.name = name();
+        expect_keyword("AS");
+        if (tok_.kind != TokenKind::WORD) throw ParseError{};
+        std::string_view sql = lex_.source().substr(tok_.text.data() - lex_.source().data());
+        std::vector<uint16_t> params;
+        Parser(sql, &params).inner_statement();
+        q.sql = sql;
+        return q;
+    }
+
+    // EXECUTE name [(v, ...)]
+    Execute execute() {
+        Execute q;
+        q.name = name();
+        if (accept('(') && !accept(')')) {
+            do q.args.emplace_back(literal());
+            while (accept(','));
+            expect(')');
+        }
+        return q;
+    }
+
+    // CREATE TABLE t (col INT | CHAR(n), ...)
+    CreateTable create_table() {
+        CreateTable q;
+        q.table = name();
+        expect('(');
+        do {
+            ColumnDef col{ std::string(name()), ColumnType::INT, 0 };
+            if (accept_keyword("CHAR")) {
+                col.type = ColumnType::CHAR;
+                expect('(');
+                col.len = number();
+                expect(')');
+            } else {
+                expect_keyword("INT");
             }
-            return q;
+            q.columns.push_back(std::move(col));
+        } while (accept(','));
+        expect(')');
+        return q;
+    }
+
+    // CREATE INDEX i ON t (col) [USING HASH | BTREE]
+    CreateIndex create_index() {
+        CreateIndex q;
+        q.index = name();
+        expect_keyword("ON");
+        q.table = name();
+        expect('(');
+        q.column = name();
+        expect(')');
+        if (accept_keyword("USING")) {
+            if (accept_keyword("HASH")) q.hash = true;
+            else expect_keyword("BTREE");
+        }
+        return q;
+    }
+
+    // INSERT INTO t VALUES (v, ...) [, (v, ...) ...]; rows of equal length
+    Insert insert() {
+        Insert q;
+        expect_keyword("INTO");
+        q.table = name();
+        expect_keyword("VALUES");
+        q.rows = 0;
+        size_t width = 0;
+        do {
+            expect('(');
+            do q.values.emplace_back(literal());
+            while (accept(','));
+            expect(')');
+            if (++q.rows == 1) width = q.values.size();
+            else if (q.values.size() != q.rows * width) throw ParseError{};
+        } while (accept(','));
+        return q;
+    }
+
+    // COPY t FROM 'file' [HEADER]
+    Copy copy() {
+        Copy q;
+        q.table = name();
+        expect_keyword("FROM");
+        if (tok_.kind != TokenKind::STRING) throw ParseError{};
+        q.file = take();
+        q.header = accept_keyword("HEADER");
+        return q;
+    }
+
+    // SELECT * | item, ... FROM t [WHERE cond] [GROUP BY col] [LIMIT n]
+    Query select() {
+        SelectOutput out;
+        if (!accept('*')) {
+            do out.aggregates.push_back(select_item());
+            while (accept(','));
         }
+        expect_keyword("FROM");
+        std::string table(name());
+        if (!accept_keyword("WHERE")) return SelectAll{ std::move(table), tail(std::move(out)) };
+
+        std::string col(name());
+        if (accept('=')) {
+            std::string value(literal());
+            return SelectWhere{ std::move(table), std::move(col), std::move(value), tail(std::move(out)) };
+        }
+        Range r = range(std::move(col));
+        return SelectRange{ std::move(table), std::move(r), tail(std::move(out)) };
+    }
+
+    // col, or COUNT(*) / COUNT(col) / SUM / MIN / MAX / AVG(col)
+    AggItem select_item() {
+        static constexpr std::pair<std::string_view, AggFunc> FUNCS[] = {
+            { "COUNT", AggFunc::COUNT }, { "SUM", AggFunc::SUM }, { "MIN", AggFunc::MIN },
+            { "MAX", AggFunc::MAX }, { "AVG", AggFunc::AVG },
+        };
+        Token word = tok_;
+        AggItem item{ AggFunc::NONE, std::string(name()) };
+        if (!accept('(')) return item;
+
+        auto f = std::find_if(std::begin(FUNCS), std::end(FUNCS), [&](const auto& e) { return word.is_keyword(e.first); });
+        if (f == std::end(FUNCS)) throw ParseError{};
+        item.func = f->second;
+        item.col.clear();
+        if (!accept('*')) item.col = name();
+        else if (item.func != AggFunc::COUNT) throw ParseError{};
+        expect(')');
+        return item;
     }
-    /* SELECT * WHERE / SELECT * */
-    {
-        std::regex rg1(R"(SELECT\s+\*\s+FROM\s+(\w+)\s*;?)", std::regex::icase);
-        std::regex rg2(R"(SELECT\s+\*\s+FROM\s+(\w+)\s+WHERE\s+(\w+)\s*=\s*('?[\w\d]+'?)\s*;?)", std::regex::icase);
-        std::smatch m;
-        if (std::regex_match(s, m, rg2)) {
-            SelectWhere q{ m[1],m[2],m[3] };
-            if (q.value.front() == '\'') q.value = q.value.substr(1, q.value.size() - 2);
-            return q;
+
+    // [GROUP BY col] [LIMIT n] into out. Without an aggregate or a GROUP BY
+    // the list is plain columns.
+    SelectOutput tail(SelectOutput out) {
+        if (accept_keyword("GROUP")) {
+            expect_keyword("BY");
+            out.group_by = name();
         }
-        if (std::regex_match(s, m, rg1)) {
-            return SelectAll{ m[1] };
+        bool aggregate = out.group_by || std::any_of(out.aggregates.begin(), out.aggregates.end(),
+            [](const AggItem& a) { return a.func != AggFunc::NONE; });
+        if (aggregate && out.aggregates.empty()) throw ParseError{};   // SELECT * ... GROUP BY
+        if (!aggregate) {
+            for (auto& a : out.aggregates) out.columns.push_back(std::move(a.col));
+            out.aggregates.clear();
         }
+        if (accept_keyword("LIMIT")) out.limit = number();
+        return out;
     }
-    /* DELETE */
-    {
-        std::regex rg(R"(DELETE\s+FROM\s+(\w+)\s+WHERE\s+(\w+)\s*=\s*('?[\w\d]+'?)\s*;?)", std::regex::icase);
-        std::smatch m;
-        if (std::regex_match(s, m, rg)) {
-            DeleteWhere q{ m[1],m[2],m[3] };
-            if (q.value.front() == '\'') q.value = q.value.substr(1, q.value.size() - 2);
-            return q;
+
+    // DELETE FROM t WHERE cond
+    Query del() {
+        expect_keyword("FROM");
+        std::string table(name());
+        expect_keyword("WHERE");
+        std::string col(name());
+        if (accept('=')) return DeleteWhere{ std::move(table), std::move(col), std::string(literal()) };
+        return DeleteRange{ std::move(table), range(std::move(col)) };
+    }
+
+    // After "col": < / <= / > / >= value, or BETWEEN lo AND hi
+    Range range(std::string col) {
+        Range r;
+        r.col = std::move(col);
+        if (accept_keyword("BETWEEN")) {
+            r.lo = std::string(literal());
+            expect_keyword("AND");
+            r.hi = std::string(literal());
+            return r;
         }
+        if (tok_.kind != TokenKind::SYMBOL || (tok_.text[0] != '<' && tok_.text[0] != '>')) throw ParseError{};
+        std::string_view op = tok_.text;
+        advance();
+        if (op[0] == '<') { r.hi = std::string(literal()); r.hi_incl = op.size() == 2; }
+        else              { r.lo = std::string(literal()); r.lo_incl = op.size() == 2; }
+        return r;
+    }
+
+    // Optional ';', then nothing
+    template <class Q>
+    Query finish(Q q) {
+        accept(';');
+        if (tok_.kind != TokenKind::END) throw ParseError{};
+        return Query(std::move(q));
+    }
+
+    /* ---------- terminals ---------- */
+
+    std::string_view name() {
+        if (!tok_.is_name()) throw ParseError{};
+        return take();
+    }
+    std::string_view literal() {
+        if (tok_.kind != TokenKind::WORD && tok_.kind != TokenKind::STRING) throw ParseError{};
+        if (params_) params_->push_back(parameter());
+        return take();
+    }
+    // n if the token is $n (n from 1), else 0
+    uint16_t parameter() const {
+        std::string_view t = tok_.text;
+        uint16_t n = 0;
+        if (tok_.kind != TokenKind::WORD || t.size() < 2 || t[0] != '$') return 0;
+        auto [end, ec] = std::from_chars(t.data() + 1, t.data() + t.size(), n);
+        if (ec != std::errc() || end != t.data() + t.size()) return 0;
+        return n;
+    }
+    size_t number() {
+        size_t v = 0;
+        auto [end, ec] = std::from_chars(tok_.text.data(), tok_.text.data() + tok_.text.size(), v);
+        if (tok_.kind != TokenKind::WORD || ec != std::errc() || end != tok_.text.data() + tok_.text.size())
+            throw ParseError{};
+        advance();
+        return v;
+    }
+
+    bool accept(char symbol) {
+        if (!tok_.is(symbol)) return false;
+        advance();
+        return true;
+    }
+    void expect(char symbol) {
+        if (!accept(symbol)) throw ParseError{};
+    }
+    bool accept_keyword(std::string_view kw) {
+        if (!tok_.is_keyword(kw)) return false;
+        advance();
+        return true;
+    }
+    void expect_keyword(std::string_view kw) {
+        if (!accept_keyword(kw)) throw ParseError{};
+    }
+
+    std::string_view take() {
+        std::string_view t = tok_.text;
+        advance();
+        return t;
+    }
+    void advance() { tok_ = lex_.next(); }
+
+    Lexer                  lex_;
+    Token                  tok_;
+    std::vector<uint16_t>* params_;
+};
+
+} // namespace
+
+std::optional<Query> QueryParser::parse(const std::string& in, std::vector<uint16_t>* params) {
+    if (params) params->clear();
+    try {
+        return Parser(in, params).statement();
+    } catch (const ParseError&) {
+        return std::nullopt;      // parse error
     }
-    return std::nullopt;          // parse error
 }
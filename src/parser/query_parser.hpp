@@ -1,8 +1,13 @@
 #pragma once
+#include <cstdint>
 #include <optional>
+#include <vector>
 #include "query.hpp"
 
 class QueryParser {
 public:
-    static std::optional<Query> parse(const std::string& s);
+    // nullopt if s is not a statement. With params, a bare $n literal is
+    // parameter n and params lists, per literal in for_each_literal order,
+    // its parameter number (0: a constant)
+    static std::optional<Query> parse(const std::string& s, std::vector<uint16_t>* params = nullptr);
 };
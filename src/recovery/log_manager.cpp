@@ -0,0 +1,326 @@
+#include "log_manager.hpp"
+#include "log_reader.hpp"
+#include "storage/page.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Master record slot: [magic u32][seq u32][checkpoint_lsn u32][pad u32]
+// [checkpoint_offset u64][start_offset u64][checksum u32]
+constexpr uint32_t MASTER_MAGIC = 0x4d44574c;   // "LWDM"
+constexpr size_t MASTER_SLOT = 512;             // slot i lives at i * MASTER_SLOT
+constexpr size_t MASTER_SIZE = 36;
+
+static uint32_t fnv1a(const std::byte* p, size_t n) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; ++i) h = (h ^ static_cast<uint8_t>(p[i])) * 16777619u;
+    return h;
+}
+
+static void write_all(int fd, const std::byte* buf, size_t len, size_t offset) {
+    size_t put = 0;
+    while (put < len) {
+        ssize_t n = ::pwrite(fd, buf + put, len - put, static_cast<off_t>(offset + put));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("log write failed: ") + std::strerror(errno));
+        }
+        put += static_cast<size_t>(n);
+    }
+}
+
+static void sync_file(int fd) {
+    if (::fdatasync(fd) != 0) {
+        throw std::runtime_error(std::string("log fdatasync failed: ") + std::strerror(errno));
+    }
+}
+
+LogManager::LogManager(const std::string& filename, std::chrono::microseconds group_window)
+    : filename_(filename), group_window_(group_window), buf_(BUFFER_SIZE), flush_buf_(BUFFER_SIZE) {
+    fd_ = ::open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("cannot open " + filename + ": " + std::strerror(errno));
+    }
+    try {
+        read_master();
+        find_end();
+    }
+    catch (...) {
+        ::close(fd_);
+        throw;
+    }
+    flusher_ = std::thread([this] { flusher_loop(); });
+}
+
+void LogManager::read_master() {
+    for (size_t slot = 0; slot < 2; ++slot) {
+        std::byte raw[MASTER_SIZE];
+        if (::pread(fd_, raw, MASTER_SIZE, static_cast<off_t>(slot * MASTER_SLOT)) != static_cast<ssize_t>(MASTER_SIZE)) continue;
+        uint32_t magic, seq, lsn, sum;
+        uint64_t checkpoint_offset, start_offset;
+        std::memcpy(&magic, raw, 4);
+        std::memcpy(&seq, raw + 4, 4);
+        std::memcpy(&lsn, raw + 8, 4);
+        std::memcpy(&checkpoint_offset, raw + 16, 8);
+        std::memcpy(&start_offset, raw + 24, 8);
+        std::memcpy(&sum, raw + 32, 4);
+        if (magic != MASTER_MAGIC || sum != fnv1a(raw, 32) || seq % 2 != slot) continue;
+        if (master_.checkpoint_lsn != INVALID_LSN && seq < master_seq_) continue;
+        master_ = { lsn, checkpoint_offset, start_offset };
+        master_seq_ = seq;
+    }
+}
+
+// Reads the records from the last checkpoint on; the log ends where they do
+void LogManager::find_end() {
+    size_t start = master_.checkpoint_lsn != INVALID_LSN ? master_.checkpoint_offset : LOG_START;
+    lsn_t last = master_.checkpoint_lsn;
+    txn_id_t max_txn = SYSTEM_TXN;
+    LogReader reader(filename_, start);
+    LogRecord rec;
+    while (reader.next(rec)) {
+        last = std::max(last, rec.lsn);
+        max_txn = std::max(max_txn, rec.txn_id);
+        for (const ActiveTxn& t : rec.active_txns) max_txn = std::max(max_txn, t.id);
+    }
+    write_pos_ = std::max(reader.offset(), LOG_START);
+    next_lsn_.store(last + 1);
+    persistent_lsn_.store(last);
+    next_txn_ = max_txn + 1;
+    rounds_.emplace_back(INVALID_LSN, start);
+
+    struct stat st;
+    if (::fstat(fd_, &st) != 0) {
+        throw std::runtime_error(std::string("fstat failed: ") + std::strerror(errno));
+    }
+    allocated_ = static_cast<size_t>(st.st_size);
+
+    // An interrupted round may have left parts of its records past the end
+    // (it wrote at most one buffer); new records must not run into them
+    size_t dirty_end = std::min(allocated_, write_pos_ + BUFFER_SIZE);
+    if (dirty_end > write_pos_) {
+        std::vector<std::byte> zeros(dirty_end - write_pos_);
+        write_all(fd_, zeros.data(), zeros.size(), write_pos_);
+        sync_file(fd_);
+    }
+}
+
+LogManager::~LogManager() {
+    {
+        std::lock_guard<std::mutex> lk(latch_);
+        stop_ = true;
+    }
+    flush_cv_.notify_all();
+    flusher_.join();
+    ::close(fd_);
+}
+
+Txn LogManager::begin() {
+    Txn txn;
+    {
+        std::lock_guard<std::mutex> lk(latch_);
+        if (next_txn_ == UINT32_MAX) throw std::runtime_error("transaction ids used up: no more transactions can be logged");
+        txn.id = next_txn_++;
+    }
+    LogRecord rec{ LogType::BEGIN };
+    append(rec, &txn);
+    return txn;
+}
+
+void LogManager::commit(Txn& txn) {
+    LogRecord rec{ LogType::COMMIT };
+    flush(append(rec, &txn));
+}
+
+lsn_t LogManager::append(LogRecord& rec, Txn* txn) {
+    size_t size = rec.size();
+    if (size > BUFFER_SIZE) throw std::runtime_error("log record larger than the log buffer");
+
+    std::unique_lock<std::mutex> lk(latch_);
+    // Buffer full: write it out, or wait for the round that is doing so
+    while (buf_used_ + size > BUFFER_SIZE) {
+        if (failed_) throw std::runtime_error("log write failed");
+        if (flushing_) durable_cv_.wait(lk);
+        else write_round(lk);
+    }
+
+    // Past MAX_LSN the sequence would wrap to INVALID_LSN, where reading
+    // the log stops
+    rec.lsn = next_lsn_.load(std::memory_order_relaxed);
+    if (rec.lsn > MAX_LSN) throw std::runtime_error("log sequence numbers used up: no more changes can be logged");
+    next_lsn_.store(rec.lsn + 1);
+    rec.txn_id = txn ? txn->id : SYSTEM_TXN;
+    rec.prev_lsn = txn ? txn->prev_lsn : INVALID_LSN;
+    if (txn) {
+        txn->prev_lsn = rec.lsn;
+        if (rec.type == LogType::COMMIT || rec.type == LogType::ABORT) {
+            active_.erase(txn->id);
+        } else {
+            auto [it, fresh] = active_.try_emplace(txn->id, ActiveTxn{ txn->id, rec.lsn, rec.lsn });
+            if (!fresh) it->second.last_lsn = rec.lsn;
+        }
+    }
+    if (buf_used_ == 0) buf_first_lsn_ = rec.lsn;
+    rec.serialize(buf_.data() + buf_used_);
+    buf_used_ += size;
+
+    // Half full: start writing in the background
+    if (buf_used_ >= BUFFER_SIZE / 2 && buf_used_ - size < BUFFER_SIZE / 2) flush_cv_.notify_one();
+    return rec.lsn;
+}
+
+std::vector<ActiveTxn> LogManager::active_txns() {
+    std::lock_guard<std::mutex> lk(latch_);
+    std::vector<ActiveTxn> out;
+    out.reserve(active_.size());
+    for (const auto& [id, t] : active_) out.push_back(t);
+    return out;
+}
+
+size_t LogManager::offset_of(lsn_t lsn) {
+    std::lock_guard<std::mutex> lk(latch_);
+    auto it = std::upper_bound(rounds_.begin(), rounds_.end(), lsn,
+        [](lsn_t l, const std::pair<lsn_t, size_t>& round) { return l < round.first; });
+    return it == rounds_.begin() ? rounds_.front().second : std::prev(it)->second;
+}
+
+MasterRecord LogManager::master() {
+    std::lock_guard<std::mutex> lk(master_latch_);
+    return master_;
+}
+
+void LogManager::write_master(const MasterRecord& m) {
+    std::lock_guard<std::mutex> lk(master_latch_);
+    uint32_t seq = master_seq_ + 1;
+    std::byte raw[MASTER_SIZE] = {};
+    uint64_t checkpoint_offset = m.checkpoint_offset, start_offset = m.start_offset;
+    std::memcpy(raw, &MASTER_MAGIC, 4);
+    std::memcpy(raw + 4, &seq, 4);
+    std::memcpy(raw + 8, &m.checkpoint_lsn, 4);
+    std::memcpy(raw + 16, &checkpoint_offset, 8);
+    std::memcpy(raw + 24, &start_offset, 8);
+    uint32_t sum = fnv1a(raw, 32);
+    std::memcpy(raw + 32, &sum, 4);
+    write_all(fd_, raw, MASTER_SIZE, (seq % 2) * MASTER_SLOT);
+    sync_file(fd_);
+
+    // Should this slot turn out torn, the other one, the previous master
+    // record, is used: keep what either needs
+    size_t keep = master_.checkpoint_lsn != INVALID_LSN ? std::min(master_.start_offset, m.start_offset) : LOG_START;
+    master_ = m;
+    master_seq_ = seq;
+    keep = keep / Page::PAGE_SIZE * Page::PAGE_SIZE;
+    if (keep > LOG_START) {
+        // Best effort: a filesystem without hole punching keeps the space
+        ::fallocate(fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+            static_cast<off_t>(LOG_START), static_cast<off_t>(keep - LOG_START));
+    }
+
+    std::lock_guard<std::mutex> rl(latch_);
+    size_t drop = 0;
+    while (drop + 1 < rounds_.size() && rounds_[drop + 1].second <= m.start_offset) ++drop;
+    rounds_.erase(rounds_.begin(), rounds_.begin() + drop);
+}
+
+// The first caller to find no round in progress leads one: it writes and
+// syncs everything buffered so far, including the records of every commit
+// that queued up behind the previous round. Everyone else waits for it.
+void LogManager::flush(lsn_t lsn) {
+    // LSNs past the end of the log (pages of a log since deleted) count as durable
+    lsn = std::min(lsn, last_lsn());
+    if (lsn == INVALID_LSN || persistent_lsn_.load() >= lsn) return;
+
+    std::unique_lock<std::mutex> lk(latch_);
+    while (!failed_ && persistent_lsn_.load() < lsn) {
+        if (flushing_) durable_cv_.wait(lk);
+        else write_round(lk);
+    }
+    if (failed_) throw std::runtime_error("log write failed");
+}
+
+void LogManager::flush_async(lsn_t lsn) {
+    lsn = std::min(lsn, last_lsn());
+    if (lsn == INVALID_LSN || persistent_lsn_.load() >= lsn) return;
+    std::lock_guard<std::mutex> lk(latch_);
+    if (lsn > wanted_lsn_) {
+        wanted_lsn_ = lsn;
+        flush_cv_.notify_one();
+    }
+}
+
+// Caller holds latch_ (released during the I/O) and no round is running
+void LogManager::write_round(std::unique_lock<std::mutex>& lk) {
+    flushing_ = true;
+    if (group_window_.count() > 0) {
+        lk.unlock();
+        std::this_thread::sleep_for(group_window_);
+        lk.lock();
+    }
+
+    std::swap(buf_, flush_buf_);
+    size_t len = buf_used_;
+    buf_used_ = 0;
+    lsn_t first = buf_first_lsn_;
+    size_t pos = write_pos_;
+    lsn_t upto = last_lsn();
+    durable_cv_.notify_all();                // appenders waiting for room
+    lk.unlock();
+
+    bool ok = true;
+    try {
+        write_out(flush_buf_, len);
+    }
+    catch (const std::exception&) {
+        ok = false;
+    }
+
+    lk.lock();
+    flushing_ = false;
+    if (ok) {
+        persistent_lsn_.store(upto);
+        if (len) rounds_.emplace_back(first, pos);
+    }
+    else failed_ = true;
+    durable_cv_.notify_all();
+}
+
+// Background rounds: a buffer half full, or an LSN asked for by flush_async
+void LogManager::flusher_loop() {
+    std::unique_lock<std::mutex> lk(latch_);
+    for (;;) {
+        flush_cv_.wait(lk, [&] {
+            return stop_ || wanted_lsn_ > persistent_lsn_.load() || buf_used_ >= BUFFER_SIZE / 2;
+        });
+        if (failed_) break;
+        if (flushing_) {
+            durable_cv_.wait(lk);
+            continue;
+        }
+        if (buf_used_ == 0) {
+            if (stop_) break;
+            wanted_lsn_ = persistent_lsn_.load();     // nothing left to write
+            continue;
+        }
+        write_round(lk);
+    }
+}
+
+void LogManager::write_out(const std::vector<std::byte>& buf, size_t len) {
+    // Keep the write inside allocated space, so that the fdatasync below
+    // has no file size to commit
+    if (write_pos_ + len > allocated_) {
+        size_t grow = std::max(EXTENT, len);
+        if (::posix_fallocate(fd_, static_cast<off_t>(allocated_), static_cast<off_t>(grow)) == 0) allocated_ += grow;
+    }
+
+    write_all(fd_, buf.data(), len, write_pos_);
+    sync_file(fd_);
+    write_pos_ += len;
+    syncs_.fetch_add(1);
+    bytes_written_.fetch_add(len);
+}
@@ -0,0 +1,157 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "recovery/log_record.hpp"
+
+// A statement's transaction: its id and the LSN of its latest record, which
+// the next one points back to
+struct Txn {
+    txn_id_t id = SYSTEM_TXN;
+    lsn_t    prev_lsn = INVALID_LSN;
+};
+
+// Where restart recovery starts, as of the last complete checkpoint
+struct MasterRecord {
+    lsn_t  checkpoint_lsn = INVALID_LSN;   // its CHECKPOINT_BEGIN (none yet: INVALID_LSN)
+    size_t checkpoint_offset = 0;          // file offset to read from to reach that record
+    size_t start_offset = 0;               // file offset of the oldest record recovery needs
+};
+
+/*
+ * Write-ahead log with group commit.
+ *
+ * append() serializes a record into the in-memory log buffer and hands
+ * out its LSN; nothing waits for the disk there. flush(lsn) returns once
+ * every record up to lsn is on disk. Committers call it through commit(),
+ * and the buffer pool calls it before writing a page whose LSN is not
+ * durable yet (WAL before data).
+ *
+ * Group commit: there are two buffers. A flush that finds no write in
+ * progress leads a round: it swaps the buffers, writes the full one to the
+ * log file and fdatasyncs it, without the latch. Records appended
+ * meanwhile go to the other buffer, and their committers wait. When the
+ * round ends one of them leads the next, which makes all of them durable
+ * with a single fsync. A lone committer pays one write + fsync and no
+ * thread handoff. A background thread runs rounds when a buffer is half
+ * full or flush_async() asks for one.
+ *
+ * The file is preallocated EXTENT bytes at a time, so appending does not
+ * change its size and each fdatasync has only data to flush. Past the
+ * last record the file reads as zeros, which no record parses as.
+ *
+ * group_window (0 by default) makes a leader wait that long before it
+ * swaps the buffers, so that more commits can join when fsyncs are cheap
+ * compared with the commit rate.
+ *
+ * The first LOG_START bytes of the file hold the master record, in two
+ * slots written alternately, so a torn write leaves the previous one
+ * intact. Opening an existing log reads the records from the last
+ * checkpoint on to find where the log ends, continues the LSN sequence
+ * after it and zeros whatever an interrupted round left behind it.
+ * Records are addressed by LSN; offset_of() maps an LSN of this session
+ * to the start of the write round that holds it. Once a new master record
+ * is durable, the space before the older of the two start offsets is
+ * released (hole punched), so the log only grows with the work since the
+ * last checkpoints.
+ *
+ * LSNs and transaction ids are 32 bits and never wrap: the next LSN after
+ * UINT32_MAX would be INVALID_LSN, which readers take for the end of the
+ * log. Once MAX_LSN has been handed out (or the last transaction id),
+ * append() (begin()) throws, and the database has to be dumped and loaded
+ * into a fresh log to take more changes.
+ */
+class LogManager {
+public:
+    static constexpr size_t BUFFER_SIZE = size_t(1) << 20;   // bytes per log buffer
+    static constexpr size_t EXTENT = size_t(16) << 20;       // log file preallocation step
+    static constexpr size_t LOG_START = 4096;                 // master record slots, then records
+    static constexpr lsn_t MAX_LSN = UINT32_MAX - 1;          // the last LSN append() hands out
+
+    explicit LogManager(const std::string& filename,
+        std::chrono::microseconds group_window = std::chrono::microseconds(0));
+    // Writes whatever is buffered and stops the flush thread
+    ~LogManager();
+
+    LogManager(const LogManager&) = delete;
+    LogManager& operator=(const LogManager&) = delete;
+
+    // New transaction, with its BEGIN record
+    Txn begin();
+    // COMMIT record; returns once it is durable
+    void commit(Txn& txn);
+
+    // Transactions with a BEGIN but no COMMIT or ABORT yet
+    std::vector<ActiveTxn> active_txns();
+
+    // Assigns rec its LSN and places it in the log buffer. A null txn logs
+    // a system record; otherwise the record joins txn's chain. Throws once
+    // the LSNs are used up.
+    lsn_t append(LogRecord& rec, Txn* txn = nullptr);
+
+    // Returns once every record up to lsn is on disk
+    void flush(lsn_t lsn);
+    // Has the flush thread write up to lsn, without waiting for it
+    void flush_async(lsn_t lsn);
+    void flush_all() { flush(last_lsn()); }
+
+    // File offset to read from to reach lsn, which must be durable: the
+    // start of the write round that holds it
+    size_t offset_of(lsn_t lsn);
+
+    // The last master record written (checkpoint_lsn INVALID_LSN if none)
+    MasterRecord master();
+    // Make m the master record (durably), then release the log space
+    // neither it nor the previous one needs
+    void write_master(const MasterRecord& m);
+
+    const std::string& filename() const { return filename_; }
+    lsn_t last_lsn() const { return next_lsn_.load() - 1; }
+    lsn_t persistent_lsn() const { return persistent_lsn_.load(); }
+    size_t syncs() const { return syncs_.load(); }          // fdatasync calls so far
+    size_t bytes_written() const { return bytes_written_.load(); }
+
+private:
+    void write_round(std::unique_lock<std::mutex>& lk);
+    void flusher_loop();
+    void write_out(const std::vector<std::byte>& buf, size_t len);
+    // Open: find the master record and the end of the log
+    void read_master();
+    void find_end();
+
+    std::string filename_;
+    int fd_ = -1;
+    std::chrono::microseconds group_window_;
+    size_t write_pos_ = 0;       // end of the records in the file (written by the round's leader)
+    size_t allocated_ = 0;       // bytes preallocated; past write_pos_ they read as zeros
+
+    std::mutex              latch_;       // guards everything below but the atomics
+    std::condition_variable flush_cv_;    // wakes the background thread
+    std::condition_variable durable_cv_;  // a round ended (or swapped buffers)
+    std::vector<std::byte>  buf_;         // filling
+    std::vector<std::byte>  flush_buf_;   // being written by the current round
+    size_t                  buf_used_ = 0;
+    lsn_t                   buf_first_lsn_ = INVALID_LSN;   // first record in buf_
+    lsn_t                   wanted_lsn_ = INVALID_LSN;   // highest LSN asked of the background thread
+    bool                    flushing_ = false;   // a round is writing flush_buf_
+    txn_id_t                next_txn_ = 1;
+    bool                    stop_ = false;
+    bool                    failed_ = false;     // a write or sync failed: waiters throw
+    std::thread             flusher_;
+    std::unordered_map<txn_id_t, ActiveTxn>  active_;    // active transaction table
+    std::vector<std::pair<lsn_t, size_t>>    rounds_;    // (first LSN, file offset) per write round
+
+    std::mutex   master_latch_;      // guards master_ and master_seq_
+    MasterRecord master_;
+    uint32_t     master_seq_ = 0;    // slot master_seq_ % 2 holds master_
+
+    std::atomic<lsn_t>  next_lsn_{ 1 };
+    std::atomic<lsn_t>  persistent_lsn_{ INVALID_LSN };
+    std::atomic<size_t> syncs_{ 0 }, bytes_written_{ 0 };
+};
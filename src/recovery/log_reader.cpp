@@ -0,0 +1,61 @@
+#include "log_reader.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+LogReader::LogReader(const std::string& filename, size_t offset)
+    : buf_(CHUNK), buf_offset_(offset) {
+    fd_ = ::open(filename.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+        throw std::runtime_error("cannot open " + filename + ": " + std::strerror(errno));
+    }
+}
+
+LogReader::~LogReader() {
+    ::close(fd_);
+}
+
+bool LogReader::next(LogRecord& rec) {
+    for (;;) {
+        size_t avail = len_ - pos_;
+        if (avail >= LogRecord::HEADER_SIZE) {
+            uint32_t size;
+            std::memcpy(&size, buf_.data() + pos_, sizeof size);
+            if (size <= avail) {
+                if (!LogRecord::deserialize(buf_.data() + pos_, avail, rec)) return false;
+                if (rec.lsn == INVALID_LSN || (last_lsn_ != INVALID_LSN && rec.lsn != last_lsn_ + 1)) return false;
+                last_lsn_ = rec.lsn;
+                pos_ += size;
+                return true;
+            }
+            if (size > CHUNK) return false;          // no record is that large
+        }
+        if (eof_ || !fill()) return false;
+    }
+}
+
+bool LogReader::fill() {
+    size_t rest = len_ - pos_;
+    std::memmove(buf_.data(), buf_.data() + pos_, rest);
+    buf_offset_ += pos_;
+    pos_ = 0;
+    len_ = rest;
+
+    size_t before = len_;
+    while (len_ < buf_.size()) {
+        ssize_t n = ::pread(fd_, buf_.data() + len_, buf_.size() - len_, static_cast<off_t>(buf_offset_ + len_));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("log read failed: ") + std::strerror(errno));
+        }
+        if (n == 0) {
+            eof_ = true;
+            break;
+        }
+        len_ += static_cast<size_t>(n);
+    }
+    return len_ > before;
+}
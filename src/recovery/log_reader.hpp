@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "recovery/log_record.hpp"
+
+/*
+ * Reads the records of a log file in order, starting at a byte offset.
+ * The log ends at the first record that does not parse (a torn write, or
+ * the zeros of the preallocated tail) or does not continue the LSN
+ * sequence (leftovers of an interrupted write further on).
+ */
+class LogReader {
+public:
+    static constexpr size_t CHUNK = size_t(2) << 20;   // bytes read at once; larger than any record
+
+    LogReader(const std::string& filename, size_t offset);
+    ~LogReader();
+
+    LogReader(const LogReader&) = delete;
+    LogReader& operator=(const LogReader&) = delete;
+
+    // The next record; false at the end of the log
+    bool next(LogRecord& rec);
+
+    // File offset just past the last record returned
+    size_t offset() const { return buf_offset_ + pos_; }
+
+private:
+    // Move the unread bytes to the front and read more; false at end of file
+    bool fill();
+
+    int fd_ = -1;
+    std::vector<std::byte> buf_;
+    size_t buf_offset_;           // file offset of buf_[0]
+    size_t pos_ = 0;              // next unread byte in buf_
+    size_t len_ = 0;              // valid bytes in buf_
+    bool   eof_ = false;
+    lsn_t  last_lsn_ = INVALID_LSN;
+};
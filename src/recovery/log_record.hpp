@@ -0,0 +1,241 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include "storage/rid.hpp"
+
+using lsn_t = uint32_t;          // fits the 4-byte LSN slot of the page header
+using txn_id_t = uint32_t;
+
+constexpr lsn_t INVALID_LSN = 0;  // a page that no log record has touched
+constexpr txn_id_t SYSTEM_TXN = 0;   // page allocation and changes made outside a statement
+
+enum class LogType : uint16_t {
+    INVALID = 0,
+    BEGIN,
+    COMMIT,
+    ABORT,
+    INSERT,       // rid + tuple: the row placed in the first free slot of rid's page
+    MARK_DELETE,  // rid + tuple: the row (its old image) cleared from its slot
+    NEW_PAGE,     // page + prev_page: a heap page formatted and linked after prev_page
+    CLR,          // compensation: undid the record before undo_next (redo only)
+    CHECKPOINT_BEGIN,
+    CHECKPOINT_END,   // dirty page table + active transaction table
+    COMPACT,      // page: its live rows moved together, deleted rows' slots freed
+};
+
+// Active transaction table entry, as logged by a checkpoint
+struct ActiveTxn {
+    txn_id_t id = SYSTEM_TXN;
+    lsn_t    first_lsn = INVALID_LSN;
+    lsn_t    last_lsn = INVALID_LSN;
+};
+
+/*
+ * One write-ahead log record. On disk (and in the log buffer):
+ *
+ *   [size u32][lsn u32][prev_lsn u32][txn u32][type u16][pad u16][checksum u32]
+ *   INSERT / MARK_DELETE:  [page u32][slot u16][len u16][tuple bytes]
+ *   NEW_PAGE:              [page u32][prev_page u32]
+ *   COMPACT:               [page u32]
+ *   CLR:                   as INSERT, then [undo_next u32][undone u16][pad u16]
+ *   CHECKPOINT_END:        [pages u32][txns u32]
+ *                          [page u32][rec_lsn u32] * pages
+ *                          [txn u32][first_lsn u32][last_lsn u32] * txns
+ *
+ * LSNs are record sequence numbers starting at 1. prev_lsn chains the
+ * records of one transaction backwards. The checksum (FNV-1a over the
+ * record with the checksum field zeroed) tells a torn tail from a record.
+ *
+ * A CLR carries the row of the record it compensates (undone): redoing it
+ * clears the slot of an undone INSERT or restores that of an undone
+ * MARK_DELETE. undo_next is the undone record's prev_lsn, where the undo
+ * of the transaction continues.
+ */
+struct LogRecord {
+    static constexpr size_t HEADER_SIZE = 24;
+    static constexpr uint32_t NO_PAGE = UINT32_MAX;
+
+    LogType     type = LogType::INVALID;
+    txn_id_t    txn_id = SYSTEM_TXN;
+    lsn_t       lsn = INVALID_LSN;
+    lsn_t       prev_lsn = INVALID_LSN;
+    RID         rid{ NO_PAGE, 0 };       // INSERT / MARK_DELETE: the row; NEW_PAGE / COMPACT: the page
+    uint32_t    prev_page = NO_PAGE;     // NEW_PAGE
+    std::string tuple{};                 // INSERT / MARK_DELETE / CLR
+    lsn_t       undo_next = INVALID_LSN; // CLR
+    LogType     undone = LogType::INVALID;                     // CLR
+    std::vector<std::pair<uint32_t, lsn_t>> dirty_pages{};     // CHECKPOINT_END: (page, rec_lsn)
+    std::vector<ActiveTxn>                  active_txns{};     // CHECKPOINT_END
+
+    static LogRecord insert(const RID& rid, const std::byte* data, size_t len) {
+        LogRecord r{ LogType::INSERT };
+        r.rid = rid;
+        r.tuple.assign(reinterpret_cast<const char*>(data), len);
+        return r;
+    }
+    static LogRecord mark_delete(const RID& rid, const std::byte* data, size_t len) {
+        LogRecord r = insert(rid, data, len);
+        r.type = LogType::MARK_DELETE;
+        return r;
+    }
+    static LogRecord new_page(uint32_t page_id, uint32_t prev_page) {
+        LogRecord r{ LogType::NEW_PAGE };
+        r.rid = RID(page_id, 0);
+        r.prev_page = prev_page;
+        return r;
+    }
+    static LogRecord compact(uint32_t page_id) {
+        LogRecord r{ LogType::COMPACT };
+        r.rid = RID(page_id, 0);
+        return r;
+    }
+    // Compensation for undoing rec (an INSERT or MARK_DELETE)
+    static LogRecord clr(const LogRecord& rec) {
+        LogRecord r{ LogType::CLR };
+        r.rid = rec.rid;
+        r.tuple = rec.tuple;
+        r.undo_next = rec.prev_lsn;
+        r.undone = rec.type;
+        return r;
+    }
+    static LogRecord checkpoint_end(std::vector<std::pair<uint32_t, lsn_t>> dirty_pages,
+        std::vector<ActiveTxn> active_txns) {
+        LogRecord r{ LogType::CHECKPOINT_END };
+        r.dirty_pages = std::move(dirty_pages);
+        r.active_txns = std::move(active_txns);
+        return r;
+    }
+
+    // Changes a heap page (INSERT, MARK_DELETE, NEW_PAGE, CLR, COMPACT)
+    bool is_page_change() const {
+        return type == LogType::INSERT || type == LogType::MARK_DELETE ||
+            type == LogType::NEW_PAGE || type == LogType::CLR || type == LogType::COMPACT;
+    }
+
+    size_t size() const {
+        switch (type) {
+        case LogType::INSERT:
+        case LogType::MARK_DELETE:    return HEADER_SIZE + 8 + tuple.size();
+        case LogType::CLR:            return HEADER_SIZE + 16 + tuple.size();
+        case LogType::NEW_PAGE:       return HEADER_SIZE + 8;
+        case LogType::COMPACT:        return HEADER_SIZE + 4;
+        case LogType::CHECKPOINT_END: return HEADER_SIZE + 8 + dirty_pages.size() * 8 + active_txns.size() * 12;
+        default:                      return HEADER_SIZE;
+        }
+    }
+
+    // Writes size() bytes at out
+    void serialize(std::byte* out) const {
+        std::memset(out, 0, HEADER_SIZE);
+        put<uint32_t>(out, static_cast<uint32_t>(size()));
+        put<uint32_t>(out + 4, lsn);
+        put<uint32_t>(out + 8, prev_lsn);
+        put<uint32_t>(out + 12, txn_id);
+        put<uint16_t>(out + 16, static_cast<uint16_t>(type));
+        std::byte* body = out + HEADER_SIZE;
+        if (type == LogType::INSERT || type == LogType::MARK_DELETE || type == LogType::CLR) {
+            put<uint32_t>(body, rid.page_id());
+            put<uint16_t>(body + 4, rid.slot_id());
+            put<uint16_t>(body + 6, static_cast<uint16_t>(tuple.size()));
+            std::memcpy(body + 8, tuple.data(), tuple.size());
+            if (type == LogType::CLR) {
+                std::byte* tail = body + 8 + tuple.size();
+                put<uint32_t>(tail, undo_next);
+                put<uint16_t>(tail + 4, static_cast<uint16_t>(undone));
+                put<uint16_t>(tail + 6, 0);
+            }
+        } else if (type == LogType::NEW_PAGE) {
+            put<uint32_t>(body, rid.page_id());
+            put<uint32_t>(body + 4, prev_page);
+        } else if (type == LogType::COMPACT) {
+            put<uint32_t>(body, rid.page_id());
+        } else if (type == LogType::CHECKPOINT_END) {
+            put<uint32_t>(body, static_cast<uint32_t>(dirty_pages.size()));
+            put<uint32_t>(body + 4, static_cast<uint32_t>(active_txns.size()));
+            std::byte* p = body + 8;
+            for (auto [page_id, rec_lsn] : dirty_pages) {
+                put<uint32_t>(p, page_id);
+                put<uint32_t>(p + 4, rec_lsn);
+                p += 8;
+            }
+            for (const ActiveTxn& t : active_txns) {
+                put<uint32_t>(p, t.id);
+                put<uint32_t>(p + 4, t.first_lsn);
+                put<uint32_t>(p + 8, t.last_lsn);
+                p += 12;
+            }
+        }
+        put<uint32_t>(out + 20, checksum(out, size()));
+    }
+
+    // Parses the record at in (avail bytes readable); false for a torn or
+    // corrupt record, which ends the readable log
+    static bool deserialize(const std::byte* in, size_t avail, LogRecord& rec) {
+        if (avail < HEADER_SIZE) return false;
+        uint32_t size = get<uint32_t>(in);
+        if (size < HEADER_SIZE || size > avail || get<uint32_t>(in + 20) != checksum(in, size)) return false;
+        rec = LogRecord{};
+        rec.lsn = get<uint32_t>(in + 4);
+        rec.prev_lsn = get<uint32_t>(in + 8);
+        rec.txn_id = get<uint32_t>(in + 12);
+        rec.type = static_cast<LogType>(get<uint16_t>(in + 16));
+        if (rec.type == LogType::INVALID || rec.type > LogType::COMPACT) return false;
+        const std::byte* body = in + HEADER_SIZE;
+        if (rec.type == LogType::INSERT || rec.type == LogType::MARK_DELETE || rec.type == LogType::CLR) {
+            if (size < HEADER_SIZE + 8) return false;
+            size_t len = get<uint16_t>(body + 6);
+            size_t extra = rec.type == LogType::CLR ? 8 : 0;
+            if (size != HEADER_SIZE + 8 + len + extra) return false;
+            rec.rid = RID(get<uint32_t>(body), get<uint16_t>(body + 4));
+            rec.tuple.assign(reinterpret_cast<const char*>(body + 8), len);
+            if (extra) {
+                rec.undo_next = get<uint32_t>(body + 8 + len);
+                rec.undone = static_cast<LogType>(get<uint16_t>(body + 12 + len));
+            }
+        } else if (rec.type == LogType::NEW_PAGE) {
+            if (size != HEADER_SIZE + 8) return false;
+            rec.rid = RID(get<uint32_t>(body), 0);
+            rec.prev_page = get<uint32_t>(body + 4);
+        } else if (rec.type == LogType::COMPACT) {
+            if (size != HEADER_SIZE + 4) return false;
+            rec.rid = RID(get<uint32_t>(body), 0);
+        } else if (rec.type == LogType::CHECKPOINT_END) {
+            if (size < HEADER_SIZE + 8) return false;
+            size_t pages = get<uint32_t>(body), txns = get<uint32_t>(body + 4);
+            if (size != HEADER_SIZE + 8 + pages * 8 + txns * 12) return false;
+            const std::byte* p = body + 8;
+            rec.dirty_pages.resize(pages);
+            for (auto& [page_id, rec_lsn] : rec.dirty_pages) {
+                page_id = get<uint32_t>(p);
+                rec_lsn = get<uint32_t>(p + 4);
+                p += 8;
+            }
+            rec.active_txns.resize(txns);
+            for (ActiveTxn& t : rec.active_txns) {
+                t = { get<uint32_t>(p), get<uint32_t>(p + 4), get<uint32_t>(p + 8) };
+                p += 12;
+            }
+        } else if (size != HEADER_SIZE) {
+            return false;
+        }
+        return true;
+    }
+
+private:
+    template <typename T> static void put(std::byte* p, T v) { std::memcpy(p, &v, sizeof(T)); }
+    template <typename T> static T get(const std::byte* p) { T v; std::memcpy(&v, p, sizeof(T)); return v; }
+
+    // FNV-1a over the record, checksum field (bytes 20..23) read as zero
+    static uint32_t checksum(const std::byte* p, size_t n) {
+        uint32_t h = 2166136261u;
+        for (size_t i = 0; i < n; ++i) {
+            uint8_t b = (i >= 20 && i < 24) ? 0 : static_cast<uint8_t>(p[i]);
+            h = (h ^ b) * 16777619u;
+        }
+        return h;
+    }
+};
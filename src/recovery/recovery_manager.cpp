@@ -0,0 +1,219 @@
+#include "recovery_manager.hpp"
+#include "log_reader.hpp"
+#include "storage/table_heap.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+// Pages a change record touches: NEW_PAGE also links the previous tail
+static size_t pages_of(const LogRecord& rec, uint32_t (&pages)[2]) {
+    pages[0] = rec.rid.page_id();
+    if (rec.type == LogType::NEW_PAGE && rec.prev_page != LogRecord::NO_PAGE) {
+        pages[1] = rec.prev_page;
+        return 2;
+    }
+    return 1;
+}
+
+RecoveryManager::~RecoveryManager() {
+    {
+        std::lock_guard<std::mutex> lk(stop_latch_);
+        stop_ = true;
+    }
+    stop_cv_.notify_all();
+    if (checkpointer_.joinable()) checkpointer_.join();
+}
+
+lsn_t RecoveryManager::checkpoint() {
+    std::lock_guard<std::mutex> lk(checkpoint_latch_);
+    LogRecord begin{ LogType::CHECKPOINT_BEGIN };
+    lsn_t begin_lsn = log_->append(begin);
+
+    // Taken after CHECKPOINT_BEGIN: a change logged before it has already
+    // noted its page, and a transaction that wrote before it is listed
+    auto dirty = bpm_->dirty_page_table();
+    auto active = log_->active_txns();
+    lsn_t start = begin_lsn;
+    for (auto [page_id, rec_lsn] : dirty) start = std::min(start, rec_lsn);
+    for (const ActiveTxn& t : active) start = std::min(start, t.first_lsn);
+
+    LogRecord end = LogRecord::checkpoint_end(std::move(dirty), std::move(active));
+    lsn_t end_lsn = log_->append(end);
+    log_->flush(end_lsn);
+    log_->write_master({ begin_lsn, log_->offset_of(begin_lsn), log_->offset_of(start) });
+    checkpoint_end_.store(end_lsn);
+    return begin_lsn;
+}
+
+void RecoveryManager::start_checkpoints(std::chrono::milliseconds interval) {
+    checkpoint_interval_ = interval;
+    checkpointer_ = std::thread([this] { checkpoint_loop(); });
+}
+
+void RecoveryManager::checkpoint_loop() {
+    std::unique_lock<std::mutex> lk(stop_latch_);
+    while (!stop_) {
+        stop_cv_.wait_for(lk, checkpoint_interval_);
+        if (stop_) break;
+        lk.unlock();
+        try {
+            if (log_->last_lsn() > checkpoint_end_.load()) checkpoint();
+        }
+        catch (const std::exception& e) {
+            std::cerr << "checkpoint failed: " << e.what() << "\n";   // the next one retries
+        }
+        lk.lock();
+    }
+}
+
+bool RecoveryManager::redo_page(uint32_t page_id, const LogRecord& rec) {
+    Page* page = bpm_->fetch_page(page_id);
+    if (!page) throw std::runtime_error("Failed to fetch page for redo");
+    page->w_latch();
+    bool apply = page->get_lsn() < rec.lsn;
+    if (apply) {
+        page->note_change(rec.lsn);
+        try {
+            TableHeap::redo(page, rec);
+        }
+        catch (...) {
+            page->w_unlatch();
+            bpm_->unpin_page(page_id, false);
+            throw;
+        }
+        page->set_lsn(rec.lsn);
+    }
+    page->w_unlatch();
+    bpm_->unpin_page(page_id, apply);
+    return apply;
+}
+
+void RecoveryManager::undo_change(const LogRecord& rec, Txn& txn) {
+    LogRecord clr = LogRecord::clr(rec);
+    uint32_t page_id = rec.rid.page_id();
+    Page* page = bpm_->fetch_page(page_id);
+    if (!page) throw std::runtime_error("Failed to fetch page for undo");
+    page->w_latch();
+    page->note_change(log_->last_lsn() + 1);
+    page->set_lsn(log_->append(clr, &txn));
+    TableHeap::redo(page, clr);
+    page->w_unlatch();
+    bpm_->unpin_page(page_id, true);
+}
+
+RecoveryManager::Stats RecoveryManager::recover() {
+    Stats stats;
+    MasterRecord master = log_->master();
+    bool have_checkpoint = master.checkpoint_lsn != INVALID_LSN;
+
+    /* ---------- analysis ---------- */
+    std::unordered_map<uint32_t, lsn_t> dirty;          // page -> rec_lsn
+    std::unordered_map<txn_id_t, ActiveTxn> active;     // losers, once the log ends
+    std::unordered_set<txn_id_t> ended;
+    {
+        LogReader reader(log_->filename(), have_checkpoint ? master.checkpoint_offset : LogManager::LOG_START);
+        LogRecord rec;
+        while (reader.next(rec)) {
+            if (rec.lsn < master.checkpoint_lsn) continue;   // same write round, before the checkpoint
+            ++stats.analyzed;
+            if (rec.type == LogType::CHECKPOINT_END) {
+                for (auto [page_id, rec_lsn] : rec.dirty_pages) {
+                    auto [it, fresh] = dirty.try_emplace(page_id, rec_lsn);
+                    if (!fresh) it->second = std::min(it->second, rec_lsn);
+                }
+                // The snapshot may predate commits logged before this record
+                for (const ActiveTxn& t : rec.active_txns) {
+                    if (ended.count(t.id)) continue;
+                    auto [it, fresh] = active.try_emplace(t.id, t);
+                    if (!fresh) {
+                        it->second.first_lsn = std::min(it->second.first_lsn, t.first_lsn);
+                        it->second.last_lsn = std::max(it->second.last_lsn, t.last_lsn);
+                    }
+                }
+                continue;
+            }
+            if (rec.txn_id != SYSTEM_TXN) {
+                if (rec.type == LogType::COMMIT || rec.type == LogType::ABORT) {
+                    active.erase(rec.txn_id);
+                    ended.insert(rec.txn_id);
+                } else {
+                    auto [it, fresh] = active.try_emplace(rec.txn_id, ActiveTxn{ rec.txn_id, rec.lsn, rec.lsn });
+                    if (!fresh) it->second.last_lsn = rec.lsn;
+                }
+            }
+            if (rec.is_page_change()) {
+                uint32_t pages[2];
+                for (size_t i = 0, n = pages_of(rec, pages); i < n; ++i) dirty.try_emplace(pages[i], rec.lsn);
+            }
+        }
+    }
+
+    /* ---------- redo ---------- */
+    // Loser records by LSN, for undo. A loser's records all follow its
+    // first_lsn, which the start offset covers.
+    std::unordered_map<lsn_t, LogRecord> loser_records;
+    uint32_t page_end = 0;
+    {
+        size_t from = have_checkpoint ? master.start_offset : LogManager::LOG_START;
+        LogReader reader(log_->filename(), from);
+        LogRecord rec;
+        while (reader.next(rec)) {
+            ++stats.scanned;
+            auto loser = active.find(rec.txn_id);
+            if (rec.txn_id != SYSTEM_TXN && loser != active.end() && rec.lsn >= loser->second.first_lsn) {
+                loser_records.emplace(rec.lsn, rec);
+            }
+            if (!rec.is_page_change()) continue;
+            uint32_t pages[2];
+            for (size_t i = 0, n = pages_of(rec, pages); i < n; ++i) {
+                page_end = std::max(page_end, pages[i] + 1);
+                auto it = dirty.find(pages[i]);
+                if (it == dirty.end() || rec.lsn < it->second) continue;
+                if (redo_page(pages[i], rec)) ++stats.redone;
+            }
+        }
+        stats.log_bytes = reader.offset() - from;
+    }
+    // Pages the log created may never have reached the file
+    bpm_->reserve_page_ids(page_end);
+
+    /* ---------- undo ---------- */
+    std::priority_queue<std::pair<lsn_t, txn_id_t>> todo;   // newest record first
+    std::unordered_map<txn_id_t, Txn> txns;
+    for (const auto& [id, t] : active) {
+        todo.emplace(t.last_lsn, id);
+        txns[id] = Txn{ id, t.last_lsn };
+    }
+    while (!todo.empty()) {
+        auto [lsn, id] = todo.top();
+        todo.pop();
+        auto it = loser_records.find(lsn);
+        if (it == loser_records.end()) {
+            throw std::runtime_error("log record " + std::to_string(lsn) + " missing for undo");
+        }
+        const LogRecord& rec = it->second;
+        lsn_t next = rec.prev_lsn;
+        if (rec.type == LogType::CLR) {
+            next = rec.undo_next;               // already undone up to there
+        } else if (rec.type == LogType::INSERT || rec.type == LogType::MARK_DELETE) {
+            undo_change(rec, txns[id]);
+            ++stats.undone;
+        }
+        if (next != INVALID_LSN) {
+            todo.emplace(next, id);
+        } else {
+            LogRecord abort{ LogType::ABORT };
+            log_->append(abort, &txns[id]);
+            ++stats.losers;
+        }
+    }
+
+    bpm_->flush_all_pages();                    // flushes the log first
+    checkpoint();
+    return stats;
+}
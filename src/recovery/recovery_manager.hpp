@@ -0,0 +1,89 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "recovery/log_manager.hpp"
+#include "storage/buffer_pool_manager.hpp"
+
+/*
+ * Fuzzy checkpoints and ARIES-style restart recovery.
+ *
+ * checkpoint() logs CHECKPOINT_BEGIN, then CHECKPOINT_END with the pool's
+ * dirty page table (page, rec_lsn) and the log's active transaction
+ * table, and once both are durable makes the begin record the master
+ * record. Nothing is latched or written meanwhile: writers keep going,
+ * and whatever they change after the tables were taken is in the log
+ * after CHECKPOINT_BEGIN.
+ *
+ * recover() runs on a freshly opened pool and log, before anything else
+ * uses them:
+ *
+ *   analysis  reads from the master checkpoint to the end of the log and
+ *             rebuilds both tables. Transactions still active at the end
+ *             are the losers.
+ *   redo      reads from the oldest record any of them needs (the master
+ *             record's start_offset) and applies every page change again
+ *             whose page is in the dirty page table, at or after its
+ *             rec_lsn, and newer than the page's LSN. Loser records are
+ *             kept in memory on the way.
+ *   undo      rolls the losers back, newest record first across all of
+ *             them. Each undone change is logged as a CLR, so a crash
+ *             during recovery never undoes anything twice, and each
+ *             loser ends with an ABORT record.
+ *
+ * Then the log and every page are flushed and a checkpoint is taken, so
+ * the next restart starts from there. Restart work follows the log
+ * written since the last checkpoint (and the changes of pages that stayed
+ * dirty across it), not the size of the database.
+ *
+ * Index and free-space-map pages are not logged: after a crash the
+ * Catalog rebuilds them from the recovered heaps.
+ */
+class RecoveryManager {
+public:
+    struct Stats {
+        size_t analyzed = 0;    // records read by analysis
+        size_t scanned = 0;     // records read by the redo pass
+        size_t log_bytes = 0;   // bytes read by the redo pass
+        size_t redone = 0;      // changes applied again
+        size_t undone = 0;      // changes rolled back (CLRs written)
+        size_t losers = 0;      // transactions rolled back
+    };
+
+    RecoveryManager(BufferPoolManager* bpm, LogManager* log) : bpm_(bpm), log_(log) {}
+    // Stops the checkpoint thread
+    ~RecoveryManager();
+
+    RecoveryManager(const RecoveryManager&) = delete;
+    RecoveryManager& operator=(const RecoveryManager&) = delete;
+
+    // Restart: analysis, redo, undo, then a checkpoint
+    Stats recover();
+
+    // Fuzzy checkpoint; returns the LSN of its CHECKPOINT_BEGIN
+    lsn_t checkpoint();
+
+    // Checkpoint every interval from a background thread, whenever the log
+    // has grown since the last one
+    void start_checkpoints(std::chrono::milliseconds interval);
+
+private:
+    // Apply rec again to page_id if the page is older than rec; true if it was
+    bool redo_page(uint32_t page_id, const LogRecord& rec);
+    // Roll back rec (an INSERT or MARK_DELETE of txn) and log the CLR
+    void undo_change(const LogRecord& rec, Txn& txn);
+    void checkpoint_loop();
+
+    BufferPoolManager* bpm_;
+    LogManager*        log_;
+    std::mutex         checkpoint_latch_;     // one checkpoint at a time
+    std::atomic<lsn_t> checkpoint_end_{ INVALID_LSN };   // last CHECKPOINT_END
+
+    std::chrono::milliseconds checkpoint_interval_{ 0 };
+    std::mutex                stop_latch_;
+    std::condition_variable   stop_cv_;
+    bool                      stop_ = false;  // guarded by stop_latch_
+    std::thread               checkpointer_;
+};
@@ -1,146 +1,1162 @@
 /************************  bplus_tree.hpp  ***********************
- * Header-only generic B+-tree (order = max keys per node)
- * - key   : int
- * - value : templated ValueT   (e.g. RID, Tuple, std::string)
+ * Header-only, disk-resident B+-tree
+ * - key   : int, or std::string holding fixed-width byte strings that
+ *           order by memcmp (CHAR(n) values, encoded composite keys)
+ * - value : templated ValueT, trivially copyable (e.g. RID)
+ *
+ * Keys are unique. An index that needs duplicates appends a tie-breaker
+ * to the key (see index.hpp).
+ *
+ * Every node is one Page fetched and pinned through the
+ * BufferPoolManager, so the index persists with the data file, can be
+ * larger than memory and shares the page cache with the heaps.
+ *
+ * Node layout (after the Page header):
+ *
+ *   int keys:   [is_leaf u16][count u16][next u32][pad to 64][keys int32 * CAP][payload]
+ *   byte keys:  [is_leaf u16][count u16][next u32][prefix_len u16][pad to 64]
+ *               [prefix][suffix * count -->   free   <-- payload]
+ *
+ * Int keys are one contiguous array starting on a cache line, so a node
+ * visit touches only the lines its search needs. The search itself is
+ * SIMD (simd_search.hpp). Leaves store ValueT * LEAF_MAX as payload,
+ * internal nodes INNER_MAX + 1 child page ids. Fanout caps both
+ * capacities (0 = as many as fit in a page).
+ *
+ * Byte keys are prefix compressed: the leading bytes every key in a node
+ * shares are stored once and each slot holds only the rest, while the
+ * payload (values, or child ids) grows down from the end of the page. A
+ * node holds as many entries as fit, so keys with long common prefixes
+ * give a higher fanout. A search compares the probe with the prefix once
+ * and then binary-searches the suffixes. A key that shares the node's
+ * prefix is inserted in place; one that does not rewrites the node with
+ * the shorter prefix (or splits it).
+ *
+ * Leaves chain to their right sibling through `next`. A separate meta
+ * page holds the root page id (and the key width), so the tree is
+ * identified by a page id that never changes.
+ *
+ * Concurrency: optimistic lock coupling on the page version counters
+ * (Page::version). Readers take no latches. They read a node, read its
+ * child's version, then check that the node's version has not changed,
+ * and start again from the root if it has. Writers descend the same
+ * way and w_latch only what they change: the leaf, or for a split or
+ * merge the nodes from the deepest one that absorbs the change down to
+ * the leaf (plus the sibling being merged with). A latched node must
+ * still have the version the descent saw, so there is no tree-wide lock.
+ * Removes keep nodes at least half full by borrowing from or merging
+ * with a sibling. "No latches" means no page latches: every node below
+ * the root is still pinned through BufferPoolManager::fetch_page, which
+ * takes the page's shard mutex for the pin and again for the unpin, so
+ * readers on the same shard do serialize briefly there. The tree keeps
+ * its root pinned, so descents don't all queue on the one page they share.
+ *
+ * A merge leaves the right node's page behind: an iterator or descent
+ * may still hold it, and the pool has no free-page list to return it to,
+ * so a tree that shrinks keeps its pages.
+ *
+ * Range scans: lower_bound(key) descends once and returns an Iterator
+ * that walks the leaf chain, so a scan of k entries costs O(log n + k)
+ * page visits.
+ *
+ * Index builds: bulk_load() takes sorted key/value pairs and writes the
+ * leaves left to right at a chosen fill factor, then each internal level
+ * over the one below, instead of one descent (and maybe a split) per key.
  *****************************************************************/
 #pragma once
 #include <vector>
-#include <memory>
 #include <optional>
 #include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include "buffer_pool_manager.hpp"
+#include "key_width.hpp"
+#include "simd_search.hpp"
 
-template <typename ValueT>
+template <typename KeyT, typename ValueT, size_t Fanout = 0>
 class BPlusTree {
+    static constexpr bool INT_KEYS = std::is_same_v<KeyT, int>;
+    static_assert(INT_KEYS || std::is_same_v<KeyT, std::string>, "keys are int or byte strings (std::string)");
+    static_assert(std::is_trivially_copyable_v<ValueT>, "B+-tree values are stored as raw bytes");
+    static_assert(Fanout == 0 || Fanout >= 3, "nodes must hold at least 3 keys");
+
+    /* ================= PAGE LAYOUT =============== */
+    static constexpr size_t IS_LEAF_POS = Page::HEADER_SIZE;        // u16
+    static constexpr size_t COUNT_POS = Page::HEADER_SIZE + 2;      // u16
+    static constexpr size_t NEXT_POS = Page::HEADER_SIZE + 4;       // u32
+    static constexpr size_t PREFIX_POS = Page::HEADER_SIZE + 8;     // u16, byte keys
+    static constexpr size_t KEYS_POS = 64;                          // first cache line is header
+    static constexpr size_t ROOT_POS = Page::HEADER_SIZE;           // meta page: u32
+    static constexpr size_t WIDTH_POS = Page::HEADER_SIZE + 4;      // meta page: u32
+
+    static constexpr size_t align_up(size_t n, size_t a) { return (n + a - 1) / a * a; }
+    static constexpr size_t cap(size_t fits) { return Fanout ? std::min(Fanout, fits) : fits; }
+    static constexpr size_t leaf_fit() {
+        size_t n = (Page::PAGE_SIZE - KEYS_POS) / (sizeof(int) + sizeof(ValueT));
+        while (align_up(KEYS_POS + n * sizeof(int), alignof(ValueT)) + n * sizeof(ValueT) > Page::PAGE_SIZE) --n;
+        return n;
+    }
+
 public:
-    explicit BPlusTree(int order = 4) : order_(order) {
-        root_ = std::make_shared<Node>(true);
+    static constexpr uint32_t INVALID_PAGE = UINT32_MAX;
+    // Node capacities with int keys
+    static constexpr size_t LEAF_MAX = cap(leaf_fit());
+    static constexpr size_t INNER_MAX = cap((Page::PAGE_SIZE - KEYS_POS - sizeof(uint32_t)) / (sizeof(int) + sizeof(uint32_t)));
+    // Fewest entries (keys) a non-root node is left with by remove
+    static constexpr size_t LEAF_MIN = LEAF_MAX / 2;
+    static constexpr size_t INNER_MIN = INNER_MAX / 2;
+    // Widest byte key: an internal node must still hold 3 keys uncompressed
+    static constexpr size_t MAX_KEY_WIDTH = (Page::PAGE_SIZE - KEYS_POS) / 4 - 2 * sizeof(uint32_t);
+
+    // Creates an empty tree (meta page + one empty leaf)
+    explicit BPlusTree(BufferPoolManager* bpm) requires INT_KEYS : bpm_(bpm), width_(sizeof(int)) { create(); }
+
+    BPlusTree(BufferPoolManager* bpm, KeyWidth width) requires (!INT_KEYS) : bpm_(bpm), width_(width.bytes) {
+        if (width_ == 0 || width_ > MAX_KEY_WIDTH) throw std::runtime_error("index key width out of range");
+        create();
     }
 
+    // Opens a tree previously created on the same file
+    BPlusTree(BufferPoolManager* bpm, uint32_t meta_page_id)
+        : bpm_(bpm), meta_page_id_(meta_page_id) {
+        Page* meta = fetch(meta_page_id_);
+        uint32_t root_id = *reinterpret_cast<const uint32_t*>(meta->data() + ROOT_POS);
+        width_ = INT_KEYS ? sizeof(int) : *reinterpret_cast<const uint32_t*>(meta->data() + WIDTH_POS);
+        bpm_->unpin_page(meta_page_id_, false);
+        if (width_ == 0 || width_ > MAX_KEY_WIDTH) throw std::runtime_error("index meta page is corrupt");
+        set_limits();
+        root_.store(fetch(root_id));
+    }
+
+    ~BPlusTree() { bpm_->unpin_page(root_.load()->get_page_id(), false); }
+
+    BPlusTree(const BPlusTree&) = delete;
+    BPlusTree& operator=(const BPlusTree&) = delete;
+
+    uint32_t meta_page() const { return meta_page_id_; }
+    size_t key_width() const { return width_; }
+
     /* ================= PUBLIC API ================ */
+    // Byte keys shorter than key_width() are padded with '\0'
 
     /// returns false if duplicate key
-    bool insert(int key, const ValueT& value) {
-        int up_key = 0; NodePtr new_child{};
-        if (!insert_inner(root_, key, value, up_key, new_child)) return false;
+    bool insert(const KeyT& raw_key, const ValueT& value) {
+        const KeyT key = normalize(raw_key);
+        std::vector<Visit> path;
+        for (;;) {
+            Visit leaf;
+            if (!descend(key, leaf, &path)) continue;
+            Node node = view(leaf.page);
+            size_t n = leaf.count;
+            size_t pos = node.lower(key, n);
+            bool dup = pos < n && node.key_is(pos, key);
+            bool room = node.room_for(key, n);
+            if (!leaf.page->validate(leaf.version)) { release(leaf); continue; }
+            if (dup) { release(leaf); return false; }
 
-        if (new_child) {                               // root split
-            auto new_root = std::make_shared<Node>(false);
-            new_root->keys = { up_key };
-            new_root->children = { root_, new_child };
-            root_ = new_root;
+            if (room) {                              // room: latch the leaf only
+                if (!lock(leaf)) { release(leaf); continue; }
+                node.insert_entry(pos, n, key, value);
+                unlock(leaf);
+                return true;
+            }
+
+            path.push_back(leaf);
+            Outcome r = insert_split(key, value, path);
+            if (r != Outcome::RESTART) return r == Outcome::DONE;
+        }
+    }
+
+    std::optional<ValueT> search(const KeyT& raw_key) const {
+        const KeyT key = normalize(raw_key);
+        for (;;) {
+            Visit leaf;
+            if (!descend(key, leaf, nullptr)) continue;
+            Node node = view(leaf.page);
+            size_t n = leaf.count;
+            size_t pos = node.lower(key, n);
+            std::optional<ValueT> out;
+            if (pos < n && node.key_is(pos, key)) out = node.value(pos);
+            bool ok = leaf.page->validate(leaf.version);
+            release(leaf);
+            if (ok) return out;
         }
-        return true;
     }
 
-    std::optional<ValueT> search(int key) const {
-        return search_inner(root_, key);
+    bool remove(const KeyT& raw_key) {
+        const KeyT key = normalize(raw_key);
+        std::vector<Visit> path;
+        for (;;) {
+            Visit leaf;
+            if (!descend(key, leaf, &path)) continue;
+            Node node = view(leaf.page);
+            size_t n = leaf.count;
+            size_t pos = node.lower(key, n);
+            bool found = pos < n && node.key_is(pos, key);
+            if (!leaf.page->validate(leaf.version)) { release(leaf); continue; }
+            if (!found) { release(leaf); return false; }
+
+            if (n > leaf_min_ || path.empty()) {     // stays half full (or is the root)
+                if (!lock(leaf)) { release(leaf); continue; }
+                node.erase_entry(pos, n);
+                unlock(leaf);
+                return true;
+            }
+
+            path.push_back(leaf);
+            Outcome r = remove_rebalance(key, path);
+            if (r != Outcome::RESTART) return r == Outcome::DONE;
+        }
     }
 
-    bool remove(int key) {                             // simple (no merge)
-        return remove_inner(root_, key);
+    /// Builds the tree bottom-up from pairs sorted by strictly increasing
+    /// key (*it is a std::pair<KeyT, ValueT>); [first, last) is read once.
+    /// fill_factor in (0, 1] is the share of each node filled; the tree
+    /// must be empty. Other users wait on the root until the load is done.
+    template <typename It>
+    void bulk_load(It first, It last, double fill_factor = 1.0) {
+        if (!(fill_factor > 0.0 && fill_factor <= 1.0)) throw std::runtime_error("fill factor must be in (0, 1]");
+        // Int nodes are filled to a number of entries, byte-key nodes to a number of bytes
+        const size_t leaf_cap = std::max<size_t>(1, static_cast<size_t>(LEAF_MAX * fill_factor));
+        const size_t inner_cap = std::max<size_t>(2, static_cast<size_t>(INNER_MAX * fill_factor));
+        const size_t budget = KEYS_POS + static_cast<size_t>((Page::PAGE_SIZE - KEYS_POS) * fill_factor);
+
+        // The empty root leaf becomes the leftmost leaf
+        Page* root = root_.load();
+        uint32_t root_id = root->get_page_id();
+        fetch(root_id);                              // our own pin, released dirty
+        root->w_latch();
+
+        // Each leaf is written once the next one is started, and the last
+        // two together, so the tail can be evened out
+        std::vector<KeyT> keys, prev_keys;
+        std::vector<ValueT> values, prev_values;
+        Page* leaf = root;
+        Page* prev = nullptr;
+        auto fail = [&](const char* what) {
+            for (Page* p : { prev, leaf })
+                if (p && p != root) bpm_->unpin_page(p->get_page_id(), true);
+            root->w_unlatch();
+            bpm_->unpin_page(root_id, true);
+            throw std::runtime_error(what);
+        };
+        if (root != root_.load() || !view(root).is_leaf() || view(root).count() != 0) fail("bulk_load needs an empty tree");
+
+        std::vector<std::pair<KeyT, uint32_t>> level;    // (first key, page) per node
+        auto emit = [&](Page* page, const std::vector<KeyT>& k, const std::vector<ValueT>& v, uint32_t next) {
+            Node node = view(page);
+            node.write_leaf(k, v);
+            node.set_next(next);
+            level.emplace_back(k.front(), page->get_page_id());
+            if (page != root) bpm_->unpin_page(page->get_page_id(), true);
+        };
+        auto leaf_full = [&](const KeyT& key) {
+            if constexpr (INT_KEYS) {
+                return keys.size() >= leaf_cap;
+            } else {
+                size_t n = keys.size() + 1, p = common_prefix(keys.front(), key);
+                return n > max_count(true, p) || node_bytes(true, n, p) > budget;
+            }
+        };
+
+        bool any = false;
+        KeyT last_key{};
+        for (; first != last; ++first) {
+            const auto& [raw_key, value] = *first;
+            if constexpr (!INT_KEYS) {
+                if (raw_key.size() > width_) fail("index key longer than the key width");
+            }
+            KeyT key = normalize(raw_key);
+            if (any && !(last_key < key)) fail("bulk_load input must be sorted by unique key");
+            if (!keys.empty() && leaf_full(key)) {       // full: chain a fresh leaf
+                uint32_t next_id;
+                Page* next = bpm_->new_page(next_id);
+                if (!next) fail("Failed to allocate index page");
+                init_node(next, true);
+                if (prev) emit(prev, prev_keys, prev_values, leaf->get_page_id());
+                prev = leaf;
+                std::swap(prev_keys, keys);              // keeps both buffers' capacity
+                std::swap(prev_values, values);
+                keys.clear();
+                values.clear();
+                leaf = next;
+            }
+            keys.push_back(key);
+            values.push_back(value);
+            last_key = std::move(key);
+            any = true;
+        }
+        if (prev) {
+            // A nearly empty last leaf borrows from its left neighbour
+            if (keys.size() < leaf_min_ && prev_keys.size() > keys.size() + 1) {
+                prev_keys.insert(prev_keys.end(), keys.begin(), keys.end());
+                prev_values.insert(prev_values.end(), values.begin(), values.end());
+                size_t s = split_point(true, prev_keys);
+                keys.assign(prev_keys.begin() + s, prev_keys.end());
+                values.assign(prev_values.begin() + s, prev_values.end());
+                prev_keys.resize(s);
+                prev_values.resize(s);
+            }
+            emit(prev, prev_keys, prev_values, leaf->get_page_id());
+            prev = nullptr;
+        }
+        if (!keys.empty()) emit(leaf, keys, values, INVALID_PAGE);
+        leaf = nullptr;
+
+        // Internal levels: fill each parent in turn, at least three children
+        // apiece; a lone child at the end takes one from its neighbour
+        auto inner_full = [&](size_t b, size_t e) {      // children level[b, e] in one node?
+            size_t n = e - b;
+            if (n < 2) return false;
+            if constexpr (INT_KEYS) {
+                return n > inner_cap;
+            } else {
+                size_t p = common_prefix(level[b + 1].first, level[e].first);
+                return n > max_count(false, p) || node_bytes(false, n, p) > budget;
+            }
+        };
+        while (level.size() > 1) {
+            std::vector<std::pair<size_t, size_t>> groups;
+            for (size_t b = 0; b < level.size();) {
+                size_t e = b + 1;
+                while (e < level.size() && !inner_full(b, e)) ++e;
+                groups.emplace_back(b, e);
+                b = e;
+            }
+            if (groups.size() > 1 && groups.back().second - groups.back().first == 1) {
+                --groups[groups.size() - 2].second;
+                --groups.back().first;
+            }
+            std::vector<std::pair<KeyT, uint32_t>> up;
+            for (auto [b, e] : groups) {
+                uint32_t id;
+                Page* inner_page = bpm_->new_page(id);
+                if (!inner_page) fail("Failed to allocate index page");
+                init_node(inner_page, false);
+                std::vector<KeyT> seps;
+                std::vector<uint32_t> children;
+                for (size_t i = b; i < e; ++i) {
+                    if (i > b) seps.push_back(level[i].first);
+                    children.push_back(level[i].second);
+                }
+                view(inner_page).write_inner(seps, children);
+                bpm_->unpin_page(id, true);
+                up.emplace_back(level[b].first, id);
+            }
+            level = std::move(up);
+        }
+
+        if (!level.empty() && level[0].second != root_id) set_root(root, fetch(level[0].second));
+        root->w_unlatch();
+        bpm_->unpin_page(root_id, true);
     }
 
 private:
-    /* ================= NODE DEF ================== */
-    struct Node;
-    using NodePtr = std::shared_ptr<Node>;
-    struct Node {
-        bool is_leaf;
-        std::vector<int>     keys;
-        std::vector<NodePtr> children;   // internal
-        std::vector<ValueT>  values;     // leaf
-        NodePtr              next;       // leaf chaining
-        explicit Node(bool leaf) : is_leaf(leaf) {}
+    /* ================= NODE VIEW ================= */
+    // Typed view over a pinned node page; all fields live in the page bytes.
+    // Offsets are bounded by the page, so a view can be read optimistically
+    // while the node changes (the result is discarded on validation).
+    class Node {
+    public:
+        Node(Page* page, size_t width) : raw_(page->data()), width_(width) {}
+
+        bool is_leaf() const { return field<uint16_t>(IS_LEAF_POS) != 0; }
+        size_t count() const { return field<uint16_t>(COUNT_POS); }
+        uint32_t next() const { return field<uint32_t>(NEXT_POS); }
+        void set_count(size_t n) { field<uint16_t>(COUNT_POS) = static_cast<uint16_t>(n); }
+        void set_next(uint32_t id) { field<uint32_t>(NEXT_POS) = id; }
+
+        // count(), clamped to what the page can hold
+        size_t safe_count() const {
+            if constexpr (INT_KEYS) return std::min(count(), is_leaf() ? LEAF_MAX : INNER_MAX);
+            else return std::min(count(), max_count(is_leaf(), width_, prefix_len()));
+        }
+
+        // Position of the first key >= key (lower) or > key (upper) among n
+        size_t lower(const KeyT& key, size_t n) const { return search<true>(key, n); }
+        size_t upper(const KeyT& key, size_t n) const { return search<false>(key, n); }
+
+        KeyT key(size_t i) const {
+            if constexpr (INT_KEYS) {
+                return keys()[i];
+            } else {
+                size_t p = prefix_len();
+                std::string out(width_, '\0');
+                if (i >= key_room(p)) return out;
+                std::memcpy(out.data(), raw_ + KEYS_POS, p);
+                std::memcpy(out.data() + p, raw_ + KEYS_POS + p + i * (width_ - p), width_ - p);
+                return out;
+            }
+        }
+        bool key_is(size_t i, const KeyT& key) const {
+            if constexpr (INT_KEYS) {
+                return keys()[i] == key;
+            } else {
+                size_t p = prefix_len();
+                return i < key_room(p) && std::memcmp(key.data(), raw_ + KEYS_POS, p) == 0 &&
+                       std::memcmp(key.data() + p, raw_ + KEYS_POS + p + i * (width_ - p), width_ - p) == 0;
+            }
+        }
+        ValueT value(size_t i) const {
+            if constexpr (INT_KEYS) return values()[i];
+            else return from_end<ValueT>(i);
+        }
+        uint32_t child(size_t i) const {
+            if constexpr (INT_KEYS) return children()[i];
+            else return from_end<uint32_t>(i);
+        }
+
+        // Append entries [from, n) of a leaf, or all n keys and n + 1 children of an inner node
+        void read_leaf(size_t from, size_t n, std::vector<KeyT>& keys, std::vector<ValueT>& values) const {
+            if constexpr (INT_KEYS) {
+                keys.insert(keys.end(), this->keys() + from, this->keys() + n);
+                values.insert(values.end(), this->values() + from, this->values() + n);
+            } else {
+                for (size_t i = from; i < n; ++i) {
+                    keys.push_back(key(i));
+                    values.push_back(value(i));
+                }
+            }
+        }
+        void read_inner(size_t n, std::vector<KeyT>& keys, std::vector<uint32_t>& children) const {
+            for (size_t i = 0; i < n; ++i) keys.push_back(key(i));
+            for (size_t i = 0; i <= n; ++i) children.push_back(child(i));
+        }
+
+        // Can key go in without rewriting the node? Byte keys must share
+        // the node's prefix. The prefix may end up shorter than all keys
+        // share after removes, which is harmless
+        bool room_for(const KeyT& key, size_t n) const {
+            if constexpr (INT_KEYS) {
+                return n < (is_leaf() ? LEAF_MAX : INNER_MAX);
+            } else {
+                size_t p = prefix_len();
+                return std::memcmp(key.data(), raw_ + KEYS_POS, p) == 0 && n + 1 <= max_count(is_leaf(), width_, p);
+            }
+        }
+
+        // In-place edits of a latched node of n keys (room_for checked)
+        void insert_entry(size_t pos, size_t n, const KeyT& key, const ValueT& value) {
+            if constexpr (INT_KEYS) {
+                shift_in(keys(), n, pos, key);
+                shift_in(values(), n, pos, value);
+            } else {
+                insert_slot(pos, n, key);
+                insert_from_end(pos, n, value);
+            }
+            set_count(n + 1);
+        }
+        void insert_child(size_t idx, size_t n, const KeyT& key, uint32_t child) {
+            if constexpr (INT_KEYS) {
+                shift_in(keys(), n, idx, key);
+                shift_in(children(), n + 1, idx + 1, child);
+            } else {
+                insert_slot(idx, n, key);
+                insert_from_end(idx + 1, n + 1, child);
+            }
+            set_count(n + 1);
+        }
+        void erase_entry(size_t pos, size_t n) {
+            if constexpr (INT_KEYS) {
+                shift_out(keys(), n, pos);
+                shift_out(values(), n, pos);
+            } else {
+                size_t p = prefix_len(), w = width_ - p;
+                std::byte* slot = raw_ + KEYS_POS + p + pos * w;
+                std::memmove(slot, slot + w, (n - pos - 1) * w);
+                std::byte* end = raw_ + Page::PAGE_SIZE;
+                std::memmove(end - (n - 1) * sizeof(ValueT), end - n * sizeof(ValueT), (n - pos - 1) * sizeof(ValueT));
+            }
+            set_count(n - 1);
+        }
+
+        // Replace the node's entries; the caller has checked that they fit
+        void write_leaf(std::span<const KeyT> keys, std::span<const ValueT> values) {
+            if constexpr (INT_KEYS) {
+                std::copy(keys.begin(), keys.end(), this->keys());
+                std::copy(values.begin(), values.end(), this->values());
+            } else {
+                write_keys(keys);
+                for (size_t i = 0; i < values.size(); ++i) to_end(i, values[i]);
+            }
+            set_count(keys.size());
+        }
+        void write_inner(std::span<const KeyT> keys, std::span<const uint32_t> children) {
+            if constexpr (INT_KEYS) {
+                std::copy(keys.begin(), keys.end(), this->keys());
+                std::copy(children.begin(), children.end(), this->children());
+            } else {
+                write_keys(keys);
+                for (size_t i = 0; i < children.size(); ++i) to_end(i, children[i]);
+            }
+            set_count(keys.size());
+        }
+
+        // Int keys: the arrays, for in-place updates
+        int* keys() const { return reinterpret_cast<int*>(raw_ + KEYS_POS); }
+        ValueT* values() const {
+            return reinterpret_cast<ValueT*>(raw_ + align_up(KEYS_POS + LEAF_MAX * sizeof(int), alignof(ValueT)));
+        }
+        uint32_t* children() const {
+            return reinterpret_cast<uint32_t*>(raw_ + KEYS_POS + INNER_MAX * sizeof(int));
+        }
+
+    private:
+        template <typename T>
+        T& field(size_t pos) const { return *reinterpret_cast<T*>(raw_ + pos); }
+
+        template <bool Strict>
+        size_t search(const KeyT& key, size_t n) const {
+            if constexpr (INT_KEYS) {
+                return Strict ? simd::lower_bound(keys(), n, key) : simd::upper_bound(keys(), n, key);
+            } else {
+                // Against the shared prefix first: it settles the probe for the whole node
+                size_t p = prefix_len();
+                if (int c = std::memcmp(key.data(), raw_ + KEYS_POS, p)) return c < 0 ? 0 : n;
+                n = std::min(n, key_room(p));
+                const std::byte* slots = raw_ + KEYS_POS + p;
+                const char* probe = key.data() + p;
+                size_t w = width_ - p, lo = 0, hi = n;
+                while (lo < hi) {
+                    size_t mid = (lo + hi) / 2;
+                    int c = std::memcmp(slots + mid * w, probe, w);
+                    if (Strict ? c < 0 : c <= 0) lo = mid + 1;
+                    else hi = mid;
+                }
+                return lo;
+            }
+        }
+
+        // Byte keys
+        size_t prefix_len() const { return std::min<size_t>(field<uint16_t>(PREFIX_POS), width_); }
+        size_t key_room(size_t p) const {
+            return p < width_ ? (Page::PAGE_SIZE - KEYS_POS - p) / (width_ - p) : SIZE_MAX;
+        }
+
+        void write_keys(std::span<const KeyT> keys) {
+            size_t p = keys.empty() ? 0 : common_prefix(keys.front(), keys.back());
+            field<uint16_t>(PREFIX_POS) = static_cast<uint16_t>(p);
+            if (keys.empty()) return;
+            std::memcpy(raw_ + KEYS_POS, keys.front().data(), p);
+            std::byte* slot = raw_ + KEYS_POS + p;
+            for (const KeyT& k : keys) {
+                std::memcpy(slot, k.data() + p, width_ - p);
+                slot += width_ - p;
+            }
+        }
+
+        void insert_slot(size_t pos, size_t n, const KeyT& key) {
+            size_t p = prefix_len(), w = width_ - p;
+            std::byte* slot = raw_ + KEYS_POS + p + pos * w;
+            std::memmove(slot + w, slot, (n - pos) * w);
+            std::memcpy(slot, key.data() + p, w);
+        }
+
+        // Payload slot i, counted back from the end of the page
+        template <typename T>
+        T from_end(size_t i) const {
+            T out{};
+            if (i < (Page::PAGE_SIZE - KEYS_POS) / sizeof(T))
+                std::memcpy(&out, raw_ + Page::PAGE_SIZE - (i + 1) * sizeof(T), sizeof(T));
+            return out;
+        }
+        template <typename T>
+        void to_end(size_t i, const T& v) { std::memcpy(raw_ + Page::PAGE_SIZE - (i + 1) * sizeof(T), &v, sizeof(T)); }
+        // Make room at slot i of n (the ones from i on move one further from the end)
+        template <typename T>
+        void insert_from_end(size_t i, size_t n, const T& v) {
+            std::byte* end = raw_ + Page::PAGE_SIZE;
+            std::memmove(end - (n + 1) * sizeof(T), end - n * sizeof(T), (n - i) * sizeof(T));
+            to_end(i, v);
+        }
+
+        std::byte* raw_;
+        size_t     width_;
+    };
+
+    // A node as a descent saw it; count is only to be trusted once the
+    // version has been validated (or the page is w_latched)
+    struct Visit {
+        Page*    page = nullptr;
+        uint64_t version = 0;
+        uint32_t id = INVALID_PAGE;
+        size_t   count = 0;
+        bool     pinned = false;     // a pin of ours (the root's own pin is the tree's)
     };
 
-    NodePtr root_;
-    int     order_;                      // max keys
+    enum class Outcome { DONE, NO_OP, RESTART };
+
+public:
+    /* ================= ITERATOR ================== */
+    // Forward cursor over the leaf chain. Each leaf is copied out with an
+    // optimistic read, so no latch is held between steps and the tree may
+    // be modified while iterating; the current leaf stays pinned. Before
+    // moving on, the cursor re-checks the leaf it is leaving. If entries
+    // may have moved across (split, borrow, merge), it descends again from
+    // the last key it returned, so no entry present throughout is missed.
+    class Iterator {
+    public:
+        Iterator(Iterator&& o) noexcept
+            : tree_(o.tree_), leaf_(o.leaf_), keys_(std::move(o.keys_)), values_(std::move(o.values_)),
+              pos_(o.pos_), next_(o.next_), resume_(std::move(o.resume_)), resume_after_(o.resume_after_) {
+            o.leaf_.pinned = false;
+        }
+        Iterator(const Iterator&) = delete;
+        Iterator& operator=(const Iterator&) = delete;
+        ~Iterator() { tree_->release(leaf_); }
+
+        bool valid() const { return pos_ < keys_.size(); }
+        const KeyT& key() const { return keys_[pos_]; }
+        const ValueT& value() const { return values_[pos_]; }
+
+        Iterator& operator++() {
+            if (++pos_ == keys_.size()) advance();
+            return *this;
+        }
+
+    private:
+        friend class BPlusTree;
+        Iterator(const BPlusTree* tree, const KeyT& from) : tree_(tree) { seek(from, false); }
+
+        // Copy a leaf's entries >= from (> from if after; all if from is
+        // null); false if it changed meanwhile
+        bool copy(const Visit& leaf, const KeyT* from, bool after) {
+            Node node = tree_->view(leaf.page);
+            size_t n = node.safe_count();
+            size_t start = !from ? 0 : after ? node.upper(*from, n) : node.lower(*from, n);
+            keys_.clear();
+            values_.clear();
+            node.read_leaf(std::min(start, n), n, keys_, values_);
+            next_ = node.next();
+            pos_ = 0;
+            return leaf.page->validate(leaf.version);
+        }
+
+        void seek(KeyT from, bool after) {
+            tree_->release(leaf_);
+            for (;;) {
+                Visit leaf;
+                if (!tree_->descend(from, leaf, nullptr)) continue;
+                if (copy(leaf, &from, after)) { leaf_ = leaf; break; }
+                tree_->release(leaf);
+            }
+            resume_ = std::move(from);
+            resume_after_ = after;
+            note_resume();
+            if (keys_.empty()) advance();
+        }
+
+        // Move to the next non-empty leaf, or to the end
+        void advance() {
+            for (;;) {
+                if (next_ == INVALID_PAGE) {
+                    tree_->release(leaf_);
+                    keys_.clear();
+                    pos_ = 0;
+                    return;
+                }
+                uint32_t next_id = next_;
+                Visit nv{ tree_->fetch(next_id), 0, next_id, 0, true };
+                nv.version = nv.page->version();
+                if ((nv.version & 1) || !copy(nv, nullptr, false)) {
+                    tree_->release(nv);                  // torn copy: retry the same leaf
+                    next_ = next_id;
+                    std::this_thread::yield();
+                    continue;
+                }
+                if (!leaf_.page->validate(leaf_.version)) {
+                    tree_->release(nv);
+                    seek(resume_, resume_after_);
+                    return;
+                }
+                tree_->release(leaf_);
+                leaf_ = nv;
+                note_resume();
+                if (!keys_.empty()) return;
+            }
+        }
+
+        void note_resume() {
+            if (keys_.empty()) return;
+            resume_ = keys_.back();
+            resume_after_ = true;
+        }
+
+        const BPlusTree*    tree_;
+        Visit               leaf_;
+        std::vector<KeyT>   keys_;
+        std::vector<ValueT> values_;
+        size_t              pos_ = 0;
+        uint32_t            next_ = INVALID_PAGE;
+        KeyT                resume_{};                   // entries not yet returned are
+        bool                resume_after_ = false;       // >= resume_ (> if resume_after_)
+    };
+
+    // First entry with key >= key
+    Iterator lower_bound(const KeyT& key) const { return Iterator(this, normalize(key)); }
+
+    Iterator begin() const {
+        if constexpr (INT_KEYS) return lower_bound(INT_MIN);
+        else return lower_bound(std::string(width_, '\0'));
+    }
+
+private:
+    BufferPoolManager*  bpm_;
+    uint32_t            meta_page_id_ = INVALID_PAGE;
+    size_t              width_;                  // key bytes
+    size_t              leaf_min_ = LEAF_MIN;    // underflow thresholds
+    size_t              inner_min_ = INNER_MIN;
+    size_t              inner_room_ = INNER_MAX; // an inner node below this count takes any key
+    std::atomic<Page*>  root_{ nullptr };        // pinned by the tree while it is the root
 
     /* ================= HELPERS =================== */
-    static int lower(const std::vector<int>& v, int k) {
-        return std::lower_bound(v.begin(), v.end(), k) - v.begin();
+    Node view(Page* page) const { return Node(page, width_); }
+
+    KeyT normalize(const KeyT& key) const {
+        if constexpr (INT_KEYS) {
+            return key;
+        } else {
+            if (key.size() > width_) throw std::runtime_error("index key longer than the key width");
+            KeyT out = key;
+            out.resize(width_, '\0');
+            return out;
+        }
+    }
+
+    // Byte keys: bytes a node of n keys sharing p leading bytes takes, and
+    // the most keys that fit when they share p bytes
+    static size_t node_bytes(bool leaf, size_t n, size_t p, size_t width) {
+        return KEYS_POS + p + n * (width - p) + (leaf ? n * sizeof(ValueT) : (n + 1) * sizeof(uint32_t));
     }
-    static int upper(const std::vector<int>& v, int k) {
-        return std::upper_bound(v.begin(), v.end(), k) - v.begin();
+    size_t node_bytes(bool leaf, size_t n, size_t p) const { return node_bytes(leaf, n, p, width_); }
+    static size_t max_count(bool leaf, size_t width, size_t p) {
+        size_t room = Page::PAGE_SIZE - KEYS_POS - p - (leaf ? 0 : sizeof(uint32_t));
+        return cap(std::min<size_t>(UINT16_MAX, room / (width - p + (leaf ? sizeof(ValueT) : sizeof(uint32_t)))));
     }
+    size_t max_count(bool leaf, size_t p) const { return max_count(leaf, width_, p); }
 
-    /* ---------- insertion recursion ------------- */
-    bool insert_inner(NodePtr n, int key, const ValueT& val,
-        int& up_key, NodePtr& new_child)
-    {
-        /* leaf */
-        if (n->is_leaf) {
-            int pos = lower(n->keys, key);
-            if (pos < n->keys.size() && n->keys[pos] == key) return false; // dup
+    static size_t common_prefix(const KeyT& a, const KeyT& b) {
+        if constexpr (INT_KEYS) return 0;
+        else return std::mismatch(a.begin(), a.end(), b.begin(), b.end()).first - a.begin();
+    }
 
-            n->keys.insert(n->keys.begin() + pos, key);
-            n->values.insert(n->values.begin() + pos, val);
+    // Do these sorted keys fit in one node?
+    bool fits(bool leaf, std::span<const KeyT> keys) const {
+        if constexpr (INT_KEYS) {
+            return keys.size() <= (leaf ? LEAF_MAX : INNER_MAX);
+        } else {
+            if (keys.empty()) return true;
+            return keys.size() <= max_count(leaf, common_prefix(keys.front(), keys.back()));
+        }
+    }
 
-            if ((int)n->keys.size() < order_) { new_child = nullptr; return true; }
-            split_leaf(n, up_key, new_child);
-            return true;
+    // Where to cut a run of entries that overflows a node, as near the
+    // middle as both halves allow. Leaves keep [0, s) and [s, n); for an
+    // internal node keys[s] moves up and the halves keep the rest.
+    size_t split_point(bool leaf, const std::vector<KeyT>& keys) const {
+        std::span<const KeyT> all(keys);
+        size_t n = keys.size(), mid = n / 2;
+        auto ok = [&](size_t s) {
+            size_t right = leaf ? s : s + 1;
+            return s >= 1 && right < n && fits(leaf, all.subspan(0, s)) && fits(leaf, all.subspan(right));
+        };
+        for (size_t d = 0; d <= mid; ++d) {
+            if (ok(mid - d)) return mid - d;
+            if (ok(mid + d)) return mid + d;
+        }
+        throw std::runtime_error("index node cannot be split");
+    }
+
+    void set_limits() {
+        if constexpr (!INT_KEYS) {
+            // Counts for uncompressed keys: a node below half of that is underfull
+            leaf_min_ = max_count(true, 0) / 2;
+            inner_min_ = max_count(false, 0) / 2;
+            inner_room_ = max_count(false, 0);
+        }
+    }
+
+    void create() {
+        set_limits();
+        Page* meta = bpm_->new_page(meta_page_id_);
+        if (!meta) throw std::runtime_error("Failed to allocate index meta page");
+        uint32_t root_id;
+        Page* root = bpm_->new_page(root_id);
+        if (!root) throw std::runtime_error("Failed to allocate index root");
+        init_node(root, true);
+
+        *reinterpret_cast<uint32_t*>(meta->data() + WIDTH_POS) = static_cast<uint32_t>(width_);
+        write_meta(meta, root_id);
+        bpm_->unpin_page(meta_page_id_, true);
+        root_.store(root);                           // keeps new_page's pin
+    }
+
+    template <typename T>
+    static void shift_in(T* arr, size_t n, size_t pos, const T& v) {
+        std::memmove(arr + pos + 1, arr + pos, (n - pos) * sizeof(T));
+        arr[pos] = v;
+    }
+    template <typename T>
+    static void shift_out(T* arr, size_t n, size_t pos) {
+        std::memmove(arr + pos, arr + pos + 1, (n - pos - 1) * sizeof(T));
+    }
+
+    Page* fetch(uint32_t page_id) const {
+        Page* page = bpm_->fetch_page(page_id);
+        if (!page) throw std::runtime_error("Failed to fetch index page");
+        return page;
+    }
+
+    static void init_node(Page* page, bool leaf) {
+        std::byte* raw = page->data();
+        std::memset(raw + Page::HEADER_SIZE, 0, Page::PAGE_SIZE - Page::HEADER_SIZE);
+        *reinterpret_cast<uint16_t*>(raw + IS_LEAF_POS) = leaf ? 1 : 0;
+        *reinterpret_cast<uint32_t*>(raw + NEXT_POS) = INVALID_PAGE;
+    }
+
+    static void write_meta(Page* meta, uint32_t root_id) {
+        meta->w_latch();
+        *reinterpret_cast<uint32_t*>(meta->data() + ROOT_POS) = root_id;
+        meta->w_unlatch();
+    }
+
+    // Caller holds old_root's w_latch and hands over a pin on new_root for
+    // the tree to keep; the old root's pin is dropped. Readers still on the
+    // old root fail validation once its latch is released.
+    void set_root(Page* old_root, Page* new_root) {
+        Page* meta = fetch(meta_page_id_);
+        write_meta(meta, new_root->get_page_id());
+        bpm_->unpin_page(meta_page_id_, true);
+        root_.store(new_root);
+        bpm_->unpin_page(old_root->get_page_id(), false);
+    }
+
+    /* ---------- optimistic descent ------------ */
+
+    void release(Visit& v) const {
+        if (v.pinned) bpm_->unpin_page(v.id, false);
+        v.pinned = false;
+    }
+
+    // Descend to the leaf covering key without latching anything. A node's
+    // version is checked again after its child's version has been read, so
+    // a split or merge on the way is noticed; then false is returned with
+    // nothing pinned and the caller starts over. On success the leaf is
+    // returned pinned but not yet validated, and path holds the inner nodes.
+    bool descend(const KeyT& key, Visit& leaf, std::vector<Visit>* path) const {
+        if (path) path->clear();
+        Visit cur{ root_.load(), 0, INVALID_PAGE, 0, false };
+        cur.version = cur.page->version();
+        cur.id = cur.page->get_page_id();
+        if ((cur.version & 1) || root_.load() != cur.page || !cur.page->validate(cur.version)) {
+            std::this_thread::yield();
+            return false;
         }
+        for (;;) {
+            Node node = view(cur.page);
+            bool is_leaf = node.is_leaf();
+            cur.count = node.safe_count();
+            if (is_leaf) {
+                leaf = cur;
+                return true;
+            }
+            uint32_t child_id = node.child(node.upper(key, cur.count));
+            if (!cur.page->validate(cur.version)) break;
 
-        /* internal */
-        int idx = upper(n->keys, key);
-        int promote{}; NodePtr child_split{};
-        if (!insert_inner(n->children[idx], key, val, promote, child_split)) return false;
+            Visit next{ fetch(child_id), 0, child_id, 0, true };
+            next.version = next.page->version();
+            if ((next.version & 1) || !cur.page->validate(cur.version)) {
+                release(next);
+                break;
+            }
+            release(cur);
+            if (path) path->push_back(cur);
+            cur = next;
+        }
+        release(cur);
+        std::this_thread::yield();
+        return false;
+    }
 
-        if (child_split) {
-            n->keys.insert(n->keys.begin() + idx, promote);
-            n->children.insert(n->children.begin() + idx + 1, child_split);
-            if ((int)n->keys.size() < order_) { new_child = nullptr; return true; }
-            split_internal(n, up_key, new_child);
+    // w_latch a node the descent saw; false if it changed since
+    bool lock(Visit& v) const {
+        if (!v.pinned) {
+            Page* page = fetch(v.id);
+            v.pinned = true;
+            if (page != v.page) return false;
+        }
+        v.page->w_latch();
+        if (v.page->version() != v.version + 1) {   // +1 is our own latch
+            v.page->w_unlatch();
+            return false;
         }
-        else new_child = nullptr;
         return true;
     }
 
-    void split_leaf(NodePtr leaf, int& up_key, NodePtr& new_leaf) {
-        int mid = leaf->keys.size() / 2;
-        new_leaf = std::make_shared<Node>(true);
-        new_leaf->keys.assign(leaf->keys.begin() + mid, leaf->keys.end());
-        new_leaf->values.assign(leaf->values.begin() + mid, leaf->values.end());
-        leaf->keys.resize(mid);
-        leaf->values.resize(mid);
+    void unlock(Visit& v) const {
+        v.page->w_unlatch();
+        bpm_->unpin_page(v.id, true);
+        v.pinned = false;
+    }
 
-        new_leaf->next = leaf->next;
-        leaf->next = new_leaf;
-        up_key = new_leaf->keys.front();
+    // Latch path[from..] top-down. On failure everything is released
+    bool lock_path(std::vector<Visit>& path, size_t from) const {
+        for (size_t i = from; i < path.size(); ++i) {
+            if (!lock(path[i])) {
+                for (size_t j = from; j < i; ++j) unlock(path[j]);
+                for (auto& v : path) release(v);
+                return false;
+            }
+        }
+        return true;
     }
 
-    void split_internal(NodePtr n, int& up_key, NodePtr& new_n) {
-        int mid = n->keys.size() / 2;
-        up_key = n->keys[mid];
-        new_n = std::make_shared<Node>(false);
+    void unlock_path(std::vector<Visit>& path, size_t from) const {
+        for (size_t i = path.size(); i-- > from;) unlock(path[i]);
+        for (auto& v : path) release(v);
+    }
+
+    /* ---------- split propagation ------------- */
+
+    // The leaf (path.back()) is full: latch from the deepest inner node
+    // with room for any key (or from the root) down to the leaf, then
+    // split upwards
+    Outcome insert_split(const KeyT& key, const ValueT& value, std::vector<Visit>& path) {
+        size_t top = path.size() - 1;
+        while (top > 0 && path[top - 1].count >= inner_room_) --top;
+        if (top > 0) --top;                              // takes the last separator
+        if (!lock_path(path, top)) return Outcome::RESTART;
+
+        Node leaf = view(path.back().page);
+        size_t n = leaf.count();
+        size_t pos = leaf.lower(key, n);
+        if (pos < n && leaf.key_is(pos, key)) {
+            unlock_path(path, top);
+            return Outcome::NO_OP;
+        }
+
+        std::vector<KeyT> keys;
+        std::vector<ValueT> values;
+        leaf.read_leaf(0, n, keys, values);
+        keys.insert(keys.begin() + pos, key);
+        values.insert(values.begin() + pos, value);
+        if (fits(true, keys)) {                          // byte keys: fits once rewritten
+            leaf.write_leaf(keys, values);
+            unlock_path(path, top);
+            return Outcome::DONE;
+        }
+
+        // Redistribute the entries over two leaves
+        std::span<const KeyT> k(keys);
+        std::span<const ValueT> v(values);
+        size_t mid = split_point(true, keys);
+
+        uint32_t right_id;
+        Page* right_page = bpm_->new_page(right_id);
+        if (!right_page) {
+            unlock_path(path, top);
+            throw std::runtime_error("Failed to allocate index page");
+        }
+        init_node(right_page, true);
+        Node right = view(right_page);
+        right.write_leaf(k.subspan(mid), v.subspan(mid));
+        right.set_next(leaf.next());
+        bpm_->unpin_page(right_id, true);                // unreachable until linked
+
+        leaf.write_leaf(k.first(mid), v.first(mid));
+        leaf.set_next(right_id);
 
-        new_n->keys.assign(n->keys.begin() + mid + 1, n->keys.end());
-        new_n->children.assign(n->children.begin() + mid + 1, n->children.end());
-        n->keys.resize(mid);
-        n->children.resize(mid + 1);
+        // Push the separator up the latched nodes; only the root may overflow
+        KeyT up_key = keys[mid];
+        bool absorbed = false;
+        for (size_t i = path.size() - 1; i-- > top;) {
+            Node parent = view(path[i].page);
+            if ((absorbed = insert_into_inner(parent, up_key, right_id))) break;
+        }
+        if (!absorbed) new_root(path[0], up_key, right_id);
+        unlock_path(path, top);
+        return Outcome::DONE;
     }
 
-    /* ---------- search ---------- */
-    std::optional<ValueT> search_inner(NodePtr n, int key) const {
-        if (n->is_leaf) {
-            int pos = lower(n->keys, key);
-            if (pos < n->keys.size() && n->keys[pos] == key) return n->values[pos];
-            return std::nullopt;
+    // Adds (up_key, right_id) to a latched inner node. Returns true if it
+    // fit; otherwise the node is split and up_key/right_id become the
+    // separator and new right half for the level above.
+    bool insert_into_inner(Node& node, KeyT& up_key, uint32_t& right_id) {
+        size_t n = node.count();
+        size_t idx = node.upper(up_key, n);
+        if (node.room_for(up_key, n)) {
+            node.insert_child(idx, n, up_key, right_id);
+            return true;
+        }
+
+        std::vector<KeyT> keys;
+        std::vector<uint32_t> children;
+        node.read_inner(n, keys, children);
+        keys.insert(keys.begin() + idx, up_key);
+        children.insert(children.begin() + idx + 1, right_id);
+        if (fits(false, keys)) {
+            node.write_inner(keys, children);
+            return true;
         }
-        int idx = upper(n->keys, key);
-        return search_inner(n->children[idx], key);
+
+        // Full: the middle key moves up, the halves keep the rest
+        std::span<const KeyT> k(keys);
+        std::span<const uint32_t> c(children);
+        size_t mid = split_point(false, keys);
+
+        uint32_t sibling_id;
+        Page* sibling_page = bpm_->new_page(sibling_id);
+        if (!sibling_page) throw std::runtime_error("Failed to allocate index page");
+        init_node(sibling_page, false);
+        view(sibling_page).write_inner(k.subspan(mid + 1), c.subspan(mid + 1));
+        bpm_->unpin_page(sibling_id, true);
+
+        node.write_inner(k.first(mid), c.first(mid + 1));
+
+        up_key = keys[mid];
+        right_id = sibling_id;
+        return false;
     }
 
-    /* ---------- remove (simple) ---------- */
-    bool remove_inner(NodePtr n, int key) {
-        if (n->is_leaf) {
-            int pos = lower(n->keys, key);
-            if (pos == n->keys.size() || n->keys[pos] != key) return false;
-            n->keys.erase(n->keys.begin() + pos);
-            n->values.erase(n->values.begin() + pos);
+    // The latched root split into itself and right_id: grow a level
+    void new_root(Visit& old_root, const KeyT& up_key, uint32_t right_id) {
+        uint32_t root_id;
+        Page* root_page = bpm_->new_page(root_id);
+        if (!root_page) throw std::runtime_error("Failed to allocate index root");
+        init_node(root_page, false);
+        KeyT keys[] = { up_key };
+        uint32_t children[] = { old_root.id, right_id };
+        view(root_page).write_inner(keys, children);
+        set_root(old_root.page, root_page);
+    }
+
+    /* ---------- merge / borrow on remove ------ */
+
+    // Can this inner node lose a key? The root only needs two children
+    bool inner_can_shrink(const Visit& v, bool is_root) const {
+        return is_root ? v.count > 1 : v.count > inner_min_;
+    }
+
+    // The leaf (path.back()) would drop below half full: latch from the
+    // deepest inner node that can lose a key (or from the root) down to the
+    // leaf, then fix underflows upwards by borrowing from or merging with
+    // a sibling under the same parent
+    Outcome remove_rebalance(const KeyT& key, std::vector<Visit>& path) {
+        size_t top = path.size() - 1;
+        while (top > 0 && !inner_can_shrink(path[top - 1], top == 1)) --top;
+        if (top > 0) --top;
+        if (!lock_path(path, top)) return Outcome::RESTART;
+
+        Node leaf = view(path.back().page);
+        size_t n = leaf.count();
+        size_t pos = leaf.lower(key, n);
+        if (pos == n || !leaf.key_is(pos, key)) {
+            unlock_path(path, top);
+            return Outcome::NO_OP;
+        }
+        leaf.erase_entry(pos, n);
+
+        for (size_t i = path.size() - 1; i > top; --i) {
+            Node node = view(path[i].page);
+            if (node.count() >= (node.is_leaf() ? leaf_min_ : inner_min_)) break;
+            if (!rebalance(path[i - 1], path[i])) break;    // borrowed: parent keeps its count
+        }
+
+        // An inner root left with one child hands the root down to it
+        Node root = view(path[0].page);
+        if (top == 0 && !root.is_leaf() && root.count() == 0) set_root(path[0].page, fetch(root.child(0)));
+        unlock_path(path, top);
+        return Outcome::DONE;
+    }
+
+    // Fix an underfull node from a neighbour under the same (latched)
+    // parent. Returns true if the two merged, i.e. the parent lost a key.
+    bool rebalance(Visit& pv, Visit& nv) {
+        Node parent = view(pv.page);
+        std::vector<KeyT> pkeys;
+        std::vector<uint32_t> pchildren;
+        parent.read_inner(parent.count(), pkeys, pchildren);
+        if (pkeys.empty()) return false;                    // an only child (see below)
+        size_t idx = std::find(pchildren.begin(), pchildren.end(), nv.id) - pchildren.begin();
+        bool right_sibling = idx < pkeys.size();
+        size_t li = right_sibling ? idx : idx - 1;          // left child of the pair
+        uint32_t sib_id = pchildren[right_sibling ? idx + 1 : idx - 1];
+
+        Page* sib = fetch(sib_id);
+        sib->w_latch();
+        Node left = view(right_sibling ? nv.page : sib);
+        Node right = view(right_sibling ? sib : nv.page);
+        bool merged = left.is_leaf() ? rebalance_leaves(pkeys, pchildren, li, left, right)
+                                     : rebalance_inner(pkeys, pchildren, li, left, right);
+        parent.write_inner(pkeys, pchildren);
+        sib->w_unlatch();
+        bpm_->unpin_page(sib_id, true);
+        return merged;
+    }
+
+    // Both take the parent's entries and leave them as they should be
+    // written back. After a merge the right node's page is not reused; it
+    // keeps its (stale) entries and next link for iterators still holding
+    // it. A borrow whose new separator would not fit the parent (byte keys:
+    // it may share less with the other keys) is skipped, leaving the node
+    // underfull but correct; its parent may then merge down to one child,
+    // which is left as it is until the parent itself is merged away.
+    bool rebalance_leaves(std::vector<KeyT>& pkeys, std::vector<uint32_t>& pchildren, size_t li,
+                          Node& left, Node& right) {
+        std::vector<KeyT> keys;
+        std::vector<ValueT> values;
+        left.read_leaf(0, left.count(), keys, values);
+        right.read_leaf(0, right.count(), keys, values);
+        if (fits(true, keys)) {
+            left.write_leaf(keys, values);
+            left.set_next(right.next());
+            pkeys.erase(pkeys.begin() + li);
+            pchildren.erase(pchildren.begin() + li + 1);
+            return true;
+        }
+        size_t mid = split_point(true, keys);
+        if (!replace_separator(pkeys, li, keys[mid])) return false;
+        std::span<const KeyT> k(keys);
+        std::span<const ValueT> v(values);
+        left.write_leaf(k.first(mid), v.first(mid));
+        right.write_leaf(k.subspan(mid), v.subspan(mid));
+        return false;
+    }
+
+    bool rebalance_inner(std::vector<KeyT>& pkeys, std::vector<uint32_t>& pchildren, size_t li,
+                         Node& left, Node& right) {
+        std::vector<KeyT> keys;
+        std::vector<uint32_t> children;
+        left.read_inner(left.count(), keys, children);
+        keys.push_back(pkeys[li]);
+        right.read_inner(right.count(), keys, children);
+        if (fits(false, keys)) {
+            left.write_inner(keys, children);
+            pkeys.erase(pkeys.begin() + li);
+            pchildren.erase(pchildren.begin() + li + 1);
             return true;
         }
-        int idx = upper(n->keys, key);
-        return remove_inner(n->children[idx], key);
+        // Rotate through the parent: the middle of all the keys goes up
+        size_t mid = split_point(false, keys);
+        if (!replace_separator(pkeys, li, keys[mid])) return false;
+        std::span<const KeyT> k(keys);
+        std::span<const uint32_t> c(children);
+        left.write_inner(k.first(mid), c.first(mid + 1));
+        right.write_inner(k.subspan(mid + 1), c.subspan(mid + 1));
+        return false;
+    }
+
+    bool replace_separator(std::vector<KeyT>& pkeys, size_t li, const KeyT& sep) const {
+        KeyT old = std::exchange(pkeys[li], sep);
+        if (fits(false, pkeys)) return true;
+        pkeys[li] = std::move(old);
+        return false;
     }
 };
@@ -4,130 +4,798 @@
 #include <unordered_map>
 #include <optional>
 #include <stdexcept>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <span>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include "page.hpp"
 #include "disk_manager.hpp"
 #include "lru_replacer.hpp"
+#include "recovery/log_manager.hpp"
 
+/*
+ * Concurrent buffer pool.
+ *
+ * The page table is split into shards, each with its own latch; a page's
+ * shard latch serializes its pin/unpin and any change to where it lives.
+ * Frame descriptors hold atomic pin counts and dirty bits, while the page
+ * bytes themselves are protected by the per-page reader/writer latch
+ * (Page::r_latch / w_latch) taken by callers.
+ *
+ * Frame buffers live in one 4 KB-aligned arena so they can go straight to
+ * O_DIRECT / io_uring I/O. The flusher and checkpoints write dirty pages as
+ * one batch through DiskManager::submit, so an asynchronous backend keeps
+ * many writes in flight at once.
+ *
+ * Over a memory-mapped DiskManager there is no arena: a frame is pointed
+ * at the page inside the mapping when the page is loaded, so fetch_page
+ * copies nothing and write-back is free. Frames then only bound how many
+ * pages are pinned at once, and dirty pages reach disk through msync at
+ * checkpoints (no flusher thread runs).
+ *
+ * prefetch() is the readahead entry point. With an asynchronous backend
+ * it maps each page to a frame straight away, marks the frame as loading
+ * and submits all reads as one batch. A fetch that hits a loading frame
+ * waits for that read only. Finished readahead frames go to the replacer
+ * through insert_cold, so they are evicted before anything that was
+ * actually used. Other backends get an OS readahead hint instead.
+ *
+ * With a LogManager attached (set_log_manager) the pool keeps the WAL
+ * rule: a dirty page is written only once the log is durable up to the
+ * page's LSN. Eviction waits for the log. A batch (flusher, checkpoint)
+ * never waits while holding its pages: it skips those whose records are
+ * still in the log buffer, as it skips latched ones, and asks the log to
+ * catch up; a checkpoint flushes the log first. Over a mapping the kernel
+ * writes pages whenever it likes, so the rule cannot be kept there and a
+ * mapped pool refuses a LogManager.
+ * Each Page also carries its recovery LSN, cleared when a write of the
+ * page completes; dirty_page_table() lists them for fuzzy checkpoints.
+ *
+ * No shard latch is held across disk I/O or a log flush. A miss maps the
+ * page to its frame before reading it, and eviction or an unpin over the
+ * dirty bound claims the frame before writing it back; the frame's
+ * io_state says which. A fetch that finds such a frame pins it and waits
+ * for that I/O only, and the writer looks again once it has re-latched.
+ *
+ * Every time a frame takes new content its Page version is bumped, so
+ * latch-free readers (the B+-tree) holding a stale Page* fail validation.
+ *
+ * Eviction order comes from a pluggable Replacer (LRU by default; see
+ * clock_replacer.hpp, lru_k_replacer.hpp, two_queue_replacer.hpp).
+ *
+ * Lock order: shard latches are only ever taken two at a time through
+ * std::lock; free_latch_ and the replacer's latch are leaves. No shard
+ * latch is requested while a page latch is held by the pool itself.
+ */
 class BufferPoolManager {
 public:
-    BufferPoolManager(size_t pool_size, DiskManager* disk_manager)
+    static constexpr uint32_t INVALID_PAGE_ID = UINT32_MAX;
+    static constexpr size_t FLUSH_BATCH = 64;   // pages written per flusher round
+    static constexpr size_t IO_BATCH = 32;      // pages latched per submit
+
+    // A null replacer selects LRU. max_dirty_pages == 0 picks half the pool;
+    // a zero flush_interval disables the background flusher (write-back then
+    // happens on eviction/checkpoint only)
+    BufferPoolManager(size_t pool_size, DiskManager* disk_manager,
+        std::unique_ptr<Replacer> replacer = nullptr,
+        size_t max_dirty_pages = 0,
+        std::chrono::milliseconds flush_interval = std::chrono::milliseconds(50),
+        size_t num_shards = 16)
         : pool_size_(pool_size),
         pages_(pool_size),
-        page_table_(),
-        pinned_(pool_size, false),
+        frames_(pool_size),
+        shards_(round_up_pow2(num_shards)),
+        shard_mask_(shards_.size() - 1),
         disk_manager_(disk_manager),
-        next_page_id_(0),
-        replacer_(pool_size) {
+        mapped_(disk_manager->mapped()),
+        next_page_id_(disk_manager->num_pages()),
+        replacer_(replacer ? std::move(replacer) : std::make_unique<LRUReplacer>(pool_size)),
+        max_dirty_(max_dirty_pages ? max_dirty_pages : std::max<size_t>(1, pool_size / 2)),
+        flush_interval_(flush_interval) {
+        // One aligned arena backs all frames, unless pages live in a mapping
+        if (!mapped_) {
+            arena_.reset(static_cast<std::byte*>(std::aligned_alloc(Page::PAGE_SIZE, pool_size * Page::PAGE_SIZE)));
+            if (!arena_) throw std::bad_alloc();
+            std::memset(arena_.get(), 0, pool_size * Page::PAGE_SIZE);
+            for (size_t i = 0; i < pool_size; ++i) pages_[i].attach(arena_.get() + i * Page::PAGE_SIZE);
+        }
+
+        // Every frame starts out free; pop from the back so frame 0 goes first
+        free_list_.reserve(pool_size);
+        for (size_t i = pool_size; i-- > 0;) free_list_.push_back(i);
+        for (auto& s : shards_) s.table.reserve(pool_size / shards_.size() + 1);
+
+        if (flush_interval_.count() > 0 && !mapped_) {
+            flusher_ = std::thread([this] { flusher_loop(); });
+        }
+    }
+
+    // Stops the flusher and writes back everything still dirty
+    ~BufferPoolManager() {
+        reap_prefetches(true);
+        {
+            std::lock_guard<std::mutex> lk(flush_latch_);
+            stop_ = true;
+        }
+        flush_cv_.notify_all();
+        if (flusher_.joinable()) flusher_.join();
+        flush_all_pages();
+    }
+
+    BufferPoolManager(const BufferPoolManager&) = delete;
+    BufferPoolManager& operator=(const BufferPoolManager&) = delete;
+
+    // Enforce WAL before data from now on. The log must outlive the pool.
+    // Throws over a mapped DiskManager, where recovery could not be trusted.
+    void set_log_manager(LogManager* log) {
+        if (log && mapped_) throw std::runtime_error("no write-ahead log over a memory-mapped data file");
+        log_ = log;
     }
 
 
     // Fetch a page from buffer pool (or load from disk)
     Page* fetch_page(uint32_t page_id) {
-        // Check if page is already in memory
-        if (page_table_.count(page_id)) {
-            size_t frame_id = page_table_[page_id];
-            pinned_[frame_id] = true;
-            return &pages_[frame_id];
-        }
+        Shard& s = shard_for(page_id);
+        std::unique_lock<std::mutex> lk(s.latch);
 
-        // Page not in memory  need to load into a frame
-        std::optional<size_t> free_frame = find_free_frame();
+        bool hit = false;
+        std::optional<size_t> free_frame = acquire_frame_or_reap(page_id, s, lk, hit);
         if (!free_frame.has_value()) {
-            size_t victim_frame;
-            if (!replacer_.victim(victim_frame)) {
-                throw std::runtime_error("No free frame available and LRU empty");
-            }
+            throw std::runtime_error("No free frame available and replacer empty");
+        }
 
-            // Evict victim
-            uint32_t evicted_page = 0;
-            for (auto it = page_table_.begin(); it != page_table_.end(); ++it) {
-                if (it->second == victim_frame) {
-                    evicted_page = it->first;
-                    break;
-                }
+        size_t frame_id = free_frame.value();
+        if (hit) {
+            pin(frame_id);
+            replacer_->record_access(frame_id, page_id);
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            if (frames_[frame_id].io_state.load() != IO_NONE) {
+                // Still loading or being written: wait for this page only
+                lk.unlock();
+                await_io(page_id, frame_id);
             }
-            flush_page(evicted_page);
-            page_table_.erase(evicted_page);
-            free_frame = victim_frame;
+            return &pages_[frame_id];
         }
+        misses_.fetch_add(1, std::memory_order_relaxed);
 
-        size_t frame_id = free_frame.value();
         Page& page = pages_[frame_id];
+        if (mapped_) {
+            page.attach(disk_manager_->mapped_page(page_id));
+            if (page.get_page_id() != page_id) page.set_page_id(page_id);
+            install(frame_id, page_id, s);
+            return &page;
+        }
 
-        // Load content from disk
-        disk_manager_->read_page(page_id, page.get_data().data());
-
+        // Page not in memory: map it first, so nobody else loads it too,
+        // then read it without the shard latch
+        Frame& frame = frames_[frame_id];
+        install(frame_id, page_id, s);
+        frame.io_state.store(IO_READING);
+        lk.unlock();
+        try {
+            disk_manager_->read_page(page_id, page.get_data().data());
+        }
+        catch (...) {
+            lk.lock();
+            s.table.erase(page_id);
+            frame.page_id.store(INVALID_PAGE_ID);
+            replacer_->erase(frame_id);
+            replacer_->forget(frame_id);
+            frame.io_state.store(IO_NONE);
+            frame.io_state.notify_all();
+            release_unmapped(frame_id);
+            throw;
+        }
         page.set_page_id(page_id);
-        pinned_[frame_id] = true;
-        page_table_[page_id] = frame_id;
-
+        page.bump_version();                     // a reader that raced the read must fail
+        frame.io_state.store(IO_NONE);
+        frame.io_state.notify_all();
         return &page;
     }
 
-    // Unpin a page when done using it
+    // Unpin a page when done using it. Dirty pages are only marked here;
+    // the bytes reach disk on eviction, checkpoint or from the flusher.
     bool unpin_page(uint32_t page_id, bool is_dirty) {
-        if (!page_table_.count(page_id)) return false;
-        size_t frame_id = page_table_[page_id];
-        pinned_[frame_id] = false;
-        replacer_.insert(frame_id);
+        Shard& s = shard_for(page_id);
+        std::unique_lock<std::mutex> lk(s.latch);
+        auto it = s.table.find(page_id);
+        if (it == s.table.end()) return false;
+        size_t frame_id = it->second;
+        Frame& frame = frames_[frame_id];
+        if (frame.pin_count.load() <= 0) return false;
+
+        if (is_dirty) mark_dirty(frame);
 
-        // For now, we treat all unpinned pages as dirty and flush them
-        if (is_dirty) {
-            return flush_page(page_id);
+        // Only the last user hands the frame to the replacer
+        if (frame.pin_count.fetch_sub(1) == 1) {
+            // Over the bound: this caller pays for its own write-back. A
+            // fetch during the write keeps the frame, and its unpin hands
+            // it over instead.
+            if (frame.dirty.load() && dirty_count_.load() > max_dirty_) write_back(frame_id, lk);
+            if (frame.pin_count.load() == 0) replacer_->insert(frame_id);
         }
+        lk.unlock();
+
+        if (dirty_count_.load() >= max_dirty_ / 2) flush_cv_.notify_one();
         return true;
     }
 
     // Flush (write back) a page to disk
     bool flush_page(uint32_t page_id) {
-        if (!page_table_.count(page_id)) return false;
-        size_t frame_id = page_table_[page_id];
-        Page& page = pages_[frame_id];
-        disk_manager_->write_page(page.get_page_id(), page.get_data().data());
+        Shard& s = shard_for(page_id);
+        std::unique_lock<std::mutex> lk(s.latch);
+        auto it = s.table.find(page_id);
+        if (it == s.table.end()) return false;
+        size_t frame_id = it->second;
+        pin(frame_id);
+        lk.unlock();
+
+        if (frames_[frame_id].io_state.load() != IO_NONE) await_io(page_id, frame_id);
+        flush_pinned(frame_id);
+        unpin_page(page_id, false);
         return true;
     }
 
-    // Create a new page with a new page_id
+    // Checkpoint: write every dirty page in page_id order, then sync the file
+    void flush_all_pages() {
+        if (log_) log_->flush_all();
+        // Pages busy under a writer's latch are done one by one afterwards
+        for (auto [page_id, frame_id] : flush_batch(collect_dirty(SIZE_MAX))) flush_frame(page_id, frame_id);
+        disk_manager_->sync();
+    }
+
+    // Create a new page with a new page_id. Ids continue after the pages
+    // already in the file.
     Page* new_page(uint32_t& new_page_id) {
-        std::optional<size_t> free_frame = find_free_frame();
+        uint32_t page_id = next_page_id_.fetch_add(1);
+        Shard& s = shard_for(page_id);
+        std::unique_lock<std::mutex> lk(s.latch);
+
+        bool hit = false;
+        std::optional<size_t> free_frame = acquire_frame_or_reap(page_id, s, lk, hit);
         if (!free_frame.has_value()) return nullptr;
 
         size_t frame_id = free_frame.value();
         Page& page = pages_[frame_id];
-
-        new_page_id = next_page_id_++;
-        page_table_[new_page_id] = frame_id;
-
+        if (mapped_) page.attach(disk_manager_->mapped_page(page_id));
         page.reset_memory();
-        page.set_page_id(new_page_id);
-        pinned_[frame_id] = true;
+        page.set_page_id(page_id);
+        install(frame_id, page_id, s);
 
+        // A fresh page exists nowhere on disk yet
+        mark_dirty(frames_[frame_id]);
+
+        new_page_id = page_id;
         return &page;
     }
 
+    // Page ids below end are taken: new_page starts at end at the earliest.
+    // Recovery calls it for pages the log created that never reached the file.
+    void reserve_page_ids(uint32_t end) {
+        uint32_t next = next_page_id_.load();
+        while (next < end && !next_page_id_.compare_exchange_weak(next, end)) {}
+    }
+
+    // The id the next new_page gets: every id below it is taken
+    uint32_t next_page_id() const { return next_page_id_.load(); }
+
+    // Make the pages written back so far durable, without writing any
+    void sync() { disk_manager_->sync(); }
+
+    // Dirty page table for a checkpoint: (page_id, rec_lsn) of every frame
+    // holding logged changes that are not on disk yet. Taken without
+    // latches; a page written meanwhile may still be listed, which only
+    // makes recovery look at it.
+    std::vector<std::pair<uint32_t, lsn_t>> dirty_page_table() const {
+        std::vector<std::pair<uint32_t, lsn_t>> out;
+        for (size_t i = 0; i < frames_.size(); ++i) {
+            lsn_t rec_lsn = pages_[i].rec_lsn();
+            if (rec_lsn == INVALID_LSN) continue;
+            uint32_t pid = frames_[i].page_id.load();
+            if (pid != INVALID_PAGE_ID) out.emplace_back(pid, rec_lsn);
+        }
+        return out;
+    }
+
+    // Readahead: start loading pages that are about to be fetched. Resident
+    // pages are skipped; with every frame pinned or loading the rest of the
+    // list is dropped. Returns how many pages were started (or hinted).
+    size_t prefetch(std::span<const uint32_t> page_ids) {
+        if (!disk_manager_->async_io()) {
+            // Synchronous backends: let the kernel read ahead instead
+            size_t hinted = 0;
+            for (uint32_t page_id : page_ids) {
+                if (resident(page_id)) continue;
+                disk_manager_->advise(page_id, 1);
+                ++hinted;
+            }
+            return hinted;
+        }
+
+        reap_prefetches(false);
+        std::vector<IORequest*> batch;
+        std::vector<std::pair<uint32_t, size_t>> started;
+        for (uint32_t page_id : page_ids) {
+            Shard& s = shard_for(page_id);
+            std::unique_lock<std::mutex> lk(s.latch);
+            bool hit = false;
+            std::optional<size_t> free_frame = acquire_frame(page_id, s, lk, hit);
+            if (!free_frame.has_value()) break;
+            if (hit) continue;
+
+            // Mapped but neither pinned nor evictable until the read lands
+            size_t frame_id = free_frame.value();
+            Frame& frame = frames_[frame_id];
+            frame.page_id.store(page_id);
+            frame.dirty.store(false);
+            frame.pin_count.store(0);
+            pages_[frame_id].bump_version();
+            pages_[frame_id].clear_rec_lsn();
+            frame.io_state.store(IO_QUEUED);
+            frame.io.page_id = page_id;
+            frame.io.buffer = pages_[frame_id].data();
+            frame.io.write = false;
+            frame.io.done.store(false);
+            s.table[page_id] = frame_id;
+            batch.push_back(&frame.io);
+            started.emplace_back(page_id, frame_id);
+        }
+        if (batch.empty()) return 0;
+
+        disk_manager_->submit(batch);
+        for (auto [page_id, frame_id] : started) {
+            frames_[frame_id].io_state.store(IO_SUBMITTED);
+            frames_[frame_id].io_state.notify_all();
+        }
+        prefetches_.fetch_add(started.size(), std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lk(prefetch_latch_);
+        loading_.insert(loading_.end(), started.begin(), started.end());
+        return started.size();
+    }
+
+    size_t prefetch(uint32_t first_page_id, size_t count) {
+        std::vector<uint32_t> ids(count);
+        for (size_t i = 0; i < count; ++i) ids[i] = first_page_id + static_cast<uint32_t>(i);
+        return prefetch(ids);
+    }
+
+    // Number of users currently holding the page (0 if not resident)
+    int pin_count(uint32_t page_id) {
+        Shard& s = shard_for(page_id);
+        std::lock_guard<std::mutex> lk(s.latch);
+        auto it = s.table.find(page_id);
+        return it == s.table.end() ? 0 : frames_[it->second].pin_count.load();
+    }
+
+    size_t dirty_pages() const { return dirty_count_.load(); }
+    size_t hits() const { return hits_.load(); }
+    size_t misses() const { return misses_.load(); }
+    size_t prefetches() const { return prefetches_.load(); }
+    size_t pool_size() const { return pool_size_; }
+
 private:
+    // Per-frame descriptor: reverse mapping to the resident page + pin count.
+    // Fields change under the owning page's shard latch; atomics let the
+    // flusher take a consistent-enough snapshot without any latch.
+    struct Frame {
+        std::atomic<uint32_t> page_id{ INVALID_PAGE_ID };
+        std::atomic<int>      pin_count{ 0 };
+        std::atomic<bool>     dirty{ false };
+        std::atomic<uint8_t>  io_state{ IO_NONE };   // I/O under way without the shard latch
+        IORequest             io;                    // the readahead read
+    };
+
+    struct Shard {
+        std::mutex                           latch;
+        std::unordered_map<uint32_t, size_t> table;   // page_id -> frame_id
+    };
+
+    struct AlignedFree {
+        void operator()(std::byte* p) const { std::free(p); }
+    };
+
     size_t pool_size_;
+    std::unique_ptr<std::byte, AlignedFree> arena_;   // pool_size_ frames
     std::vector<Page> pages_;
-    std::unordered_map<uint32_t, size_t> page_table_;
-    std::vector<bool> pinned_;
+    std::vector<Frame> frames_;
+    std::vector<Shard> shards_;
+    size_t shard_mask_;
+    std::mutex free_latch_;
+    std::vector<size_t> free_list_;      // frames holding no page
     DiskManager* disk_manager_;
-    uint32_t next_page_id_;
-    LRUReplacer replacer_;
-
-
-    std::optional<size_t> find_free_frame() {
-        for (size_t i = 0; i < pool_size_; ++i) {
-            if (!pinned_[i]) {
-                // Remove old mapping if page was previously mapped
-                for (auto it = page_table_.begin(); it != page_table_.end(); ++it) {
-                    if (it->second == i) {
-                        page_table_.erase(it);
-                        break;
-                    }
+    bool mapped_;                        // frames point into the file mapping
+    std::atomic<uint32_t> next_page_id_;
+    std::unique_ptr<Replacer> replacer_;
+    LogManager* log_ = nullptr;          // WAL before data, if set
+    std::atomic<size_t> hits_{ 0 }, misses_{ 0 };   // fetch_page outcomes
+    std::atomic<size_t> prefetches_{ 0 };           // async readahead reads
+
+    /* I/O state of a frame; QUEUED and SUBMITTED are readahead */
+    enum : uint8_t { IO_NONE = 0, IO_QUEUED = 1, IO_SUBMITTED = 2, IO_READING = 3, IO_WRITING = 4 };
+    std::mutex prefetch_latch_;
+    std::vector<std::pair<uint32_t, size_t>> loading_;   // (page, frame) in flight
+
+    /* write-back state */
+    std::atomic<size_t>       dirty_count_{ 0 };
+    size_t                    max_dirty_;
+    std::chrono::milliseconds flush_interval_;
+    std::mutex                flush_latch_;
+    std::condition_variable   flush_cv_;
+    std::thread               flusher_;
+    bool                      stop_ = false;     // guarded by flush_latch_
+
+    static size_t round_up_pow2(size_t n) {
+        size_t p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    Shard& shard_for(uint32_t page_id) {
+        // Fibonacci hashing spreads neighbouring page ids across shards
+        return shards_[((page_id * 2654435761u) >> 16) & shard_mask_];
+    }
+
+    bool resident(uint32_t page_id) {
+        Shard& s = shard_for(page_id);
+        std::lock_guard<std::mutex> lk(s.latch);
+        return s.table.count(page_id) != 0;
+    }
+
+    // Complete the readahead of page_id into frame_id, if it is still
+    // pending. Whoever gets here first publishes the page; a failed
+    // asynchronous read is retried synchronously.
+    void finish_load(uint32_t page_id, size_t frame_id) {
+        Shard& s = shard_for(page_id);
+        Frame& frame = frames_[frame_id];
+        {
+            std::lock_guard<std::mutex> lk(s.latch);
+            auto it = s.table.find(page_id);
+            if (it == s.table.end() || it->second != frame_id || frame.io_state.load() == IO_NONE) return;
+        }
+
+        frame.io_state.wait(IO_QUEUED);              // until submitted
+        IORequest* r = &frame.io;
+        bool failed = false;
+        try {
+            disk_manager_->wait(std::span<IORequest* const>(&r, 1));
+        }
+        catch (const std::exception&) {
+            failed = true;
+        }
+
+        std::lock_guard<std::mutex> lk(s.latch);
+        if (frame.io_state.load() == IO_NONE) return;
+        if (failed) disk_manager_->read_page(page_id, r->buffer);
+        pages_[frame_id].set_page_id(page_id);
+        frame.io_state.store(IO_NONE);
+        if (frame.pin_count.load() == 0) replacer_->insert_cold(frame_id, page_id);
+    }
+
+    // Wait for the I/O on a frame the caller has just pinned for page_id.
+    // Throws, dropping the pin, if the read that was loading it failed.
+    void await_io(uint32_t page_id, size_t frame_id) {
+        Frame& frame = frames_[frame_id];
+        uint8_t state = frame.io_state.load();
+        if (state == IO_QUEUED || state == IO_SUBMITTED) {
+            finish_load(page_id, frame_id);
+            return;
+        }
+        for (; state == IO_READING || state == IO_WRITING; state = frame.io_state.load()) frame.io_state.wait(state);
+        if (frame.page_id.load() == page_id) return;
+
+        // The read failed and the frame was taken off the page table
+        std::lock_guard<std::mutex> lk(shard_for(page_id).latch);
+        release_unmapped(frame_id);
+        throw std::runtime_error("Failed to read page " + std::to_string(page_id));
+    }
+
+    // Drop a pin on a frame a failed read took off the page table; the last
+    // one out returns it to the free list. Caller holds the shard latch.
+    void release_unmapped(size_t frame_id) {
+        if (frames_[frame_id].pin_count.fetch_sub(1) != 1) return;
+        std::lock_guard<std::mutex> fl(free_latch_);
+        free_list_.push_back(frame_id);
+    }
+
+    // Finish readahead frames: the completed ones, or all of them if block.
+    // Returns how many were finished.
+    size_t reap_prefetches(bool block) {
+        std::vector<std::pair<uint32_t, size_t>> pending, keep;
+        {
+            std::lock_guard<std::mutex> lk(prefetch_latch_);
+            pending.swap(loading_);
+        }
+        if (pending.empty()) return 0;
+        if (!block) disk_manager_->poll();
+
+        size_t finished = 0;
+        for (auto [page_id, frame_id] : pending) {
+            const Frame& frame = frames_[frame_id];
+            if (!block && (frame.io_state.load() == IO_QUEUED || !frame.io.done.load(std::memory_order_acquire))) {
+                keep.emplace_back(page_id, frame_id);
+                continue;
+            }
+            finish_load(page_id, frame_id);
+            ++finished;
+        }
+        if (!keep.empty()) {
+            std::lock_guard<std::mutex> lk(prefetch_latch_);
+            loading_.insert(loading_.end(), keep.begin(), keep.end());
+        }
+        return finished;
+    }
+
+    // acquire_frame, but if every frame is pinned or still loading, finish
+    // outstanding readahead and try once more
+    std::optional<size_t> acquire_frame_or_reap(uint32_t page_id, Shard& s,
+        std::unique_lock<std::mutex>& lk, bool& hit) {
+        std::optional<size_t> frame_id = acquire_frame(page_id, s, lk, hit);
+        if (frame_id.has_value()) return frame_id;
+        lk.unlock();
+        size_t finished = reap_prefetches(true);
+        lk.lock();
+        return finished ? acquire_frame(page_id, s, lk, hit) : std::nullopt;
+    }
+
+    // Caller holds the page's shard latch
+    void pin(size_t frame_id) {
+        // First pin takes the frame out of the eviction candidates
+        if (frames_[frame_id].pin_count.fetch_add(1) == 0) replacer_->erase(frame_id);
+    }
+
+    // Publish a freshly loaded frame. Caller holds the page's shard latch.
+    void install(size_t frame_id, uint32_t page_id, Shard& s) {
+        Frame& frame = frames_[frame_id];
+        frame.page_id.store(page_id);
+        frame.dirty.store(false);
+        frame.pin_count.store(1);
+        pages_[frame_id].bump_version();         // stale optimistic reads must fail
+        pages_[frame_id].clear_rec_lsn();
+        s.table[page_id] = frame_id;
+        replacer_->record_access(frame_id, page_id);
+    }
+
+    void mark_dirty(Frame& frame) {
+        if (!frame.dirty.exchange(true)) dirty_count_.fetch_add(1);
+    }
+
+    // WAL rule: the log records up to a page's LSN reach disk before the page
+    void wal(lsn_t lsn) {
+        if (log_) log_->flush(lsn);
+    }
+
+    // Write an unpinned frame that is in no replacer, without latching it.
+    // The caller holds its shard latch in lk (and the evicting page's in
+    // olk); both are dropped for the log flush and the write and held again
+    // on return. Meanwhile the frame is claimed (IO_WRITING): a fetch of
+    // its page pins it and waits, so the caller must check the pin count.
+    // If the write fails the frame is dirty again and back in the replacer.
+    void write_back(size_t frame_id, std::unique_lock<std::mutex>& lk,
+        std::unique_lock<std::mutex>* olk = nullptr) {
+        Frame& frame = frames_[frame_id];
+        Page& page = pages_[frame_id];
+        if (frame.dirty.exchange(false)) dirty_count_.fetch_sub(1);
+        frame.io_state.store(IO_WRITING);
+        bool both = olk && olk->owns_lock();
+        lk.unlock();
+        if (both) olk->unlock();
+
+        std::exception_ptr err;
+        try {
+            wal(page.get_lsn());
+            disk_manager_->write_page(frame.page_id.load(), page.get_data().data());
+            page.clear_rec_lsn();
+        }
+        catch (...) {
+            err = std::current_exception();
+        }
+
+        if (both) std::lock(lk, *olk);
+        else lk.lock();
+        frame.io_state.store(IO_NONE);
+        frame.io_state.notify_all();
+        if (err) {
+            mark_dirty(frame);
+            if (frame.pin_count.load() == 0) replacer_->insert(frame_id);
+            std::rethrow_exception(err);
+        }
+    }
+
+    // Write a frame the caller has pinned. The dirty bit is cleared before the
+    // copy so an update racing with the write re-dirties the page.
+    void flush_pinned(size_t frame_id) {
+        Frame& frame = frames_[frame_id];
+        if (frame.dirty.exchange(false)) dirty_count_.fetch_sub(1);
+        Page& page = pages_[frame_id];
+        page.r_latch();
+        wal(page.get_lsn());
+        disk_manager_->write_page(frame.page_id.load(), page.get_data().data());
+        page.clear_rec_lsn();
+        page.r_unlatch();
+    }
+
+    // Pin frame_id if it still holds page_id and is dirty
+    bool pin_if_dirty(uint32_t page_id, size_t frame_id) {
+        Shard& s = shard_for(page_id);
+        std::lock_guard<std::mutex> lk(s.latch);
+        auto it = s.table.find(page_id);
+        if (it == s.table.end() || it->second != frame_id) return false;   // evicted meanwhile
+        if (!frames_[frame_id].dirty.load()) return false;
+        pin(frame_id);
+        return true;
+    }
+
+    // Flush frame_id if it still holds page_id; pins it so no shard latch is
+    // held across the I/O
+    void flush_frame(uint32_t page_id, size_t frame_id) {
+        if (!pin_if_dirty(page_id, frame_id)) return;
+        flush_pinned(frame_id);
+        unpin_page(page_id, false);
+    }
+
+    // Write dirty pages IO_BATCH at a time, one submit per group. Returns the
+    // pages that were skipped because a writer held their latch or their log
+    // records were not durable yet.
+    std::vector<std::pair<uint32_t, size_t>> flush_batch(
+        const std::vector<std::pair<uint32_t, size_t>>& dirty) {
+        std::vector<std::pair<uint32_t, size_t>> busy;
+        std::span<const std::pair<uint32_t, size_t>> all(dirty);
+        for (size_t i = 0; i < all.size(); i += IO_BATCH) {
+            write_group(all.subspan(i, std::min(IO_BATCH, all.size() - i)), busy);
+        }
+        return busy;
+    }
+
+    // Each page of the group stays pinned and read-latched until the whole
+    // group completes. A page whose latch is taken is skipped (added to busy)
+    // instead of waited for, so the pool never blocks on one page latch while
+    // holding others. So is a page whose log records are not on disk yet: the
+    // group does not wait for the log either.
+    void write_group(std::span<const std::pair<uint32_t, size_t>> group,
+        std::vector<std::pair<uint32_t, size_t>>& busy) {
+        std::vector<IORequest> reqs(group.size());
+        std::vector<IORequest*> batch;
+        std::vector<std::pair<uint32_t, size_t>> held;
+        lsn_t pending_lsn = INVALID_LSN;
+        for (auto [page_id, frame_id] : group) {
+            if (!pin_if_dirty(page_id, frame_id)) continue;
+            Page& page = pages_[frame_id];
+            if (!page.try_r_latch()) {
+                unpin_page(page_id, false);
+                busy.emplace_back(page_id, frame_id);
+                continue;
+            }
+            if (log_ && page.get_lsn() > log_->persistent_lsn()) {
+                pending_lsn = std::max(pending_lsn, page.get_lsn());
+                page.r_unlatch();
+                unpin_page(page_id, false);
+                busy.emplace_back(page_id, frame_id);
+                continue;
+            }
+            if (frames_[frame_id].dirty.exchange(false)) dirty_count_.fetch_sub(1);
+            IORequest& r = reqs[held.size()];
+            r.page_id = page_id;
+            r.buffer = page.data();
+            r.write = true;
+            batch.push_back(&r);
+            held.emplace_back(page_id, frame_id);
+        }
+
+        auto release = [&] {
+            for (auto [page_id, frame_id] : held) {
+                pages_[frame_id].r_unlatch();
+                unpin_page(page_id, false);
+            }
+        };
+        try {
+            if (pending_lsn != INVALID_LSN) log_->flush_async(pending_lsn);
+            if (!batch.empty()) {
+                disk_manager_->submit(batch);
+                disk_manager_->wait(batch);
+            }
+        }
+        catch (...) {
+            // Whatever did not reach disk must stay dirty
+            for (auto [page_id, frame_id] : held) mark_dirty(frames_[frame_id]);
+            release();
+            throw;
+        }
+        for (auto [page_id, frame_id] : held) pages_[frame_id].clear_rec_lsn();
+        release();
+    }
+
+    // Dirty (page_id, frame_id) pairs sorted by page_id so write-back is as
+    // sequential as possible
+    std::vector<std::pair<uint32_t, size_t>> collect_dirty(size_t limit) const {
+        std::vector<std::pair<uint32_t, size_t>> out;
+        for (size_t i = 0; i < frames_.size(); ++i) {
+            if (!frames_[i].dirty.load()) continue;
+            uint32_t pid = frames_[i].page_id.load();
+            if (pid != INVALID_PAGE_ID) out.emplace_back(pid, i);
+        }
+        std::sort(out.begin(), out.end());
+        if (out.size() > limit) out.resize(limit);
+        return out;
+    }
+
+    // Background write-back: wakes on a timer or when the dirty count climbs
+    void flusher_loop() {
+        std::unique_lock<std::mutex> lk(flush_latch_);
+        while (!stop_) {
+            flush_cv_.wait_for(lk, flush_interval_);
+            if (stop_) break;
+            lk.unlock();
+            flush_batch(collect_dirty(FLUSH_BATCH));    // busy pages wait for the next round
+            lk.lock();
+        }
+    }
+
+    // Find a frame for page_id. Returns the frame already holding it (hit),
+    // a free frame, or an evicted victim; lk (page_id's shard) is held on
+    // return. nullopt means every frame is pinned.
+    std::optional<size_t> acquire_frame(uint32_t page_id, Shard& s,
+        std::unique_lock<std::mutex>& lk, bool& hit) {
+        for (;;) {
+            auto it = s.table.find(page_id);
+            if (it != s.table.end()) { hit = true; return it->second; }
+
+            {
+                std::lock_guard<std::mutex> fl(free_latch_);
+                if (!free_list_.empty()) {
+                    size_t frame_id = free_list_.back();
+                    free_list_.pop_back();
+                    return frame_id;
+                }
+            }
+
+            size_t victim_frame;
+            if (!replacer_->victim(victim_frame)) return std::nullopt;
+
+            // Evict victim: the descriptor tells us which page lives there.
+            // Its shard must be latched too; take both without deadlocking.
+            uint32_t evicted_page = frames_[victim_frame].page_id.load();
+            Shard& os = shard_for(evicted_page);
+            std::unique_lock<std::mutex> olk;
+            if (&os != &s) {
+                olk = std::unique_lock<std::mutex>(os.latch, std::defer_lock);
+                lk.unlock();
+                std::lock(lk, olk);
+            }
+
+            auto oit = os.table.find(evicted_page);
+            if (oit == os.table.end() || oit->second != victim_frame ||
+                frames_[victim_frame].pin_count.load() != 0) {
+                continue;                  // re-pinned or taken by another evictor
+            }
+            if (&os != &s && s.table.count(page_id)) {
+                replacer_->insert(victim_frame);   // someone loaded page_id meanwhile
+                continue;
+            }
+
+            if (frames_[victim_frame].dirty.load()) {
+                write_back(victim_frame, lk, &olk);
+                if (frames_[victim_frame].pin_count.load() != 0) continue;   // fetched during the write
+                if (s.table.count(page_id)) {
+                    replacer_->insert(victim_frame);   // someone loaded page_id meanwhile
+                    continue;
                 }
-                return i;
+                oit = os.table.find(evicted_page);
             }
+            os.table.erase(oit);
+            frames_[victim_frame].page_id.store(INVALID_PAGE_ID);
+            replacer_->erase(victim_frame);        // drop any stale entry
+            replacer_->forget(victim_frame);
+            return victim_frame;
         }
-        return std::nullopt;
     }
 };
@@ -0,0 +1,273 @@
+#include "catalog.hpp"
+#include <algorithm>
+#include <cstring>
+
+// Header slots, each in its own 512-byte sector of page 0
+static constexpr uint32_t HEADER_MAGIC = 0x4244594d;   // "MYDB"
+static constexpr size_t SLOT_POS[2] = { 512, 1024 };
+static constexpr size_t SLOT_WORDS = 11;              // magic .. checksum
+
+// Catalog page: [Page header 8][next u32][used u32][bytes]
+static constexpr size_t CHAIN_NEXT = Page::HEADER_SIZE;
+static constexpr size_t CHAIN_USED = Page::HEADER_SIZE + 4;
+static constexpr size_t CHAIN_DATA = Page::HEADER_SIZE + 8;
+static constexpr size_t CHAIN_CAPACITY = Page::PAGE_SIZE - CHAIN_DATA;
+
+enum : uint8_t { KIND_PRIMARY = 0, KIND_SECONDARY = 1, KIND_HASH = 2 };
+
+static uint32_t fnv1a(const void* data, size_t n) {
+    const auto* p = static_cast<const unsigned char*>(data);
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; ++i) h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+/* ---------- catalog encoding ---------- */
+
+namespace {
+
+struct Writer {
+    std::string out;
+
+    template <class T> void put(T v) { out.append(reinterpret_cast<const char*>(&v), sizeof v); }
+    void put_str(const std::string& s) {
+        put<uint16_t>(static_cast<uint16_t>(s.size()));
+        out += s;
+    }
+};
+
+struct Reader {
+    const std::string& in;
+    size_t pos = 0;
+
+    void need(size_t n) const {
+        if (in.size() - pos < n) throw std::runtime_error("catalog is corrupt");
+    }
+    template <class T> T get() {
+        need(sizeof(T));
+        T v;
+        std::memcpy(&v, in.data() + pos, sizeof v);
+        pos += sizeof v;
+        return v;
+    }
+    std::string get_str() {
+        size_t n = get<uint16_t>();
+        need(n);
+        pos += n;
+        return in.substr(pos - n, n);
+    }
+};
+
+}
+
+/* ---------- open / close ---------- */
+
+Catalog::Catalog(BufferPoolManager* bpm, LogManager* log) : bpm_(bpm), log_(log) {
+    if (bpm_->next_page_id() == 0) {
+        // Empty file: the header takes page 0, before any table
+        uint32_t page_id;
+        Page* page = bpm_->new_page(page_id);
+        if (!page || page_id != HEADER_PAGE) throw std::runtime_error("Failed to allocate the header page");
+        bpm_->unpin_page(page_id, true);
+        save(STATE_OPEN);
+        return;
+    }
+
+    read_header();
+    bpm_->reserve_page_ids(header_.page_count);
+    opened_clean_ = header_.state == STATE_CLEAN;
+    decode(read_chain(header_.chain_root[header_.chain], header_.catalog_bytes), opened_clean_);
+    if (opened_clean_) {
+        // Nothing was touched yet: flipping the state is enough
+        ++header_.seq;
+        header_.state = STATE_OPEN;
+        write_header();
+    } else {
+        save(STATE_OPEN);          // new map and index roots
+    }
+}
+
+void Catalog::close() {
+    bpm_->flush_all_pages();
+    save(STATE_CLEAN);
+}
+
+/* ---------- header page ---------- */
+
+void Catalog::read_header() {
+    Page* page = bpm_->fetch_page(HEADER_PAGE);
+    if (!page) throw std::runtime_error("Failed to fetch the header page");
+    bool found = false;
+    for (size_t slot = 0; slot < 2; ++slot) {
+        uint32_t w[SLOT_WORDS];
+        std::memcpy(w, page->data() + SLOT_POS[slot], sizeof w);
+        if (w[0] != HEADER_MAGIC || w[10] != fnv1a(w, 10 * sizeof(uint32_t)) || w[1] % 2 != slot) continue;
+        if (found && w[1] < header_.seq) continue;
+        header_ = Header{ w[1], w[2], w[3], w[4], { w[5], w[6] }, w[7], w[8] };
+        found = true;
+    }
+    bpm_->unpin_page(HEADER_PAGE, false);
+    if (!found) throw std::runtime_error("data file has no valid header page");
+    if (header_.chain > 1) throw std::runtime_error("header page is corrupt");
+}
+
+void Catalog::write_header() {
+    uint32_t w[SLOT_WORDS] = { HEADER_MAGIC, header_.seq, header_.state, header_.page_count, header_.chain,
+        header_.chain_root[0], header_.chain_root[1], header_.catalog_bytes, header_.catalog_sum, 0, 0 };
+    w[10] = fnv1a(w, 10 * sizeof(uint32_t));
+
+    Page* page = bpm_->fetch_page(HEADER_PAGE);
+    if (!page) throw std::runtime_error("Failed to fetch the header page");
+    page->w_latch();
+    std::memcpy(page->data() + SLOT_POS[header_.seq % 2], w, sizeof w);
+    page->w_unlatch();
+    bpm_->unpin_page(HEADER_PAGE, true);
+    bpm_->flush_page(HEADER_PAGE);
+    bpm_->sync();
+}
+
+void Catalog::save(uint32_t state) {
+    // A table's first heap page must not be known only to the catalog
+    if (log_) log_->flush_all();
+
+    std::string bytes = encode();
+    uint32_t chain = header_.chain ^ 1;
+    write_chain(header_.chain_root[chain], bytes);
+    bpm_->sync();
+
+    ++header_.seq;
+    header_.state = state;
+    header_.chain = chain;
+    header_.page_count = bpm_->next_page_id();
+    header_.catalog_bytes = static_cast<uint32_t>(bytes.size());
+    header_.catalog_sum = fnv1a(bytes.data(), bytes.size());
+    write_header();
+}
+
+/* ---------- catalog chains ---------- */
+
+std::string Catalog::read_chain(uint32_t root, size_t bytes) {
+    std::string out;
+    out.reserve(bytes);
+    for (uint32_t page_id = root; out.size() < bytes;) {
+        if (page_id == BufferPoolManager::INVALID_PAGE_ID) throw std::runtime_error("catalog is corrupt");
+        Page* page = bpm_->fetch_page(page_id);
+        if (!page) throw std::runtime_error("Failed to fetch catalog page");
+        const std::byte* raw = page->data();
+        uint32_t next, used;
+        std::memcpy(&next, raw + CHAIN_NEXT, sizeof next);
+        std::memcpy(&used, raw + CHAIN_USED, sizeof used);
+        used = static_cast<uint32_t>(std::min<size_t>({ used, CHAIN_CAPACITY, bytes - out.size() }));
+        out.append(reinterpret_cast<const char*>(raw + CHAIN_DATA), used);
+        bpm_->unpin_page(page_id, false);
+        page_id = next;
+    }
+    if (fnv1a(out.data(), out.size()) != header_.catalog_sum) throw std::runtime_error("catalog checksum mismatch");
+    return out;
+}
+
+void Catalog::write_chain(uint32_t& root, const std::string& bytes) {
+    // An empty catalog page, linked from nowhere yet
+    auto allocate = [this] {
+        uint32_t page_id;
+        Page* page = bpm_->new_page(page_id);
+        if (!page) throw std::runtime_error("Failed to allocate catalog page");
+        uint32_t none = BufferPoolManager::INVALID_PAGE_ID;
+        std::memcpy(page->data() + CHAIN_NEXT, &none, sizeof none);
+        bpm_->unpin_page(page_id, true);
+        return page_id;
+    };
+
+    // Reuse the chain's pages, extending it when the catalog has grown
+    if (root == BufferPoolManager::INVALID_PAGE_ID) root = allocate();
+    size_t done = 0;
+    for (uint32_t page_id = root;;) {
+        Page* page = bpm_->fetch_page(page_id);
+        if (!page) throw std::runtime_error("Failed to fetch catalog page");
+        uint32_t used = static_cast<uint32_t>(std::min(CHAIN_CAPACITY, bytes.size() - done));
+        done += used;
+        uint32_t next;
+        std::memcpy(&next, page->data() + CHAIN_NEXT, sizeof next);
+        if (done < bytes.size() && next == BufferPoolManager::INVALID_PAGE_ID) next = allocate();
+
+        page->w_latch();
+        std::memcpy(page->data() + CHAIN_NEXT, &next, sizeof next);
+        std::memcpy(page->data() + CHAIN_USED, &used, sizeof used);
+        std::memcpy(page->data() + CHAIN_DATA, bytes.data() + done - used, used);
+        page->w_unlatch();
+        bpm_->unpin_page(page_id, true);
+        bpm_->flush_page(page_id);
+        if (done == bytes.size()) break;
+        page_id = next;
+    }
+}
+
+/* ---------- catalog bytes ---------- */
+
+std::string Catalog::encode() const {
+    Writer w;
+    w.put<uint32_t>(static_cast<uint32_t>(tables_.size()));
+    for (const auto& [name, tm] : tables_) {
+        w.put_str(name);
+        w.put<uint16_t>(static_cast<uint16_t>(tm.schema.columns().size()));
+        for (const ColumnDef& col : tm.schema.columns()) {
+            w.put_str(col.name);
+            w.put<uint8_t>(static_cast<uint8_t>(col.type));
+            w.put<uint32_t>(static_cast<uint32_t>(col.len));
+        }
+        w.put<uint32_t>(tm.heap->first_page());
+        w.put<uint32_t>(tm.heap->fsm_root());
+        w.put<uint64_t>(tm.heap->row_count());
+        w.put<uint16_t>(static_cast<uint16_t>(tm.indexes.size()));
+        for (const auto& idx : tm.indexes) {
+            w.put_str(idx->name());
+            w.put<uint8_t>(idx->unique() ? KIND_PRIMARY : idx->ordered() ? KIND_SECONDARY : KIND_HASH);
+            w.put<uint16_t>(static_cast<uint16_t>(idx->column()));
+            w.put<uint32_t>(idx->root_page());
+        }
+    }
+    return std::move(w.out);
+}
+
+void Catalog::decode(const std::string& bytes, bool clean) {
+    Reader r{ bytes };
+    for (uint32_t t = r.get<uint32_t>(); t > 0; --t) {
+        std::string name = r.get_str();
+        std::vector<ColumnDef> cols(r.get<uint16_t>());
+        for (ColumnDef& col : cols) {
+            col.name = r.get_str();
+            col.type = static_cast<ColumnType>(r.get<uint8_t>());
+            col.len = r.get<uint32_t>();
+        }
+        uint32_t first_page = r.get<uint32_t>();
+        uint32_t fsm_root = r.get<uint32_t>();
+        uint64_t rows = r.get<uint64_t>();
+
+        // After a crash the heap is walked to refill its map and count rows
+        std::unique_ptr<TableHeap> heap = clean
+            ? std::make_unique<TableHeap>(bpm_, log_, first_page, fsm_root, rows)
+            : std::make_unique<TableHeap>(bpm_, log_, first_page, fsm_root);
+
+        std::vector<std::unique_ptr<Index>> indexes;
+        for (uint16_t i = r.get<uint16_t>(); i > 0; --i) {
+            std::string index = r.get_str();
+            uint8_t kind = r.get<uint8_t>();
+            size_t c = r.get<uint16_t>();
+            uint32_t root = r.get<uint32_t>();
+            if (c >= cols.size() || kind > KIND_HASH) throw std::runtime_error("catalog is corrupt");
+            // Not logged, so only usable after a clean shutdown; else rebuilt below
+            if (kind == KIND_PRIMARY) {
+                indexes.push_back(clean ? std::make_unique<PrimaryIndex>(bpm_, index, c, root)
+                                        : std::make_unique<PrimaryIndex>(bpm_, index, c));
+            } else if (kind == KIND_SECONDARY) {
+                indexes.push_back(clean ? std::make_unique<SecondaryIndex>(bpm_, index, c, cols[c], root)
+                                        : std::make_unique<SecondaryIndex>(bpm_, index, c, cols[c]));
+            } else {
+                indexes.push_back(clean ? std::make_unique<HashIndex>(bpm_, index, c, cols[c], root)
+                                        : std::make_unique<HashIndex>(bpm_, index, c, cols[c]));
+            }
+        }
+        tables_.emplace(name, TableMeta(Schema(std::move(cols)), std::move(heap), std::move(indexes)));
+        if (!clean) rebuild_indexes(name);
+    }
+}
@@ -2,43 +2,182 @@
 #include <unordered_map>
 #include <memory>
 #include <stdexcept>
+#include <string>
+#include <vector>
 #include "storage/schema.hpp"
 #include "storage/table_heap.hpp"
-#include "storage/bplus_tree.hpp"
+#include "storage/index.hpp"
 #include "storage/rid.hpp"
 
-using RidIndex = BPlusTree<RID>;
-
 struct TableMeta {
-    Schema                       schema;
-    std::unique_ptr<TableHeap>   heap;
-    std::unique_ptr<RidIndex>    index;
+    Schema                              schema;
+    std::unique_ptr<TableHeap>          heap;
+    std::vector<std::unique_ptr<Index>> indexes;    // primary key first, if any
 
     // full ctor
     TableMeta(Schema s,
         std::unique_ptr<TableHeap> h,
-        std::unique_ptr<RidIndex> i)
-        : schema(std::move(s)), heap(std::move(h)), index(std::move(i)) {
+        std::vector<std::unique_ptr<Index>> i)
+        : schema(std::move(s)), heap(std::move(h)), indexes(std::move(i)) {
     }
 
     TableMeta(const TableMeta&) = delete;
     TableMeta& operator=(const TableMeta&) = delete;
     TableMeta(TableMeta&&) = default;
     TableMeta& operator=(TableMeta&&) = default;
+
+    /* Position of a column (throws if not present) */
+    size_t column(const std::string& name) const {
+        const auto& cols = schema.columns();
+        for (size_t c = 0; c < cols.size(); ++c)
+            if (cols[c].name == name) return c;
+        throw std::runtime_error("no column " + name);
+    }
+
+    /* The index to answer a predicate on column c, or nullptr. Equality
+       prefers a hash index, then any other (primary key first); a range
+       needs an ordered one */
+    Index* index_on(size_t c, bool equality = false) const {
+        Index* best = nullptr;
+        for (auto& idx : indexes) {
+            if (idx->column() != c || (!equality && !idx->ordered())) continue;
+            if (equality && !idx->ordered()) return idx.get();
+            if (!best) best = idx.get();
+        }
+        return best;
+    }
 };
 
+/*
+ * The system catalog, kept in the data file.
+ *
+ * Page 0 is the database header. It holds two slots, in separate sectors
+ * and written alternately, so a torn write leaves the other one intact:
+ *
+ *   [magic][seq][state][page_count][chain][chain_root * 2][catalog_bytes][catalog_sum][checksum]
+ *
+ * The catalog itself is a byte string in a chain of catalog pages
+ * ([Page header 8][next u32][used u32][bytes]). Per table: name, columns
+ * (name, type, length), first heap page, free-space map root, row count,
+ * and per index its name, kind, column and root page. There are two
+ * chains: a save writes the one the live slot does not point to, syncs
+ * it, then writes the other slot, so the header always names a complete
+ * catalog.
+ *
+ * state says whether the file was closed cleanly. Opening it then reads
+ * the header, the catalog pages, each table's free-space map and each
+ * index's meta and root pages, and nothing else; the state goes back to
+ * OPEN (durably) before anything is changed. After a crash, the heaps are
+ * what restart recovery made of them but the free-space maps and indexes
+ * are not logged: each heap is walked once for a new map and its row
+ * count, and its indexes are rebuilt. Their old pages are not reused, as
+ * no page is ever freed.
+ *
+ * page_count is the number of page ids handed out at the last save, so
+ * pages allocated but never written are not handed out twice.
+ */
 class Catalog {
 public:
-    explicit Catalog(BufferPoolManager* bpm) : bpm_(bpm) {}
+    static constexpr uint32_t HEADER_PAGE = 0;
+
+    // Opens the catalog of the pool's file, after restart recovery, or
+    // creates the header page of an empty file. With a log, every table's
+    // heap changes are write-ahead logged.
+    explicit Catalog(BufferPoolManager* bpm, LogManager* log = nullptr);
+
+    Catalog(const Catalog&) = delete;
+    Catalog& operator=(const Catalog&) = delete;
 
-    /* Create table */
+    LogManager* log() const { return log_; }
+
+    // Clean shutdown, once nothing else uses the tables: flush every page,
+    // then save the catalog (row counts, index roots) marked clean
+    void close();
+
+    // Whether the file had been closed cleanly when it was opened
+    bool opened_clean() const { return opened_clean_; }
+
+    // Changes whenever a table or an index is added, so that a plan can
+    // tell whether it was made for the current tables
+    uint64_t version() const { return version_; }
+
+    /* Create table; an INT first column becomes the primary key */
     void create_table(const std::string& name, const Schema& schema) {
         if (tables_.contains(name)) throw std::runtime_error("table exists");
 
-        auto heap = std::make_unique<TableHeap>(bpm_);
-        auto index = std::make_unique<RidIndex>();
+        auto heap = std::make_unique<TableHeap>(bpm_, log_);
+        std::vector<std::unique_ptr<Index>> indexes;
+        if (!schema.columns().empty() && schema.columns()[0].type == ColumnType::INT)
+            indexes.push_back(std::make_unique<PrimaryIndex>(bpm_, "primary", 0));
         tables_.emplace(name,
-            TableMeta(schema, std::move(heap), std::move(index)));
+            TableMeta(schema, std::move(heap), std::move(indexes)));
+        ++version_;
+        save(STATE_OPEN);
+    }
+
+    /* CREATE INDEX: a secondary (or hash) index on one column, filled
+       from the heap the same way as a rebuild */
+    void create_index(const std::string& table, const std::string& index, const std::string& column, bool hash = false) {
+        auto& tm = get(table);
+        for (auto& idx : tm.indexes)
+            if (idx->name() == index) throw std::runtime_error("index exists");
+        size_t c = tm.column(column);
+        const ColumnDef& col = tm.schema.columns()[c];
+        std::unique_ptr<Index> idx;
+        if (hash) idx = std::make_unique<HashIndex>(bpm_, index, c, col);
+        else      idx = std::make_unique<SecondaryIndex>(bpm_, index, c, col);
+        idx->build(column_values(tm, c), 1.0);
+        tm.indexes.push_back(std::move(idx));
+        ++version_;
+        save(STATE_OPEN);
+    }
+
+    /* Rebuild a table's indexes from its heap: scan, sort by key, bulk load.
+       For the primary key the first row seen for a key wins, as with
+       one-by-one inserts. */
+    void rebuild_indexes(const std::string& name, double fill_factor = 1.0) {
+        auto& tm = get(name);
+        for (auto& idx : tm.indexes) idx->build(column_values(tm, idx->column()), fill_factor);
+    }
+
+    /* Index the rows a TableHeap::Appender put into a table's heap from
+       chain position from_pos on. A load of at least a quarter as many
+       rows as were there before rebuilds every index (unique ones first);
+       a smaller one is inserted row by row. A new row whose primary key
+       an older row, or an earlier new one, already has is deleted again
+       in txn. Returns how many were. */
+    size_t index_appended(const std::string& name, size_t from_pos, size_t appended, Txn* txn) {
+        auto& tm = get(name);
+        size_t dropped = 0;
+        if (4 * appended >= tm.heap->row_count() - appended) {
+            for (auto& idx : tm.indexes) {
+                if (!idx->unique()) continue;
+                for (const RID& rid : idx->build(column_values(tm, idx->column()))) {
+                    tm.heap->delete_tuple(rid, txn);
+                    ++dropped;
+                }
+            }
+            for (auto& idx : tm.indexes)
+                if (!idx->unique()) idx->build(column_values(tm, idx->column()));
+            return dropped;
+        }
+
+        std::vector<std::string> values(tm.indexes.size());
+        auto it = tm.heap->scan(from_pos);
+        RID rid;
+        TupleView t;
+        while (it.next(t, rid)) {
+            size_t i = 0;
+            for (; i < tm.indexes.size(); ++i) {
+                values[i] = tm.schema.value(t, tm.indexes[i]->column());
+                if (!tm.indexes[i]->insert(values[i], rid)) break;
+            }
+            if (i == tm.indexes.size()) continue;
+            for (size_t j = 0; j < i; ++j) tm.indexes[j]->remove(values[j], rid);
+            tm.heap->delete_tuple(rid, txn);
+            ++dropped;
+        }
+        return dropped;
     }
 
     /* Lookup (throws if not present) */
@@ -48,7 +187,49 @@ public:
     bool exists(const std::string& n) const { return tables_.contains(n); }
 
 private:
+    enum : uint32_t { STATE_OPEN = 1, STATE_CLEAN = 2 };
+
+    // The live header slot
+    struct Header {
+        uint32_t seq = 0;
+        uint32_t state = STATE_OPEN;
+        uint32_t page_count = 0;
+        uint32_t chain = 0;                    // catalog chain in use
+        uint32_t chain_root[2] = { BufferPoolManager::INVALID_PAGE_ID, BufferPoolManager::INVALID_PAGE_ID };
+        uint32_t catalog_bytes = 0;
+        uint32_t catalog_sum = 0;
+    };
+
+    // Header page: pick the newest valid slot
+    void read_header();
+    // Write header_ to its slot (seq % 2) and make it durable
+    void write_header();
+    // Write the catalog to the spare chain, then point the header at it
+    void save(uint32_t state);
+
+    std::string encode() const;
+    // Recreate the tables from the catalog bytes; clean: reopen their
+    // free-space maps and indexes as they are, else rebuild them
+    void decode(const std::string& bytes, bool clean);
+
+    std::string read_chain(uint32_t root, size_t bytes);
+    void write_chain(uint32_t& root, const std::string& bytes);
+
+    // (value, rid) of column c for every row, in heap order
+    static std::vector<std::pair<std::string, RID>> column_values(TableMeta& tm, size_t c) {
+        std::vector<std::pair<std::string, RID>> rows;
+        auto it = tm.heap->scan();
+        RID rid;
+        TupleView t;
+        while (it.next(t, rid)) rows.emplace_back(tm.schema.value(t, c), rid);
+        return rows;
+    }
+
     BufferPoolManager* bpm_;
+    LogManager*        log_;
+    Header             header_;
+    bool               opened_clean_ = false;
+    uint64_t           version_ = 1;
     std::unordered_map<std::string, TableMeta> tables_;
 };
 
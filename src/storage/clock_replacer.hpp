@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include "replacer.hpp"
+
+/*
+ * CLOCK (second chance) replacer.
+ *
+ * One reference bit and one evictable bit per frame, both atomics in
+ * arrays sized once at construction: insert/erase/record_access are single
+ * atomic stores and never allocate. Only the sweeping hand in victim()
+ * takes a latch.
+ */
+class ClockReplacer : public Replacer {
+public:
+    explicit ClockReplacer(size_t capacity)
+        : capacity_(capacity),
+        ref_(std::make_unique<std::atomic<bool>[]>(capacity)),
+        evictable_(std::make_unique<std::atomic<bool>[]>(capacity)) {
+    }
+
+    void record_access(size_t frame_id, uint32_t) override {
+        ref_[frame_id].store(true, std::memory_order_relaxed);
+    }
+
+    void insert(size_t frame_id) override {
+        if (!evictable_[frame_id].exchange(true)) size_.fetch_add(1);
+    }
+
+    // No reference bit: the hand takes it on its first pass
+    void insert_cold(size_t frame_id, uint32_t) override {
+        ref_[frame_id].store(false, std::memory_order_relaxed);
+        insert(frame_id);
+    }
+
+    bool erase(size_t frame_id) override {
+        if (!evictable_[frame_id].exchange(false)) return false;
+        size_.fetch_sub(1);
+        return true;
+    }
+
+    // Sweep: clear reference bits until an evictable, unreferenced frame shows up.
+    // Two full turns are enough unless frames keep getting pinned under us.
+    bool victim(size_t& frame_id) override {
+        std::lock_guard<std::mutex> lk(hand_latch_);
+        for (size_t step = 0; step < 2 * capacity_ && size_.load() > 0; ++step) {
+            size_t f = hand_;
+            hand_ = (hand_ + 1) % capacity_;
+            if (!evictable_[f].load()) continue;
+            if (ref_[f].exchange(false, std::memory_order_relaxed)) continue;   // second chance
+
+            bool expected = true;
+            if (evictable_[f].compare_exchange_strong(expected, false)) {
+                size_.fetch_sub(1);
+                frame_id = f;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    size_t size() const override { return size_.load(); }
+
+private:
+    size_t capacity_;
+    std::unique_ptr<std::atomic<bool>[]> ref_;
+    std::unique_ptr<std::atomic<bool>[]> evictable_;
+    std::atomic<size_t> size_{ 0 };
+    std::mutex hand_latch_;
+    size_t hand_ = 0;
+};
@@ -1,29 +1,81 @@
 #include "disk_manager.hpp"
 #include "storage/page.hpp"
+#include "storage/posix_io.hpp"
+#include "storage/uring_io.hpp"
+#include "storage/mmap_io.hpp"
 
 #include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-DiskManager::DiskManager(const std::string& filename) {
-    file_.open(filename, std::ios::in | std::ios::out | std::ios::binary);
-    if (!file_.is_open()) {
-        file_.open(filename, std::ios::out | std::ios::binary);
-        file_.close();
-        file_.open(filename, std::ios::in | std::ios::out | std::ios::binary);
+DiskManager::DiskManager(const std::string& filename, IOMode mode, bool direct_io) {
+    int flags = O_RDWR | O_CREAT;
+    if (mode == IOMode::MMAP) direct_io = false;
+    if (direct_io) {
+        fd_ = ::open(filename.c_str(), flags | O_DIRECT, 0644);
+        if (fd_ < 0) {
+            std::cerr << "O_DIRECT unavailable for " << filename << " ("
+                << std::strerror(errno) << "), using buffered I/O\n";
+            direct_io = false;
+        }
     }
+    if (fd_ < 0) fd_ = ::open(filename.c_str(), flags, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("cannot open " + filename + ": " + std::strerror(errno));
+    }
+
+    if (mode == IOMode::URING) {
+        try {
+            backend_ = std::make_unique<IoUringIO>(fd_, direct_io);
+        }
+        catch (const std::exception& e) {
+            std::cerr << e.what() << ", using pread/pwrite\n";
+        }
+    }
+    else if (mode == IOMode::MMAP) {
+        try {
+            auto mapping = std::make_unique<MmapIO>(fd_);
+            mapping_ = mapping.get();
+            backend_ = std::move(mapping);
+        }
+        catch (const std::exception& e) {
+            std::cerr << e.what() << ", using pread/pwrite\n";
+        }
+    }
+    if (!backend_) backend_ = std::make_unique<PosixIO>(fd_, direct_io);
 }
 
 DiskManager::~DiskManager() {
-    file_.close();
+    backend_.reset();
+    ::close(fd_);
 }
 
 void DiskManager::read_page(uint32_t page_id, std::byte* out_buffer) {
-    file_.seekg(page_id * Page::PAGE_SIZE);
-    file_.read(reinterpret_cast<char*>(out_buffer), Page::PAGE_SIZE);
+    backend_->read_page(page_id, out_buffer);
 }
 
 void DiskManager::write_page(uint32_t page_id, const std::byte* buffer) {
-    file_.seekp(page_id * Page::PAGE_SIZE);
-    file_.write(reinterpret_cast<const char*>(buffer), Page::PAGE_SIZE);
-    file_.flush();
+    backend_->write_page(page_id, buffer);
+}
+
+std::byte* DiskManager::mapped_page(uint32_t page_id) {
+    return mapping_ ? mapping_->page_ptr(page_id) : nullptr;
+}
+
+void DiskManager::sync() {
+    backend_->sync();
 }
 
+uint32_t DiskManager::num_pages() const {
+    // A mapped file is longer than what is in use: see MmapIO
+    if (mapping_) return mapping_->num_pages();
+    struct stat st;
+    if (::fstat(fd_, &st) != 0) {
+        throw std::runtime_error(std::string("fstat failed: ") + std::strerror(errno));
+    }
+    return static_cast<uint32_t>((static_cast<size_t>(st.st_size) + Page::PAGE_SIZE - 1) / Page::PAGE_SIZE);
+}
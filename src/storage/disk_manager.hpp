@@ -1,18 +1,66 @@
 #pragma once
 #include <string>
-#include <fstream>
+#include <memory>
+#include <span>
 #include <vector>
+#include "io_backend.hpp"
+
+class MmapIO;
+
+/* Which IOBackend a DiskManager drives */
+enum class IOMode { PREAD, URING, MMAP };
 
 class DiskManager {
 public:
-    DiskManager(const std::string& filename);
+    // direct_io opens the file with O_DIRECT (page buffers must be 4 KB
+    // aligned, which BufferPoolManager guarantees). If the filesystem or
+    // kernel refuses O_DIRECT or io_uring, the manager falls back to
+    // buffered pread/pwrite and says so on stderr. MMAP maps the file
+    // instead (direct_io is ignored there).
+    DiskManager(const std::string& filename, IOMode mode = IOMode::PREAD, bool direct_io = false);
     ~DiskManager();
 
+    DiskManager(const DiskManager&) = delete;
+    DiskManager& operator=(const DiskManager&) = delete;
+
     void read_page(uint32_t page_id, std::byte* out_buffer);
     void write_page(uint32_t page_id, const std::byte* buffer);
 
+    // Batched, possibly asynchronous I/O: submit() queues, wait() completes
+    void submit(std::span<IORequest* const> batch) { backend_->submit(batch); }
+    void wait(std::span<IORequest* const> batch) { backend_->wait(batch); }
+
+    // Make written pages durable (used at checkpoints)
+    void sync();
+
+    // Pages the file holds (its size in pages, rounded up); in MMAP mode
+    // the pages in use, without the file's pre-extended tail
+    uint32_t num_pages() const;
+
+    // Readahead support: async_io() tells whether submit() overlaps with
+    // the caller, poll() reaps without blocking, advise() asks the OS to
+    // start reading pages it will be asked for soon
+    bool async_io() const { return backend_->async(); }
+    void poll() { backend_->poll(); }
+    void advise(uint32_t page_id, size_t count) { backend_->advise(page_id, count); }
+
+    const char* backend_name() const { return backend_->name(); }
+
+    // In MMAP mode: the page's address inside the mapping, stable for the
+    // life of the manager. nullptr in every other mode.
+    std::byte* mapped_page(uint32_t page_id);
+    bool mapped() const { return mapping_ != nullptr; }
 
 private:
-    std::fstream file_;
-    const size_t PAGE_SIZE = 4096;
+    int fd_ = -1;
+    std::unique_ptr<IOBackend> backend_;
+    MmapIO* mapping_ = nullptr;          // backend_ when it is an MmapIO
 };
+
+// Disk manager by I/O name: pread (default), direct, uring, uring-direct, mmap
+inline std::unique_ptr<DiskManager> make_disk_manager(const std::string& filename, const std::string& io) {
+    IOMode mode = io == "mmap" ? IOMode::MMAP
+        : io.rfind("uring", 0) == 0 ? IOMode::URING : IOMode::PREAD;
+    bool direct = io == "direct" || io == "uring-direct";
+    return std::make_unique<DiskManager>(filename, mode, direct);
+}
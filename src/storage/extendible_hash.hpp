@@ -0,0 +1,518 @@
+/************************  extendible_hash.hpp  ***********************
+ * Header-only, disk-resident extendible hash table
+ * - key   : std::string holding fixed-width byte strings
+ * - value : templated ValueT, trivially copyable, with operator==
+ *
+ * A multimap: a key may have any number of values, and insert refuses
+ * only a (key, value) pair that is already there. Lookups are equality
+ * only, with no order, so a point lookup reads one directory slot and
+ * one bucket page instead of a path of tree nodes.
+ *
+ * Like the B+-tree, every page is fetched and pinned through the
+ * BufferPoolManager. A header page lists the directory pages, so the
+ * table is identified by a page id that never changes. The directory is
+ * also mirrored in memory (4 bytes a slot), so a lookup fetches only its
+ * bucket; the pages are what a reopened table loads the mirror from.
+ *
+ *   header:     [global_depth u32][key_width u32][pad to 16][directory page id u32 * DIR_PAGES]
+ *   directory:  [pad to 16][bucket page id u32 * SLOTS_PER_PAGE]
+ *   bucket:     [count u16][local_depth u16][next u32][pad to 16]
+ *               [tag u8 * CAP, padded to 32][(key, value) * CAP]
+ *
+ * The low global_depth bits of a key's hash pick a directory slot;
+ * 2^(global_depth - local_depth) slots share a bucket. A full bucket is
+ * split on its next hash bit, doubling the directory first when its
+ * local depth is the global one. When splitting would not separate most
+ * of its entries, because they hash alike (one value with many rows) or
+ * the directory is at MAX_DEPTH, the bucket gets an overflow page
+ * instead, chained through `next`. Removes do not merge buckets: the
+ * buffer pool never gives pages back, so an emptied page stays for
+ * later inserts.
+ *
+ * Each entry has a one-byte tag, the top byte of its hash, kept in an
+ * array ahead of the entries. A probe compares 32 tags at a time
+ * (simd::match_bytes32) and compares keys only where the tag matches.
+ *
+ * Concurrency: the header page's latch is the table latch. Inserts and
+ * removes hold it shared plus the w_latch of their bucket's first page,
+ * which covers the whole overflow chain; a split or a directory doubling
+ * holds it exclusively. Lookups take no latches: like the B+-tree's
+ * readers they check the header's and the bucket's versions
+ * (Page::version) after reading, and start over if either moved. The
+ * header stays pinned while the table is open.
+ *****************************************************************/
+#pragma once
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "buffer_pool_manager.hpp"
+#include "key_width.hpp"
+#include "simd_search.hpp"
+
+template <typename ValueT>
+class ExtendibleHash {
+    static_assert(std::is_trivially_copyable_v<ValueT>, "hash table values are stored as raw bytes");
+
+    /* ================= PAGE LAYOUT =============== */
+    static constexpr size_t DEPTH_POS = Page::HEADER_SIZE;          // header: u32
+    static constexpr size_t WIDTH_POS = Page::HEADER_SIZE + 4;      // header: u32
+    static constexpr size_t DIRS_POS = 16;                          // header: u32 per directory page
+    static constexpr size_t SLOTS_POS = 16;                         // directory: u32 per slot
+    static constexpr size_t COUNT_POS = Page::HEADER_SIZE;          // bucket: u16
+    static constexpr size_t LOCAL_DEPTH_POS = Page::HEADER_SIZE + 2;// bucket: u16
+    static constexpr size_t NEXT_POS = Page::HEADER_SIZE + 4;       // bucket: u32
+    static constexpr size_t TAGS_POS = 16;                          // bucket
+    static constexpr size_t TAG_BLOCK = 32;                         // tags are matched 32 at a time
+
+    static constexpr size_t SLOT_BITS = 9;
+    static constexpr size_t SLOTS_PER_PAGE = size_t(1) << SLOT_BITS;
+    static constexpr size_t DIR_PAGES = 512;
+
+    static constexpr size_t align_up(size_t n, size_t a) { return (n + a - 1) / a * a; }
+
+public:
+    static constexpr uint32_t INVALID_PAGE = UINT32_MAX;
+    // Deepest directory: DIR_PAGES full directory pages
+    static constexpr size_t MAX_DEPTH = SLOT_BITS + 9;
+    static_assert((size_t(1) << MAX_DEPTH) == SLOTS_PER_PAGE * DIR_PAGES);
+    // Widest key: a bucket page must still hold 4 entries
+    static constexpr size_t MAX_KEY_WIDTH = (Page::PAGE_SIZE - TAGS_POS - TAG_BLOCK) / 4 - sizeof(ValueT);
+
+    // Creates an empty table (header, one directory page, one bucket)
+    ExtendibleHash(BufferPoolManager* bpm, KeyWidth width) : bpm_(bpm), width_(width.bytes) {
+        if (width_ == 0 || width_ > MAX_KEY_WIDTH) throw std::runtime_error("hash key width out of range");
+        set_limits();
+        header_ = allocate(header_page_id_);
+        put<uint32_t>(header_->data() + WIDTH_POS, static_cast<uint32_t>(width_));
+        uint32_t dir_id;
+        allocate(dir_id);
+        bpm_->unpin_page(dir_id, true);
+        put<uint32_t>(header_->data() + DIRS_POS, dir_id);
+        set_slot(0, new_bucket(0));                  // global depth 0: one slot
+    }
+
+    // Opens a table previously created on the same file
+    ExtendibleHash(BufferPoolManager* bpm, uint32_t header_page_id)
+        : bpm_(bpm), header_page_id_(header_page_id) {
+        header_ = fetch(header_page_id_);
+        width_ = get<uint32_t>(header_->data() + WIDTH_POS);
+        if (width_ == 0 || width_ > MAX_KEY_WIDTH || global_depth() > MAX_DEPTH) {
+            bpm_->unpin_page(header_page_id_, false);
+            throw std::runtime_error("hash header page is corrupt");
+        }
+        set_limits();
+        for (size_t p = 0; p * SLOTS_PER_PAGE <= mask(); ++p) {
+            uint32_t dir_id = directory_page(p * SLOTS_PER_PAGE);
+            Page* dir = fetch(dir_id);
+            for (size_t i = 0; i < std::min(SLOTS_PER_PAGE, mask() + 1); ++i)
+                mirror(p * SLOTS_PER_PAGE + i).store(get<uint32_t>(dir->data() + slot_pos(i)), std::memory_order_relaxed);
+            bpm_->unpin_page(dir_id, false);
+        }
+    }
+
+    ~ExtendibleHash() { bpm_->unpin_page(header_page_id_, false); }
+
+    ExtendibleHash(const ExtendibleHash&) = delete;
+    ExtendibleHash& operator=(const ExtendibleHash&) = delete;
+
+    uint32_t header_page() const { return header_page_id_; }
+    size_t key_width() const { return width_; }
+    size_t global_depth() const { return get<uint32_t>(header_->data() + DEPTH_POS); }
+
+    /* ================= PUBLIC API ================ */
+    // Keys shorter than key_width() are padded with '\0'
+
+    /// returns false if the key already has this value
+    bool insert(const std::string& raw_key, const ValueT& value) {
+        const std::string key = normalize(raw_key);
+        const uint64_t h = hash(key.data());
+        for (;;) {
+            header_->r_latch();
+            uint32_t head_id = slot_page(h & mask());
+            Page* head = fetch(head_id);
+            head->w_latch();
+
+            uint32_t room_id = INVALID_PAGE;
+            bool dup = false;
+            for (uint32_t id = head_id; id != INVALID_PAGE && !dup;) {
+                Page* page = id == head_id ? head : fetch(id);
+                size_t n = count(page);
+                dup = find_entry(page, n, key.data(), tag_of(h), value) < n;
+                if (room_id == INVALID_PAGE && n < bucket_max_) room_id = id;
+                uint32_t next = get<uint32_t>(page->data() + NEXT_POS);
+                if (page != head) bpm_->unpin_page(id, false);
+                id = next;
+            }
+            bool added = !dup && room_id != INVALID_PAGE;
+            if (added) {
+                Page* page = room_id == head_id ? head : fetch(room_id);
+                size_t n = count(page);
+                write_entry(page, n, key.data(), tag_of(h), value);
+                put<uint16_t>(page->data() + COUNT_POS, static_cast<uint16_t>(n + 1));
+                if (page != head) bpm_->unpin_page(room_id, true);
+            }
+            head->w_unlatch();
+            bpm_->unpin_page(head_id, added && room_id == head_id);
+            header_->r_unlatch();
+            if (dup) return false;
+            if (added) return true;
+
+            // Bucket full: split it (or chain an overflow page) and retry
+            header_->w_latch();
+            make_room(h);
+            header_->w_unlatch();
+        }
+    }
+
+    // Every value stored under the key, in no particular order
+    std::vector<ValueT> find(const std::string& raw_key) const {
+        const std::string key = normalize(raw_key);
+        const uint64_t h = hash(key.data());
+        std::vector<ValueT> out;
+        while (!try_find(key, h, out)) std::this_thread::yield();
+        return out;
+    }
+
+    /// returns false if the key does not have this value
+    bool remove(const std::string& raw_key, const ValueT& value) {
+        const std::string key = normalize(raw_key);
+        const uint64_t h = hash(key.data());
+        header_->r_latch();
+        uint32_t head_id = slot_page(h & mask());
+        Page* head = fetch(head_id);
+        head->w_latch();
+        bool found = false, head_dirty = false;
+        for (uint32_t id = head_id; id != INVALID_PAGE && !found;) {
+            Page* page = id == head_id ? head : fetch(id);
+            size_t n = count(page);
+            size_t pos = find_entry(page, n, key.data(), tag_of(h), value);
+            found = pos < n;
+            if (found) {                             // the last entry fills the hole
+                tags(page)[pos] = tags(page)[n - 1];
+                std::memmove(entry(page, pos), entry(page, n - 1), entry_size_);
+                put<uint16_t>(page->data() + COUNT_POS, static_cast<uint16_t>(n - 1));
+            }
+            uint32_t next = get<uint32_t>(page->data() + NEXT_POS);
+            if (page != head) bpm_->unpin_page(id, found);
+            else head_dirty = found;
+            id = next;
+        }
+        head->w_unlatch();
+        bpm_->unpin_page(head_id, head_dirty);
+        header_->r_unlatch();
+        return found;
+    }
+
+private:
+    /* ================= HELPERS =================== */
+    template <typename T>
+    static T get(const std::byte* p) { T v; std::memcpy(&v, p, sizeof(T)); return v; }
+    template <typename T>
+    static void put(std::byte* p, T v) { std::memcpy(p, &v, sizeof(T)); }
+
+    // Most entries a bucket page holds, with their tags ahead of them
+    void set_limits() {
+        entry_size_ = width_ + sizeof(ValueT);
+        size_t n = (Page::PAGE_SIZE - TAGS_POS) / (entry_size_ + 1);
+        while (TAGS_POS + align_up(n, TAG_BLOCK) + n * entry_size_ > Page::PAGE_SIZE) --n;
+        bucket_max_ = n;
+        entries_pos_ = TAGS_POS + align_up(n, TAG_BLOCK);
+    }
+
+    std::string normalize(const std::string& key) const {
+        if (key.size() > width_) throw std::runtime_error("hash key longer than the key width");
+        std::string k = key;
+        k.resize(width_, '\0');
+        return k;
+    }
+
+    // 64-bit mix of the key bytes, 8 at a time (splitmix64 finalizer)
+    uint64_t hash(const char* key) const {
+        auto mix = [](uint64_t x) {
+            x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ULL;
+            x ^= x >> 27; x *= 0x94d049bb133111ebULL;
+            return x ^ (x >> 31);
+        };
+        uint64_t h = 0x9e3779b97f4a7c15ULL ^ width_;
+        size_t i = 0;
+        for (; i + 8 <= width_; i += 8) {
+            uint64_t w;
+            std::memcpy(&w, key + i, 8);
+            h = mix(h ^ w);
+        }
+        if (i < width_) {
+            uint64_t w = 0;
+            std::memcpy(&w, key + i, width_ - i);
+            h = mix(h ^ w);
+        }
+        return h;
+    }
+    // The slot comes from the low bits, the tag from the top byte
+    static uint8_t tag_of(uint64_t h) { return static_cast<uint8_t>(h >> 56); }
+
+    Page* fetch(uint32_t page_id) const {
+        Page* page = bpm_->fetch_page(page_id);
+        if (!page) throw std::runtime_error("Failed to fetch hash page");
+        return page;
+    }
+
+    // A zeroed new page, pinned
+    Page* allocate(uint32_t& page_id) {
+        Page* page = bpm_->new_page(page_id);
+        if (!page) throw std::runtime_error("Failed to allocate hash page");
+        std::memset(page->data() + Page::HEADER_SIZE, 0, Page::PAGE_SIZE - Page::HEADER_SIZE);
+        return page;
+    }
+
+    uint32_t new_bucket(size_t local_depth) {
+        uint32_t id;
+        Page* page = allocate(id);
+        put<uint16_t>(page->data() + LOCAL_DEPTH_POS, static_cast<uint16_t>(local_depth));
+        put<uint32_t>(page->data() + NEXT_POS, INVALID_PAGE);
+        bpm_->unpin_page(id, true);
+        return id;
+    }
+
+    /* --- directory (callers hold the header latch) --- */
+    size_t mask() const { return (size_t(1) << global_depth()) - 1; }
+    uint32_t directory_page(size_t slot) const {
+        return get<uint32_t>(header_->data() + DIRS_POS + (slot >> SLOT_BITS) * 4);
+    }
+    static size_t slot_pos(size_t slot) { return SLOTS_POS + (slot & (SLOTS_PER_PAGE - 1)) * 4; }
+
+    // The in-memory copy of a slot; its block of SLOTS_PER_PAGE is made on
+    // first use and kept until the table is closed
+    std::atomic<uint32_t>& mirror(size_t slot) {
+        auto& block = mirror_[slot >> SLOT_BITS];
+        if (!block.load()) {
+            mirror_blocks_[slot >> SLOT_BITS] = std::make_unique<std::atomic<uint32_t>[]>(SLOTS_PER_PAGE);
+            block.store(mirror_blocks_[slot >> SLOT_BITS].get());
+        }
+        return block.load()[slot & (SLOTS_PER_PAGE - 1)];
+    }
+    uint32_t slot_page(size_t slot) const {
+        return mirror_[slot >> SLOT_BITS].load()[slot & (SLOTS_PER_PAGE - 1)].load(std::memory_order_relaxed);
+    }
+    // Header latched exclusively (or the table not yet shared)
+    void set_slot(size_t slot, uint32_t page_id) {
+        mirror(slot).store(page_id, std::memory_order_relaxed);
+        uint32_t dir_id = directory_page(slot);
+        Page* dir = fetch(dir_id);
+        put<uint32_t>(dir->data() + slot_pos(slot), page_id);
+        bpm_->unpin_page(dir_id, true);
+    }
+
+    // Double the directory: slot i + 2^global_depth starts as a copy of slot i
+    void grow() {
+        size_t half = mask() + 1;
+        for (size_t i = 0; i < half; ++i) mirror(half + i).store(slot_page(i), std::memory_order_relaxed);
+        if (half < SLOTS_PER_PAGE) {
+            uint32_t dir_id = directory_page(0);
+            Page* dir = fetch(dir_id);
+            std::memcpy(dir->data() + SLOTS_POS + half * 4, dir->data() + SLOTS_POS, half * 4);
+            bpm_->unpin_page(dir_id, true);
+        } else {
+            for (size_t p = 0; p < half / SLOTS_PER_PAGE; ++p) {
+                uint32_t from_id = directory_page(p * SLOTS_PER_PAGE), to_id;
+                Page* to = allocate(to_id);
+                Page* from = fetch(from_id);
+                std::memcpy(to->data() + SLOTS_POS, from->data() + SLOTS_POS, SLOTS_PER_PAGE * 4);
+                bpm_->unpin_page(from_id, false);
+                bpm_->unpin_page(to_id, true);
+                put<uint32_t>(header_->data() + DIRS_POS + (half / SLOTS_PER_PAGE + p) * 4, to_id);
+            }
+        }
+        put<uint32_t>(header_->data() + DEPTH_POS, static_cast<uint32_t>(global_depth() + 1));
+        // The header stays pinned; fetch/unpin just marks it dirty
+        fetch(header_page_id_);
+        bpm_->unpin_page(header_page_id_, true);
+    }
+
+    /* --- buckets --- */
+    static size_t count(const Page* page) { return get<uint16_t>(page->data() + COUNT_POS); }
+    static uint8_t* tags(Page* page) { return reinterpret_cast<uint8_t*>(page->data() + TAGS_POS); }
+    static const uint8_t* tags(const Page* page) { return reinterpret_cast<const uint8_t*>(page->data() + TAGS_POS); }
+    std::byte* entry(Page* page, size_t i) const { return page->data() + entries_pos_ + i * entry_size_; }
+    const std::byte* entry(const Page* page, size_t i) const { return page->data() + entries_pos_ + i * entry_size_; }
+
+    // Calls f(i) for each of the first n entries tagged `tag` until f
+    // returns true; returns that i, or n
+    template <typename F>
+    size_t for_tag(const Page* page, size_t n, uint8_t tag, F f) const {
+        const uint8_t* t = tags(page);
+        for (size_t base = 0; base < n; base += TAG_BLOCK) {
+            uint32_t m = simd::match_bytes32(t + base, tag);
+            if (n - base < TAG_BLOCK) m &= (uint32_t(1) << (n - base)) - 1;
+            for (; m; m &= m - 1) {
+                size_t i = base + std::countr_zero(m);
+                if (f(i)) return i;
+            }
+        }
+        return n;
+    }
+
+    // Position of (key, value) among the first n entries, or n
+    size_t find_entry(const Page* page, size_t n, const char* key, uint8_t tag, const ValueT& value) const {
+        return for_tag(page, n, tag, [&](size_t i) {
+            const std::byte* e = entry(page, i);
+            if (std::memcmp(e, key, width_) != 0) return false;
+            ValueT v;
+            std::memcpy(&v, e + width_, sizeof(ValueT));
+            return v == value;
+        });
+    }
+
+    void write_entry(Page* page, size_t i, const char* key, uint8_t tag, const ValueT& value) {
+        tags(page)[i] = tag;
+        std::byte* e = entry(page, i);
+        std::memcpy(e, key, width_);
+        std::memcpy(e + width_, &value, sizeof(ValueT));
+    }
+
+    // One latch-free lookup; false if a writer got in the way. Page ids
+    // are only followed once the versions they were read under check out.
+    bool try_find(const std::string& key, uint64_t h, std::vector<ValueT>& out) const {
+        out.clear();
+        uint64_t hv = header_->version();
+        if (hv & 1) return false;
+        size_t slot = h & mask();
+        const std::atomic<uint32_t>* block = slot < SLOTS_PER_PAGE * DIR_PAGES ? mirror_[slot >> SLOT_BITS].load() : nullptr;
+        uint32_t head_id = block ? block[slot & (SLOTS_PER_PAGE - 1)].load(std::memory_order_relaxed) : INVALID_PAGE;
+        if (!header_->validate(hv) || head_id == INVALID_PAGE) return false;
+
+        Page* head = fetch(head_id);
+        uint64_t bv = head->version();
+        bool ok = !(bv & 1);
+        for (uint32_t id = head_id; ok && id != INVALID_PAGE;) {
+            Page* page = id == head_id ? head : fetch(id);
+            size_t n = std::min(count(page), bucket_max_);
+            for_tag(page, n, tag_of(h), [&](size_t i) {
+                const std::byte* e = entry(page, i);
+                if (std::memcmp(e, key.data(), width_) == 0) {
+                    ValueT v;
+                    std::memcpy(&v, e + width_, sizeof(ValueT));
+                    out.push_back(v);
+                }
+                return false;
+            });
+            uint32_t next = get<uint32_t>(page->data() + NEXT_POS);
+            if (page != head) bpm_->unpin_page(id, false);
+            ok = head->validate(bv) && header_->validate(hv);
+            id = next;
+        }
+        bpm_->unpin_page(head_id, false);
+        return ok;
+    }
+
+    // The entries of a bucket's whole chain, back to back, and its length
+    std::vector<std::byte> read_chain(uint32_t head_id, size_t& pages) const {
+        std::vector<std::byte> out;
+        pages = 0;
+        for (uint32_t id = head_id; id != INVALID_PAGE; ++pages) {
+            Page* page = fetch(id);
+            const std::byte* first = entry(page, 0);
+            out.insert(out.end(), first, first + count(page) * entry_size_);
+            uint32_t next = get<uint32_t>(page->data() + NEXT_POS);
+            bpm_->unpin_page(id, false);
+            id = next;
+        }
+        return out;
+    }
+
+    // Lay entries over the chain from head_id, adding overflow pages when
+    // they run out; pages past the last entry are left empty in the chain
+    void write_chain(uint32_t head_id, const std::vector<std::byte>& entries) {
+        size_t total = entries.size() / entry_size_, done = 0;
+        for (uint32_t id = head_id; id != INVALID_PAGE;) {
+            Page* page = fetch(id);
+            size_t n = std::min(bucket_max_, total - done);
+            for (size_t i = 0; i < n; ++i) {
+                const std::byte* e = entries.data() + (done + i) * entry_size_;
+                tags(page)[i] = tag_of(hash(reinterpret_cast<const char*>(e)));
+                std::memcpy(entry(page, i), e, entry_size_);
+            }
+            put<uint16_t>(page->data() + COUNT_POS, static_cast<uint16_t>(n));
+            done += n;
+            uint32_t next = get<uint32_t>(page->data() + NEXT_POS);
+            if (next == INVALID_PAGE && done < total) {
+                next = new_bucket(0);
+                put<uint32_t>(page->data() + NEXT_POS, next);
+            }
+            bpm_->unpin_page(id, true);
+            id = next;
+        }
+    }
+
+    // Under the exclusive header latch: the bucket for hash h has no free
+    // entry (unless a remove made one since). Split it on its next bit
+    // while that can still separate most of its entries from the new
+    // key's; a bucket mostly full of one key gets an overflow page, or the
+    // directory would double until that key had a bucket of its own.
+    void make_room(uint64_t h) {
+        uint32_t head_id = slot_page(h & mask());
+        Page* head = fetch(head_id);
+        size_t depth = get<uint16_t>(head->data() + LOCAL_DEPTH_POS);
+        bpm_->unpin_page(head_id, false);
+        size_t pages;
+        std::vector<std::byte> entries = read_chain(head_id, pages);
+        size_t n = entries.size() / entry_size_;
+        if (n < pages * bucket_max_) return;
+
+        // Only hash bits depth..MAX_DEPTH-1 can still tell entries apart
+        const uint64_t split_bits = ((uint64_t(1) << MAX_DEPTH) - 1) & ~((uint64_t(1) << depth) - 1);
+        size_t others = 0;
+        for (size_t i = 0; i < n; ++i)
+            others += ((hash(reinterpret_cast<const char*>(entries.data() + i * entry_size_)) ^ h) & split_bits) != 0;
+
+        if (others * 2 <= n) {                       // new page right after the head
+            uint32_t id = new_bucket(0);
+            head = fetch(head_id);
+            Page* page = fetch(id);
+            put<uint32_t>(page->data() + NEXT_POS, get<uint32_t>(head->data() + NEXT_POS));
+            put<uint32_t>(head->data() + NEXT_POS, id);
+            bpm_->unpin_page(id, true);
+            bpm_->unpin_page(head_id, true);
+            return;
+        }
+
+        if (depth == global_depth()) grow();
+
+        // Entries with hash bit `depth` set move to the new bucket
+        uint32_t sibling_id = new_bucket(depth + 1);
+        std::vector<std::byte> stay, move;
+        for (size_t i = 0; i < n; ++i) {
+            const std::byte* e = entries.data() + i * entry_size_;
+            auto& to = (hash(reinterpret_cast<const char*>(e)) >> depth) & 1 ? move : stay;
+            to.insert(to.end(), e, e + entry_size_);
+        }
+        head = fetch(head_id);
+        put<uint16_t>(head->data() + LOCAL_DEPTH_POS, static_cast<uint16_t>(depth + 1));
+        bpm_->unpin_page(head_id, true);
+        write_chain(head_id, stay);
+        write_chain(sibling_id, move);
+
+        // The slots that shared the bucket: every 2^depth-th from its lowest
+        for (size_t i = h & ((size_t(1) << depth) - 1); i <= mask(); i += size_t(1) << depth)
+            if ((i >> depth) & 1) set_slot(i, sibling_id);
+    }
+
+    BufferPoolManager* bpm_;
+    uint32_t           header_page_id_ = INVALID_PAGE;
+    Page*              header_ = nullptr;
+    // Directory mirror: blocks are published through mirror_ before the
+    // global depth that reaches them, so a reader never sees a missing one
+    std::array<std::atomic<std::atomic<uint32_t>*>, DIR_PAGES> mirror_{};
+    std::array<std::unique_ptr<std::atomic<uint32_t>[]>, DIR_PAGES> mirror_blocks_;
+    size_t             width_;
+    size_t             entry_size_ = 0;
+    size_t             bucket_max_ = 0;
+    size_t             entries_pos_ = 0;
+};
@@ -0,0 +1,215 @@
+#include "free_space_map.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+static void init_fsm_page(Page* page) {
+    std::byte* raw = page->data();
+    std::memset(raw + Page::HEADER_SIZE, 0, Page::PAGE_SIZE - Page::HEADER_SIZE);
+    uint32_t next = FreeSpaceMap::INVALID_PAGE;
+    std::memcpy(raw + Page::HEADER_SIZE, &next, sizeof(next));
+}
+
+FreeSpaceMap::FreeSpaceMap(BufferPoolManager* bpm)
+    : bpm_(bpm) {
+    Page* page = bpm_->new_page(root_page_id_);
+    if (!page) throw std::runtime_error("Failed to allocate free-space map page");
+    init_fsm_page(page);
+    bpm_->unpin_page(root_page_id_, true);
+
+    fsm_pages_.push_back(root_page_id_);
+    max_bucket_.push_back(0);
+}
+
+FreeSpaceMap::FreeSpaceMap(BufferPoolManager* bpm, uint32_t root_page_id, bool clear)
+    : bpm_(bpm), root_page_id_(root_page_id) {
+    bool seeking = !clear;                       // for the first page with room
+    for (uint32_t fsm_id = root_page_id; fsm_id != INVALID_PAGE;) {
+        Page* page = bpm_->fetch_page(fsm_id);
+        if (!page) throw std::runtime_error("FSM fetch failed");
+        std::byte* raw = page->data();
+        uint16_t count = *reinterpret_cast<const uint16_t*>(raw + HDR_COUNT);
+        uint32_t next;
+        std::memcpy(&next, raw + HDR_NEXT, sizeof(next));
+        // Chain pages are allocated in order, so a link only points forward
+        // to a page the file has; anything else was never written
+        bool linked = next == INVALID_PAGE || (next > fsm_id && next < bpm_->next_page_id());
+        if (clear) {
+            if (!linked) next = INVALID_PAGE;
+            init_fsm_page(page);
+            std::memcpy(raw + HDR_NEXT, &next, sizeof(next));
+            bpm_->unpin_page(fsm_id, true);
+            fsm_pages_.push_back(fsm_id);
+            max_bucket_.push_back(0);
+            fsm_id = next;
+            continue;
+        }
+        if (count > CAPACITY || !linked) {
+            bpm_->unpin_page(fsm_id, false);
+            throw std::runtime_error("free-space map page is corrupt");
+        }
+        const uint8_t* buckets = reinterpret_cast<const uint8_t*>(raw + BUCKETS);
+        if (seeking && count < CAPACITY) {
+            tail_ = fsm_pages_.size();
+            seeking = false;
+        }
+        fsm_pages_.push_back(fsm_id);
+        max_bucket_.push_back(count ? *std::max_element(buckets, buckets + count) : 0);
+        bpm_->unpin_page(fsm_id, false);
+        fsm_id = next;
+    }
+    // Pages fill in chain order; when all are full the last one chains more
+    if (seeking) tail_ = fsm_pages_.size() - 1;
+}
+
+std::vector<uint32_t> FreeSpaceMap::heap_pages() {
+    std::vector<uint32_t> ids;
+    for (uint32_t fsm_id : fsm_pages_) {
+        Page* page = bpm_->fetch_page(fsm_id);
+        if (!page) throw std::runtime_error("FSM fetch failed");
+        const std::byte* raw = page->data();
+        uint16_t count = *reinterpret_cast<const uint16_t*>(raw + HDR_COUNT);
+        const uint32_t* entries = reinterpret_cast<const uint32_t*>(raw + ENTRIES);
+        ids.insert(ids.end(), entries, entries + count);
+        bpm_->unpin_page(fsm_id, false);
+    }
+    return ids;
+}
+
+uint8_t FreeSpaceMap::to_bucket(size_t free_bytes) {
+    return static_cast<uint8_t>(std::min<size_t>(free_bytes / BUCKET_BYTES, UINT8_MAX));
+}
+
+void FreeSpaceMap::add_page(uint32_t heap_page_id, size_t free_bytes) {
+    size_t fsm_idx = tail_;
+    uint32_t fsm_id = fsm_pages_[fsm_idx];
+    Page* page = bpm_->fetch_page(fsm_id);
+    if (!page) throw std::runtime_error("FSM fetch failed");
+
+    page->w_latch();
+    uint16_t* count_ptr = reinterpret_cast<uint16_t*>(page->data() + HDR_COUNT);
+    if (*count_ptr == CAPACITY) {
+        // Current FSM page is full: go on to the next one in the chain
+        // (left over from a cleared map) or chain a new one behind it
+        uint32_t new_id;
+        Page* fresh;
+        if (fsm_idx + 1 < fsm_pages_.size()) {
+            new_id = fsm_pages_[fsm_idx + 1];
+            fresh = bpm_->fetch_page(new_id);
+        }
+        else {
+            fresh = bpm_->new_page(new_id);
+            if (fresh) {
+                init_fsm_page(fresh);
+                fsm_pages_.push_back(new_id);
+                max_bucket_.push_back(0);
+            }
+        }
+        if (!fresh) {
+            page->w_unlatch();
+            bpm_->unpin_page(fsm_id, false);
+            throw std::runtime_error("Failed to allocate free-space map page");
+        }
+        std::memcpy(page->data() + HDR_NEXT, &new_id, sizeof(new_id));
+        page->w_unlatch();
+        bpm_->unpin_page(fsm_id, true);
+
+        tail_ = ++fsm_idx;
+        fsm_id = new_id;
+        page = fresh;
+        page->w_latch();
+        count_ptr = reinterpret_cast<uint16_t*>(page->data() + HDR_COUNT);
+    }
+
+    uint16_t slot = (*count_ptr)++;
+    std::memcpy(page->data() + ENTRIES + slot * sizeof(uint32_t), &heap_page_id, sizeof(uint32_t));
+    page->w_unlatch();
+    bpm_->unpin_page(fsm_id, true);
+
+    hint_page_ = heap_page_id;
+    hint_fsm_ = fsm_idx;
+    hint_slot_ = slot;
+    set_bucket(fsm_idx, slot, to_bucket(free_bytes));
+}
+
+void FreeSpaceMap::update(uint32_t heap_page_id, size_t free_bytes) {
+    if (heap_page_id == hint_page_) {
+        set_bucket(hint_fsm_, hint_slot_, to_bucket(free_bytes));
+        return;
+    }
+
+    // Slow path: locate the entry by walking the FSM pages
+    for (size_t i = 0; i < fsm_pages_.size(); ++i) {
+        Page* page = bpm_->fetch_page(fsm_pages_[i]);
+        if (!page) throw std::runtime_error("FSM fetch failed");
+        const std::byte* raw = page->data();
+        uint16_t count = *reinterpret_cast<const uint16_t*>(raw + HDR_COUNT);
+        const uint32_t* ids = reinterpret_cast<const uint32_t*>(raw + ENTRIES);
+        const uint32_t* hit = std::find(ids, ids + count, heap_page_id);
+        bpm_->unpin_page(fsm_pages_[i], false);
+
+        if (hit != ids + count) {
+            hint_page_ = heap_page_id;
+            hint_fsm_ = i;
+            hint_slot_ = static_cast<uint16_t>(hit - ids);
+            set_bucket(i, hint_slot_, to_bucket(free_bytes));
+            return;
+        }
+    }
+    throw std::runtime_error("page not tracked by free-space map");
+}
+
+uint32_t FreeSpaceMap::find_page(size_t needed) {
+    // Round up so that any page in the bucket is guaranteed to fit
+    size_t want = (needed + BUCKET_BYTES - 1) / BUCKET_BYTES;
+    if (want > UINT8_MAX) return INVALID_PAGE;
+
+    // Fast path: the page that served the previous insert (usually the tail)
+    if (hint_page_ != INVALID_PAGE && hint_bucket_ >= want) return hint_page_;
+
+    for (size_t i = 0; i < fsm_pages_.size(); ++i) {
+        if (max_bucket_[i] < want) continue;          // nothing big enough here
+
+        Page* page = bpm_->fetch_page(fsm_pages_[i]);
+        if (!page) throw std::runtime_error("FSM fetch failed");
+        const std::byte* raw = page->data();
+        const uint8_t* buckets = reinterpret_cast<const uint8_t*>(raw + BUCKETS);
+        uint16_t count = *reinterpret_cast<const uint16_t*>(raw + HDR_COUNT);
+        for (uint16_t s = 0; s < count; ++s) {
+            if (buckets[s] < want) continue;
+            uint32_t pid;
+            std::memcpy(&pid, raw + ENTRIES + s * sizeof(uint32_t), sizeof(pid));
+            hint_page_ = pid;
+            hint_fsm_ = i;
+            hint_slot_ = s;
+            hint_bucket_ = buckets[s];
+            bpm_->unpin_page(fsm_pages_[i], false);
+            return pid;
+        }
+        bpm_->unpin_page(fsm_pages_[i], false);
+    }
+    return INVALID_PAGE;
+}
+
+void FreeSpaceMap::set_bucket(size_t fsm_idx, uint16_t slot, uint8_t bucket) {
+    uint32_t fsm_id = fsm_pages_[fsm_idx];
+    Page* page = bpm_->fetch_page(fsm_id);
+    if (!page) throw std::runtime_error("FSM fetch failed");
+    page->w_latch();
+    std::byte* raw = page->data();
+    uint8_t* buckets = reinterpret_cast<uint8_t*>(raw + BUCKETS);
+    uint8_t old = buckets[slot];
+    buckets[slot] = bucket;
+    if (fsm_idx == hint_fsm_ && slot == hint_slot_) hint_bucket_ = bucket;
+
+    if (bucket >= max_bucket_[fsm_idx]) {
+        max_bucket_[fsm_idx] = bucket;
+    }
+    else if (old == max_bucket_[fsm_idx]) {
+        // The previous maximum shrank: recompute it for this FSM page
+        uint16_t count = *reinterpret_cast<const uint16_t*>(raw + HDR_COUNT);
+        max_bucket_[fsm_idx] = count ? *std::max_element(buckets, buckets + count) : 0;
+    }
+    page->w_unlatch();
+    bpm_->unpin_page(fsm_id, old != bucket);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "buffer_pool_manager.hpp"
+#include <vector>
+#include <cstdint>
+
+/*
+ * Free-space map for one TableHeap.
+ *
+ * Every heap page gets a one-byte bucket (free bytes / BUCKET_BYTES) that
+ * lives in a chain of FSM pages owned by the buffer pool.  Each FSM page
+ * stores the heap page ids next to their buckets:
+ *
+ *   [Page header 8][next_fsm u32][count u16][pad u16][page_id u32 * CAP][bucket u8 * CAP]
+ *
+ * A small in-memory summary (largest bucket per FSM page) plus a hint for the
+ * page that served the last insert keep lookups O(1) in the common case.
+ */
+class FreeSpaceMap {
+public:
+    static constexpr size_t BUCKET_BYTES = 16;
+    static constexpr uint32_t INVALID_PAGE = UINT32_MAX;
+
+    // Creates an empty map rooted at a freshly allocated page
+    explicit FreeSpaceMap(BufferPoolManager* bpm);
+    // Opens the map rooted at root_page_id, reading each FSM page once.
+    // With clear the chain's pages are emptied instead and refilled by
+    // add_page before it allocates any more: for a heap whose map may be
+    // stale (after a crash) and that registers its pages again
+    FreeSpaceMap(BufferPoolManager* bpm, uint32_t root_page_id, bool clear = false);
+
+    uint32_t root_page() const { return root_page_id_; }
+
+    // Every registered heap page id, in the order they were added
+    std::vector<uint32_t> heap_pages();
+
+    // Register a new heap page with its current free space
+    void add_page(uint32_t heap_page_id, size_t free_bytes);
+
+    // Record the new free space of an already registered heap page
+    void update(uint32_t heap_page_id, size_t free_bytes);
+
+    // Find a heap page with at least `needed` free bytes (INVALID_PAGE if none)
+    uint32_t find_page(size_t needed);
+
+private:
+    static constexpr size_t HDR_NEXT = Page::HEADER_SIZE;        // u32
+    static constexpr size_t HDR_COUNT = Page::HEADER_SIZE + 4;   // u16
+    static constexpr size_t ENTRIES = Page::HEADER_SIZE + 8;
+    static constexpr size_t CAPACITY = (Page::PAGE_SIZE - ENTRIES) / (sizeof(uint32_t) + 1);
+    static constexpr size_t BUCKETS = ENTRIES + CAPACITY * sizeof(uint32_t);
+
+    static uint8_t to_bucket(size_t free_bytes);
+
+    // Set bucket at (fsm page index, slot) and refresh the summary
+    void set_bucket(size_t fsm_idx, uint16_t slot, uint8_t bucket);
+
+    BufferPoolManager*    bpm_;
+    uint32_t              root_page_id_;
+    std::vector<uint32_t> fsm_pages_;     // FSM chain in order
+    std::vector<uint8_t>  max_bucket_;    // summary per FSM page
+    size_t                tail_ = 0;      // FSM page add_page fills
+
+    // Entry that satisfied the last lookup / registration
+    uint32_t hint_page_ = INVALID_PAGE;
+    size_t   hint_fsm_ = 0;
+    uint16_t hint_slot_ = 0;
+    uint8_t  hint_bucket_ = 0;
+};
@@ -0,0 +1,293 @@
+/************************  storage/index.hpp  ***********************
+ * A table's indexes as the catalog and executor see them: each maps the
+ * values of one column to the RIDs of the rows holding them.
+ *
+ * PrimaryIndex: the first column when it is INT, a unique
+ * BPlusTree<int, RID>; a second row with the same key is refused.
+ *
+ * SecondaryIndex (CREATE INDEX): any column, duplicates allowed. It is a
+ * byte-key BPlusTree whose key is the value in an order-preserving
+ * encoding followed by the row's RID:
+ *
+ *   INT      4 bytes big-endian, sign bit flipped
+ *   CHAR(n)  n bytes, '\0'-padded as in the tuple
+ *   RID      page id (4) + slot (2), big-endian
+ *
+ * so memcmp order is value order, rows sharing a value are distinct
+ * entries next to each other, and an equality or range predicate is one
+ * key-range scan. Runs of equal values compress well in the tree's
+ * prefix-compressed nodes.
+ *
+ * HashIndex (CREATE INDEX ... USING HASH): any column, duplicates
+ * allowed, equality only. An ExtendibleHash from the same value encoding
+ * to the RIDs, so a point lookup reads one bucket rather than a path of
+ * tree nodes. It is not ordered(): the executor never gives it a range.
+ *****************************************************************/
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "parser/query.hpp"
+#include "storage/bplus_tree.hpp"
+#include "storage/extendible_hash.hpp"
+#include "storage/rid.hpp"
+
+class Index {
+public:
+    Index(std::string name, size_t column) : name_(std::move(name)), column_(column) {}
+    virtual ~Index() = default;
+
+    const std::string& name() const { return name_; }
+    size_t column() const { return column_; }     // position in the schema
+    virtual bool unique() const = 0;
+    // false: scan() answers only equality (lo == hi, both inclusive)
+    virtual bool ordered() const { return true; }
+    // The page the index is reopened from (tree meta page, hash header)
+    virtual uint32_t root_page() const = 0;
+
+    // value is the column's literal, as Schema::serialize takes it.
+    // insert returns false if a unique index already has the value
+    virtual bool insert(const std::string& value, const RID& rid) = 0;
+    virtual bool remove(const std::string& value, const RID& rid) = 0;
+
+    // RIDs of the rows whose value lies within the bounds, in value order
+    virtual std::vector<RID> scan(const Bounds& r) const = 0;
+
+    // Replace the contents with (value, rid) pairs in any order, loaded
+    // bottom-up; a unique index keeps the first pair for each value and
+    // returns the RIDs of the others
+    virtual std::vector<RID> build(std::vector<std::pair<std::string, RID>> rows, double fill_factor = 1.0) = 0;
+
+protected:
+    // Bytes a value of the column takes in an encoded key
+    static size_t value_width(const ColumnDef& col) { return col.type == ColumnType::INT ? sizeof(int) : col.len; }
+
+    // The value as it orders in a key (CHAR values are cut to the column width)
+    static std::string encode(const ColumnDef& col, const std::string& value) {
+        if (col.type == ColumnType::INT) return encode_int(std::stoi(value));
+        std::string out(value_width(col), '\0');
+        std::memcpy(out.data(), value.data(), std::min(value.size(), out.size()));
+        return out;
+    }
+    static std::string encode_int(int32_t v) {
+        std::string out(sizeof(int32_t), '\0');
+        uint32_t u = static_cast<uint32_t>(v) ^ 0x80000000u;
+        for (size_t i = 0; i < 4; ++i) out[i] = static_cast<char>(u >> (24 - 8 * i));
+        return out;
+    }
+
+private:
+    std::string name_;
+    size_t      column_;
+};
+
+class PrimaryIndex : public Index {
+public:
+    using Tree = BPlusTree<int, RID>;
+
+    PrimaryIndex(BufferPoolManager* bpm, std::string name, size_t column)
+        : Index(std::move(name), column), bpm_(bpm), tree_(std::make_unique<Tree>(bpm)) {}
+    // Reopens the tree whose meta page is meta_page_id
+    PrimaryIndex(BufferPoolManager* bpm, std::string name, size_t column, uint32_t meta_page_id)
+        : Index(std::move(name), column), bpm_(bpm), tree_(std::make_unique<Tree>(bpm, meta_page_id)) {}
+
+    bool unique() const override { return true; }
+    uint32_t root_page() const override { return tree_->meta_page(); }
+
+    bool insert(const std::string& value, const RID& rid) override { return tree_->insert(std::stoi(value), rid); }
+
+    bool remove(const std::string& value, const RID& rid) override {
+        int key = std::stoi(value);
+        auto found = tree_->search(key);
+        return found && *found == rid && tree_->remove(key);
+    }
+
+    std::vector<RID> scan(const Bounds& r) const override {
+        // Closed int bounds; a strict bound moves one step inwards (bound_int
+        // keeps a literal past the int range from overflowing the step)
+        long long lo = r.lo ? std::max<long long>(bound_int(*r.lo) + !r.lo_incl, INT_MIN) : INT_MIN;
+        long long hi = r.hi ? std::min<long long>(bound_int(*r.hi) - !r.hi_incl, INT_MAX) : INT_MAX;
+        std::vector<RID> rids;
+        if (lo > hi) return rids;
+        for (auto it = tree_->lower_bound(static_cast<int>(lo)); it.valid() && it.key() <= hi; ++it)
+            rids.push_back(it.value());
+        return rids;
+    }
+
+    std::vector<RID> build(std::vector<std::pair<std::string, RID>> rows, double fill_factor) override {
+        std::vector<std::pair<int, RID>> entries;
+        entries.reserve(rows.size());
+        for (auto& [v, rid] : rows) entries.emplace_back(std::stoi(v), rid);
+        std::stable_sort(entries.begin(), entries.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; });
+        std::vector<RID> dropped;
+        size_t kept = 0;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (kept && entries[i].first == entries[kept - 1].first) dropped.push_back(entries[i].second);
+            else entries[kept++] = entries[i];
+        }
+        entries.resize(kept);
+
+        auto tree = std::make_unique<Tree>(bpm_);
+        tree->bulk_load(entries.begin(), entries.end(), fill_factor);
+        tree_ = std::move(tree);
+        return dropped;
+    }
+
+private:
+    BufferPoolManager*    bpm_;
+    std::unique_ptr<Tree> tree_;
+};
+
+class SecondaryIndex : public Index {
+public:
+    using Tree = BPlusTree<std::string, RID>;
+
+    SecondaryIndex(BufferPoolManager* bpm, std::string name, size_t column, const ColumnDef& col)
+        : Index(std::move(name), column), bpm_(bpm), col_(col),
+          value_len_(value_width(col)) {
+        if (value_len_ == 0 || value_len_ + RID_LEN > Tree::MAX_KEY_WIDTH)
+            throw std::runtime_error("column " + col.name + " cannot be indexed");
+        tree_ = std::make_unique<Tree>(bpm_, KeyWidth{ value_len_ + RID_LEN });
+    }
+    SecondaryIndex(BufferPoolManager* bpm, std::string name, size_t column, const ColumnDef& col, uint32_t meta_page_id)
+        : Index(std::move(name), column), bpm_(bpm), col_(col),
+          value_len_(value_width(col)), tree_(std::make_unique<Tree>(bpm, meta_page_id)) {}
+
+    bool unique() const override { return false; }
+    uint32_t root_page() const override { return tree_->meta_page(); }
+
+    bool insert(const std::string& value, const RID& rid) override { return tree_->insert(key(value, rid), rid); }
+    bool remove(const std::string& value, const RID& rid) override { return tree_->remove(key(value, rid)); }
+
+    std::vector<RID> scan(const Bounds& r) const override {
+        std::vector<RID> rids;
+        std::optional<std::string> lo, hi;
+        bool lo_incl = r.lo_incl, hi_incl = r.hi_incl;
+        if (r.lo && !bound(*r.lo, true, lo, lo_incl)) return rids;
+        if (r.hi && !bound(*r.hi, false, hi, hi_incl)) return rids;
+
+        // From the first entry of lo (or past its last), while the value is within hi
+        std::string start = lo ? *lo + std::string(RID_LEN, lo_incl ? '\0' : '\xff') : std::string();
+        for (auto it = tree_->lower_bound(start); it.valid(); ++it) {
+            if (hi) {
+                int c = std::memcmp(it.key().data(), hi->data(), value_len_);
+                if (c > 0 || (c == 0 && !hi_incl)) break;
+            }
+            rids.push_back(it.value());
+        }
+        return rids;
+    }
+
+    std::vector<RID> build(std::vector<std::pair<std::string, RID>> rows, double fill_factor) override {
+        std::vector<std::pair<std::string, RID>> entries;
+        entries.reserve(rows.size());
+        for (auto& [v, rid] : rows) entries.emplace_back(key(v, rid), rid);
+        std::sort(entries.begin(), entries.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        auto tree = std::make_unique<Tree>(bpm_, KeyWidth{ value_len_ + RID_LEN });
+        tree->bulk_load(entries.begin(), entries.end(), fill_factor);
+        tree_ = std::move(tree);
+        return {};
+    }
+
+private:
+    static constexpr size_t RID_LEN = 6;
+
+    std::string key(const std::string& value, const RID& rid) const {
+        std::string k = encode(col_, value);
+        uint32_t page = rid.page_id();
+        uint16_t slot = rid.slot_id();
+        for (int i = 3; i >= 0; --i) k.push_back(static_cast<char>(page >> (8 * i)));
+        k.push_back(static_cast<char>(slot >> 8));
+        k.push_back(static_cast<char>(slot));
+        return k;
+    }
+
+    // A bound in key space; false if no value can satisfy it. An INT bound
+    // past the int range leaves that side open, or matches nothing; a CHAR
+    // bound longer than the column compares like its cut prefix with the
+    // other inclusiveness
+    bool bound(const Param& value, bool is_lo, std::optional<std::string>& out, bool& incl) const {
+        if (col_.type == ColumnType::INT) {
+            long long v = bound_int(value);
+            if (v < INT_MIN || v > INT_MAX) return (v < INT_MIN) == is_lo;
+            out = encode_int(static_cast<int32_t>(v));
+            return true;
+        }
+        const std::string& text = std::get<std::string>(value);
+        if (text.size() > value_len_) incl = !is_lo;
+        out = encode(col_, text);
+        return true;
+    }
+
+    BufferPoolManager*    bpm_;
+    ColumnDef             col_;
+    size_t                value_len_;
+    std::unique_ptr<Tree> tree_;
+};
+
+class HashIndex : public Index {
+public:
+    using Table = ExtendibleHash<RID>;
+
+    HashIndex(BufferPoolManager* bpm, std::string name, size_t column, const ColumnDef& col)
+        : Index(std::move(name), column), bpm_(bpm), col_(col) {
+        if (value_width(col) == 0 || value_width(col) > Table::MAX_KEY_WIDTH)
+            throw std::runtime_error("column " + col.name + " cannot be indexed");
+        table_ = std::make_unique<Table>(bpm_, KeyWidth{ value_width(col) });
+    }
+    HashIndex(BufferPoolManager* bpm, std::string name, size_t column, const ColumnDef& col, uint32_t header_page_id)
+        : Index(std::move(name), column), bpm_(bpm), col_(col),
+          table_(std::make_unique<Table>(bpm, header_page_id)) {}
+
+    bool unique() const override { return false; }
+    bool ordered() const override { return false; }
+    uint32_t root_page() const override { return table_->header_page(); }
+
+    bool insert(const std::string& value, const RID& rid) override { return table_->insert(encode(col_, value), rid); }
+    bool remove(const std::string& value, const RID& rid) override { return table_->remove(encode(col_, value), rid); }
+
+    // Equality only; the rows come back in RID order, as from the other indexes
+    std::vector<RID> scan(const Bounds& r) const override {
+        if (!r.lo || !r.hi || *r.lo != *r.hi || !r.lo_incl || !r.hi_incl)
+            throw std::logic_error("hash index " + name() + " answers equality only");
+        std::vector<RID> rids;
+        // A value no row of the column can hold
+        std::string key;
+        if (col_.type == ColumnType::INT) {
+            long long v = bound_int(*r.lo);
+            if (v < INT_MIN || v > INT_MAX) return rids;
+            key = encode_int(static_cast<int32_t>(v));
+        } else {
+            const std::string& text = std::get<std::string>(*r.lo);
+            if (text.size() > col_.len) return rids;
+            key = encode(col_, text);
+        }
+        rids = table_->find(key);
+        std::sort(rids.begin(), rids.end(), [](const RID& a, const RID& b) {
+            return a.page_id() != b.page_id() ? a.page_id() < b.page_id() : a.slot_id() < b.slot_id();
+        });
+        return rids;
+    }
+
+    // One insert per row: a hash table has no bottom-up build and no fill factor
+    std::vector<RID> build(std::vector<std::pair<std::string, RID>> rows, double) override {
+        auto table = std::make_unique<Table>(bpm_, KeyWidth{ value_width(col_) });
+        for (auto& [v, rid] : rows) table->insert(encode(col_, v), rid);
+        table_ = std::move(table);
+        return {};
+    }
+
+private:
+    BufferPoolManager*     bpm_;
+    ColumnDef              col_;
+    std::unique_ptr<Table> table_;
+};
@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include "page.hpp"
+
+/* One page-sized read or write handed to an IOBackend */
+struct IORequest {
+    uint32_t          page_id = 0;
+    std::byte*        buffer = nullptr;   // PAGE_SIZE bytes; aligned for O_DIRECT
+    bool              write = false;
+    int               result = 0;         // bytes transferred or -errno
+    std::atomic<bool> done{ false };
+};
+
+/*
+ * Page I/O backend used by DiskManager.
+ *
+ * read_page/write_page are synchronous. submit() queues a batch that may
+ * complete asynchronously and in any order; wait() blocks until every
+ * request of the given batch is done. Reads past the end of the file yield
+ * zeros. Implementations are safe to call from several threads.
+ */
+class IOBackend {
+public:
+    virtual ~IOBackend() = default;
+
+    virtual void read_page(uint32_t page_id, std::byte* out_buffer) = 0;
+    virtual void write_page(uint32_t page_id, const std::byte* buffer) = 0;
+
+    // Default: run the batch synchronously, in order
+    virtual void submit(std::span<IORequest* const> batch) {
+        for (IORequest* r : batch) {
+            if (r->write) write_page(r->page_id, r->buffer);
+            else          read_page(r->page_id, r->buffer);
+            r->result = static_cast<int>(Page::PAGE_SIZE);
+            r->done.store(true, std::memory_order_release);
+        }
+    }
+
+    virtual void wait(std::span<IORequest* const> batch) {
+        for (IORequest* r : batch) while (!r->done.load(std::memory_order_acquire)) {}
+    }
+
+    // Make completed writes durable
+    virtual void sync() = 0;
+
+    // True if submit() returns before the I/O is done
+    virtual bool async() const { return false; }
+
+    // Reap finished asynchronous requests without blocking
+    virtual void poll() {}
+
+    // Hint that pages [page_id, page_id + count) will be read soon
+    virtual void advise(uint32_t /*page_id*/, size_t /*count*/) {}
+
+    virtual const char* name() const = 0;
+};
@@ -0,0 +1,5 @@
+#pragma once
+#include <cstddef>
+
+// Width in bytes of the keys of a byte-key index, fixed when it is created
+struct KeyWidth { size_t bytes; };
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <tuple>
+#include <vector>
+#include "replacer.hpp"
+
+/*
+ * LRU-K replacer (O'Neil et al.).
+ *
+ * Evicts the frame whose K-th most recent access lies furthest in the past.
+ * Frames with fewer than K recorded accesses have an infinite backward
+ * K-distance and go first, oldest first access first, so pages touched
+ * once by a scan leave before pages that are re-referenced.
+ */
+class LRUKReplacer : public Replacer {
+public:
+    explicit LRUKReplacer(size_t capacity, size_t k = 2)
+        : k_(k), history_(capacity * k), count_(capacity, 0), evictable_(capacity, false) {
+    }
+
+    void record_access(size_t frame_id, uint32_t) override {
+        std::lock_guard<std::mutex> lk(latch_);
+        bool was = evictable_[frame_id];
+        if (was) candidates_.erase(key(frame_id));
+
+        // Ring buffer of the last K timestamps for this frame
+        uint64_t* h = &history_[frame_id * k_];
+        h[count_[frame_id] % k_] = ++clock_;
+        ++count_[frame_id];
+
+        if (was) candidates_.insert(key(frame_id));
+    }
+
+    void insert(size_t frame_id) override {
+        std::lock_guard<std::mutex> lk(latch_);
+        if (evictable_[frame_id]) return;
+        evictable_[frame_id] = true;
+        candidates_.insert(key(frame_id));
+    }
+
+    // No recorded access: infinite K-distance, first in line
+    void insert_cold(size_t frame_id, uint32_t) override {
+        std::lock_guard<std::mutex> lk(latch_);
+        if (evictable_[frame_id]) return;
+        count_[frame_id] = 0;
+        evictable_[frame_id] = true;
+        candidates_.insert(key(frame_id));
+    }
+
+    bool erase(size_t frame_id) override {
+        std::lock_guard<std::mutex> lk(latch_);
+        if (!evictable_[frame_id]) return false;
+        candidates_.erase(key(frame_id));
+        evictable_[frame_id] = false;
+        return true;
+    }
+
+    bool victim(size_t& frame_id) override {
+        std::lock_guard<std::mutex> lk(latch_);
+        if (candidates_.empty()) return false;
+        frame_id = std::get<2>(*candidates_.begin());
+        candidates_.erase(candidates_.begin());
+        evictable_[frame_id] = false;
+        return true;
+    }
+
+    void forget(size_t frame_id) override {
+        std::lock_guard<std::mutex> lk(latch_);
+        count_[frame_id] = 0;                 // next page starts a fresh history
+    }
+
+    size_t size() const override {
+        std::lock_guard<std::mutex> lk(latch_);
+        return candidates_.size();
+    }
+
+private:
+    // (has K accesses, timestamp that orders eviction, frame)
+    using Key = std::tuple<bool, uint64_t, size_t>;
+
+    Key key(size_t frame_id) const {
+        const uint64_t* h = &history_[frame_id * k_];
+        uint64_t n = count_[frame_id];
+        if (n == 0) return { false, 0, frame_id };
+        if (n < k_) return { false, h[0], frame_id };          // earliest access
+        return { true, h[n % k_], frame_id };                   // K-th most recent
+    }
+
+    size_t k_;
+    mutable std::mutex latch_;
+    uint64_t clock_ = 0;
+    std::vector<uint64_t> history_;       // K slots per frame
+    std::vector<uint64_t> count_;         // accesses since the page was loaded
+    std::vector<bool> evictable_;
+    std::set<Key> candidates_;            // evictable frames in eviction order
+};
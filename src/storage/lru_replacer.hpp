@@ -1,17 +1,20 @@
 #pragma once
-#include <iostream>
 #include <list>
 #include <unordered_map>
+#include <mutex>
+#include "replacer.hpp"
 
-class LRUReplacer {
+class LRUReplacer : public Replacer {
 public:
     LRUReplacer(size_t capacity) : capacity_(capacity) {}
 
+    // Plain LRU orders frames by the time they were unpinned
+    void record_access(size_t, uint32_t) override {}
+
     // Add a frame to the LRU list
-    void insert(size_t frame_id) {
+    void insert(size_t frame_id) override {
+        std::lock_guard<std::mutex> lk(latch_);
         // If already present, move to front
-       // std::cout << "LRU Insert frame: " << frame_id << "\n";
-
         if (map_.count(frame_id)) {
             lst_.erase(map_[frame_id]);
         }
@@ -25,8 +28,17 @@ public:
         map_[frame_id] = lst_.begin();
     }
 
+    // Never-used frames go to the eviction end
+    void insert_cold(size_t frame_id, uint32_t) override {
+        std::lock_guard<std::mutex> lk(latch_);
+        if (map_.count(frame_id)) lst_.erase(map_[frame_id]);
+        lst_.push_back(frame_id);
+        map_[frame_id] = std::prev(lst_.end());
+    }
+
     // Erase a frame (e.g., if pinned)
-    bool erase(size_t frame_id) {
+    bool erase(size_t frame_id) override {
+        std::lock_guard<std::mutex> lk(latch_);
         if (!map_.count(frame_id)) return false;
         lst_.erase(map_[frame_id]);
         map_.erase(frame_id);
@@ -34,21 +46,23 @@ public:
     }
 
     // Select and remove LRU victim
-    bool victim(size_t& frame_id) {
+    bool victim(size_t& frame_id) override {
+        std::lock_guard<std::mutex> lk(latch_);
         if (lst_.empty()) return false;
         frame_id = lst_.back();
-        std::cout << "LRU Victim frame: " << frame_id << "\n";
         lst_.pop_back();
         map_.erase(frame_id);
         return true;
     }
 
-    size_t size() const {
+    size_t size() const override {
+        std::lock_guard<std::mutex> lk(latch_);
         return lst_.size();
     }
 
 private:
     size_t capacity_;
+    mutable std::mutex latch_;       // short critical sections only
     std::list<size_t> lst_;
     std::unordered_map<size_t, std::list<size_t>::iterator> map_;
 };
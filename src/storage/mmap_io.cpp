@@ -0,0 +1,103 @@
+#include "mmap_io.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static std::runtime_error sys_error(const char* what) {
+    return std::runtime_error(std::string(what) + ": " + std::strerror(errno));
+}
+
+static bool all_zero(const std::byte* p) {
+    return p[0] == std::byte{ 0 } && std::memcmp(p, p + 1, Page::PAGE_SIZE - 1) == 0;
+}
+
+MmapIO::MmapIO(int fd) : fd_(fd) {
+    // Reserve address space only; the file is mapped over it piece by piece
+    void* p = ::mmap(nullptr, RESERVE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (p == MAP_FAILED) throw sys_error("mmap reserve failed");
+    base_ = static_cast<std::byte*>(p);
+
+    struct stat st;
+    if (::fstat(fd_, &st) != 0) {
+        ::munmap(base_, RESERVE);
+        throw sys_error("fstat failed");
+    }
+    size_t size = static_cast<size_t>(st.st_size) / Page::PAGE_SIZE * Page::PAGE_SIZE;
+    if (size > 0) {
+        if (::mmap(base_, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd_, 0) == MAP_FAILED) {
+            ::munmap(base_, RESERVE);
+            throw sys_error("mmap failed");
+        }
+        mapped_.store(size);
+    }
+
+    // Only grow() leaves a file a whole number of extents long
+    size_t pages = size / Page::PAGE_SIZE;
+    if (size % EXTENT == 0) {
+        while (pages > 0 && all_zero(base_ + (pages - 1) * Page::PAGE_SIZE)) --pages;
+    }
+    pages_.store(static_cast<uint32_t>(pages));
+}
+
+MmapIO::~MmapIO() {
+    ::msync(base_, mapped_.load(), MS_SYNC);
+    ::munmap(base_, RESERVE);
+    // Drop the unused tail of the last extent
+    off_t used = static_cast<off_t>(pages_.load()) * Page::PAGE_SIZE;
+    struct stat st;
+    if (::fstat(fd_, &st) == 0 && st.st_size > used) (void)::ftruncate(fd_, used);
+}
+
+std::byte* MmapIO::page_ptr(uint32_t page_id) {
+    size_t end = (static_cast<size_t>(page_id) + 1) * Page::PAGE_SIZE;
+    if (end > mapped_.load(std::memory_order_acquire)) grow(end);
+    uint32_t pages = pages_.load(std::memory_order_relaxed);
+    while (pages <= page_id && !pages_.compare_exchange_weak(pages, page_id + 1)) {}
+    return base_ + static_cast<size_t>(page_id) * Page::PAGE_SIZE;
+}
+
+void MmapIO::grow(size_t bytes) {
+    std::lock_guard<std::mutex> lk(grow_latch_);
+    size_t old = mapped_.load();
+    if (bytes <= old) return;                  // another thread grew it
+    if (bytes > RESERVE) throw std::runtime_error("database larger than mmap reservation");
+
+    // Extend the file first: touching a mapped page past EOF is SIGBUS
+    size_t target = std::min(RESERVE, (bytes + EXTENT - 1) / EXTENT * EXTENT);
+    struct stat st;
+    if (::fstat(fd_, &st) != 0) throw sys_error("fstat failed");
+    if (static_cast<size_t>(st.st_size) < target && ::ftruncate(fd_, static_cast<off_t>(target)) != 0) {
+        throw sys_error("ftruncate failed");
+    }
+    if (::mmap(base_ + old, target - old, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+            fd_, static_cast<off_t>(old)) == MAP_FAILED) {
+        throw sys_error("mmap failed");
+    }
+    mapped_.store(target, std::memory_order_release);
+}
+
+void MmapIO::read_page(uint32_t page_id, std::byte* out_buffer) {
+    std::byte* src = page_ptr(page_id);
+    if (src != out_buffer) std::memcpy(out_buffer, src, Page::PAGE_SIZE);
+}
+
+void MmapIO::write_page(uint32_t page_id, const std::byte* buffer) {
+    std::byte* dst = page_ptr(page_id);
+    if (dst != buffer) std::memcpy(dst, buffer, Page::PAGE_SIZE);
+}
+
+void MmapIO::sync() {
+    if (::msync(base_, mapped_.load(), MS_SYNC) != 0) throw sys_error("msync failed");
+}
+
+void MmapIO::advise(uint32_t page_id, size_t count) {
+    size_t begin = static_cast<size_t>(page_id) * Page::PAGE_SIZE;
+    size_t end = std::min(begin + count * Page::PAGE_SIZE, mapped_.load(std::memory_order_acquire));
+    if (begin < end) ::madvise(base_ + begin, end - begin, MADV_WILLNEED);
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include "io_backend.hpp"
+
+/*
+ * Memory-mapped backend for read-mostly databases.
+ *
+ * One large virtual range is reserved up front and the file is mapped into
+ * it MAP_SHARED, growing in EXTENT steps, so a page's address never changes
+ * once handed out. BufferPoolManager points its frames straight at
+ * page_ptr() instead of copying pages in; read_page/write_page still work
+ * and skip the copy when the buffer already is the mapped page.
+ *
+ * The file runs ahead of the pages in use, so the backend keeps its own
+ * count of them (num_pages): the pages the file held at open plus any
+ * asked for since. Closing truncates the file to that count. A file left
+ * a whole number of extents long (by a crash) loses its trailing zero
+ * pages from the count, which grow() created but nobody ever wrote.
+ *
+ * The kernel may write a mapped page back at any time, so nothing here can
+ * hold a dirty page in memory until its log record is durable. sync()
+ * (the checkpoint) makes everything durable with msync.
+ */
+class MmapIO : public IOBackend {
+public:
+    static constexpr size_t EXTENT = size_t(64) << 20;      // growth step
+    static constexpr size_t RESERVE = size_t(1) << 40;      // address space
+
+    // Throws std::runtime_error if the range cannot be reserved or mapped
+    explicit MmapIO(int fd);
+    ~MmapIO() override;
+
+    MmapIO(const MmapIO&) = delete;
+    MmapIO& operator=(const MmapIO&) = delete;
+
+    // Address of page_id inside the mapping; grows the file and the
+    // mapping if the page lies past the current end
+    std::byte* page_ptr(uint32_t page_id);
+
+    // Pages in use: every page id below it has been handed out
+    uint32_t num_pages() const { return pages_.load(std::memory_order_acquire); }
+
+    void read_page(uint32_t page_id, std::byte* out_buffer) override;
+    void write_page(uint32_t page_id, const std::byte* buffer) override;
+    void sync() override;
+    void advise(uint32_t page_id, size_t count) override;
+    const char* name() const override { return "mmap"; }
+
+private:
+    void grow(size_t bytes);
+
+    int fd_;
+    std::byte* base_ = nullptr;
+    std::atomic<size_t> mapped_{ 0 };   // bytes of the file mapped at base_
+    std::atomic<uint32_t> pages_{ 0 };  // pages in use, <= mapped_ / PAGE_SIZE
+    std::mutex grow_latch_;
+};
@@ -1,74 +1,125 @@
 #pragma once
 
 #include <cstddef>   // for std::byte
-#include <array>
 #include <span>
 #include<stdexcept> // for std::runtime_error
 #include <cstring>   // for memcpy
 #include <cstdint>   // for fixed-width ints
+#include <shared_mutex>
+#include <atomic>
 
+// A Page is a view of one PAGE_SIZE frame buffer. The buffer belongs to
+// BufferPoolManager, which allocates all frames 4 KB aligned (so they can
+// be handed to O_DIRECT I/O) and attaches each Page to its frame.
 class Page {
 public:
     static constexpr size_t PAGE_SIZE = 4096;
     static constexpr size_t HEADER_SIZE = 8;  // 4 bytes for page_id + 4 for lsn
 
-    Page() {
-        reset_memory();
+    Page() = default;
+
+    // Point this page at its frame buffer
+    void attach(std::byte* frame) {
+        data_ = frame;
     }
 
     // Resets the memory to zero
     void reset_memory() {
-        std::memset(data_.data(), 0, PAGE_SIZE);
+        std::memset(data_, 0, PAGE_SIZE);
     }
 
     // Get the full raw buffer (for DiskManager)
     std::span<std::byte> get_data() {
-        return std::span<std::byte>(data_);
+        return std::span<std::byte>(data_, PAGE_SIZE);
     }
 
     // Write something to the usable part of the page
     void write_content(const std::byte* src, size_t offset, size_t len) {
         if (offset + len > usable_size()) throw std::runtime_error("write overflow");
-        std::memcpy(data_.data() + HEADER_SIZE + offset, src, len);
+        std::memcpy(data_ + HEADER_SIZE + offset, src, len);
     }
 
     // Read content from the page
     void read_content(std::byte* dest, size_t offset, size_t len) const {
         if (offset + len > usable_size()) throw std::runtime_error("read overflow");
-        std::memcpy(dest, data_.data() + HEADER_SIZE + offset, len);
+        std::memcpy(dest, data_ + HEADER_SIZE + offset, len);
     }
 
     // Page ID getter/setter (4 bytes at offset 0)
     uint32_t get_page_id() const {
         uint32_t val;
-        std::memcpy(&val, data_.data(), sizeof(uint32_t));
+        std::memcpy(&val, data_, sizeof(uint32_t));
         return val;
     }
 
     void set_page_id(uint32_t pid) {
-        std::memcpy(data_.data(), &pid, sizeof(uint32_t));
+        std::memcpy(data_, &pid, sizeof(uint32_t));
     }
 
     // Log Sequence Number getter/setter (next 4 bytes)
     uint32_t get_lsn() const {
         uint32_t val;
-        std::memcpy(&val, data_.data() + 4, sizeof(uint32_t));
+        std::memcpy(&val, data_ + 4, sizeof(uint32_t));
         return val;
     }
 
     void set_lsn(uint32_t lsn) {
-        std::memcpy(data_.data() + 4, &lsn, sizeof(uint32_t));
+        std::memcpy(data_ + 4, &lsn, sizeof(uint32_t));
+    }
+
+    // Recovery LSN (in memory only): no change logged before it is missing
+    // from the page on disk. 0 while the frame matches the disk. Writers
+    // call note_change(next LSN) under w_latch before they log, so that a
+    // checkpoint that logs after them sees the page as dirty; the buffer
+    // pool clears it once a write of the page has completed.
+    uint32_t rec_lsn() const { return rec_lsn_.load(); }
+    void note_change(uint32_t lsn) {
+        uint32_t none = 0;
+        rec_lsn_.compare_exchange_strong(none, lsn);
     }
+    void clear_rec_lsn() { rec_lsn_.store(0); }
 
     size_t usable_size() const {
         return PAGE_SIZE - HEADER_SIZE;
     }
     std::byte* data() {                // non-const
-        return data_.data();
+        return data_;
     }
     const std::byte* data() const {    // const overload
-        return data_.data();
+        return data_;
+    }
+
+    // Reader/writer latch protecting the page bytes. Independent of the
+    // buffer pool's pin count: pinning keeps the frame resident, latching
+    // keeps concurrent users from seeing half-written content.
+    void w_latch() {
+        latch_.lock();
+        version_.fetch_add(1, std::memory_order_relaxed);       // odd: write in progress
+        std::atomic_thread_fence(std::memory_order_release);
     }
+    void w_unlatch() {
+        version_.fetch_add(1, std::memory_order_release);
+        latch_.unlock();
+    }
+    void r_latch() { latch_.lock_shared(); }
+    void r_unlatch() { latch_.unlock_shared(); }
+    bool try_r_latch() { return latch_.try_lock_shared(); }
+
+    // Optimistic (latch-free) reads: the version is odd while a writer
+    // holds w_latch and moves on with every write latch and every reload
+    // of the frame. A reader that sees the same even version before and
+    // after reading knows the bytes it read were not changed meanwhile.
+    uint64_t version() const { return version_.load(std::memory_order_acquire); }
+    bool validate(uint64_t v) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return version_.load(std::memory_order_relaxed) == v;
+    }
+    // The frame now holds other content (called by the buffer pool)
+    void bump_version() { version_.fetch_add(2, std::memory_order_release); }
+
 private:
-    std::array<std::byte, PAGE_SIZE> data_;
+    std::byte* data_ = nullptr;
+    std::shared_mutex latch_;
+    std::atomic<uint64_t> version_{ 0 };
+    std::atomic<uint32_t> rec_lsn_{ 0 };
 };
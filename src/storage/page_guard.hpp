@@ -0,0 +1,56 @@
+#pragma once
+#include <utility>
+#include "buffer_pool_manager.hpp"
+
+/*
+ * A pin on a buffer-pool page, released when the guard goes away (or is
+ * reset or assigned over). Movable, not copyable. mark_dirty() makes the
+ * unpin report the page as changed.
+ *
+ * Whatever points into the page (a TupleView, say) is valid for as long as
+ * the guard holds it.
+ */
+class PageGuard {
+public:
+    PageGuard() = default;
+    // Pins page_id; empty if the pool has no frame for it
+    PageGuard(BufferPoolManager* bpm, uint32_t page_id)
+        : bpm_(bpm), page_(bpm->fetch_page(page_id)), page_id_(page_id) {}
+    ~PageGuard() { reset(); }
+
+    PageGuard(const PageGuard&) = delete;
+    PageGuard& operator=(const PageGuard&) = delete;
+    PageGuard(PageGuard&& o) noexcept
+        : bpm_(o.bpm_), page_(std::exchange(o.page_, nullptr)), page_id_(o.page_id_), dirty_(o.dirty_) {}
+    PageGuard& operator=(PageGuard&& o) noexcept {
+        if (this != &o) {
+            reset();
+            bpm_ = o.bpm_;
+            page_ = std::exchange(o.page_, nullptr);
+            page_id_ = o.page_id_;
+            dirty_ = o.dirty_;
+        }
+        return *this;
+    }
+
+    explicit operator bool() const { return page_ != nullptr; }
+    Page* page() const { return page_; }
+    Page* operator->() const { return page_; }
+    uint32_t page_id() const { return page_id_; }
+
+    void mark_dirty() { dirty_ = true; }
+
+    // Unpin now
+    void reset() {
+        if (!page_) return;
+        bpm_->unpin_page(page_id_, dirty_);
+        page_ = nullptr;
+        dirty_ = false;
+    }
+
+private:
+    BufferPoolManager* bpm_ = nullptr;
+    Page*              page_ = nullptr;
+    uint32_t           page_id_ = BufferPoolManager::INVALID_PAGE_ID;
+    bool               dirty_ = false;
+};
@@ -0,0 +1,51 @@
+#include "posix_io.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+
+void PosixIO::read_page(uint32_t page_id, std::byte* out_buffer) {
+    off_t offset = static_cast<off_t>(page_id) * Page::PAGE_SIZE;
+    size_t got = 0;
+    while (got < Page::PAGE_SIZE) {
+        ssize_t n = ::pread(fd_, out_buffer + got, Page::PAGE_SIZE - got, offset + got);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("pread failed: ") + std::strerror(errno));
+        }
+        if (n == 0) break;                 // end of file
+        got += static_cast<size_t>(n);
+    }
+
+    // Pages past the end of the file read back as zeros
+    if (got < Page::PAGE_SIZE) std::memset(out_buffer + got, 0, Page::PAGE_SIZE - got);
+}
+
+void PosixIO::write_page(uint32_t page_id, const std::byte* buffer) {
+    off_t offset = static_cast<off_t>(page_id) * Page::PAGE_SIZE;
+    size_t put = 0;
+    while (put < Page::PAGE_SIZE) {
+        ssize_t n = ::pwrite(fd_, buffer + put, Page::PAGE_SIZE - put, offset + put);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("pwrite failed: ") + std::strerror(errno));
+        }
+        put += static_cast<size_t>(n);
+    }
+}
+
+void PosixIO::sync() {
+    if (::fdatasync(fd_) != 0) {
+        throw std::runtime_error(std::string("fdatasync failed: ") + std::strerror(errno));
+    }
+}
+
+void PosixIO::advise(uint32_t page_id, size_t count) {
+    // O_DIRECT bypasses the page cache, so there is nothing to warm up
+    if (direct_) return;
+    ::posix_fadvise(fd_, static_cast<off_t>(page_id) * Page::PAGE_SIZE,
+        static_cast<off_t>(count * Page::PAGE_SIZE), POSIX_FADV_WILLNEED);
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include "io_backend.hpp"
+
+/*
+ * Positional I/O with pread/pwrite on a shared descriptor: no seek state,
+ * so any number of threads can have a request in flight. With O_DIRECT on
+ * the descriptor the page cache is bypassed and buffers must be aligned.
+ */
+class PosixIO : public IOBackend {
+public:
+    PosixIO(int fd, bool direct) : fd_(fd), direct_(direct) {}
+
+    void read_page(uint32_t page_id, std::byte* out_buffer) override;
+    void write_page(uint32_t page_id, const std::byte* buffer) override;
+    void sync() override;
+    void advise(uint32_t page_id, size_t count) override;
+    const char* name() const override { return direct_ ? "pread+O_DIRECT" : "pread"; }
+
+protected:
+    int  fd_;
+    bool direct_;
+};
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Page replacement policy used by BufferPoolManager.
+ *
+ * The pool reports every access to a frame, hands frames over once their
+ * pin count drops to zero (insert) and takes them back when they are pinned
+ * again (erase). Pages loaded by prefetch arrive through insert_cold
+ * without an access. victim() picks and removes one evictable frame, which
+ * the pool then re-checks under its latches: it may find the frame pinned
+ * again and keep the page. Only once the page is really evicted does the
+ * pool call forget(), and the policy drops that frame's history, since a
+ * different page will live there next.
+ * Implementations must be safe to call from several threads at once.
+ */
+class Replacer {
+public:
+    virtual ~Replacer() = default;
+
+    // Frame frame_id (now holding page_id) was fetched or created
+    virtual void record_access(size_t frame_id, uint32_t page_id) = 0;
+
+    // Frame became evictable
+    virtual void insert(size_t frame_id) = 0;
+
+    // Frame was filled by readahead and has not been accessed yet: make it
+    // evictable, ahead of anything that has been used
+    virtual void insert_cold(size_t frame_id, uint32_t /*page_id*/) { insert(frame_id); }
+
+    // Frame is pinned again; returns false if it was not evictable
+    virtual bool erase(size_t frame_id) = 0;
+
+    // Select and remove a victim
+    virtual bool victim(size_t& frame_id) = 0;
+
+    // The victim's page has left the frame
+    virtual void forget(size_t /*frame_id*/) {}
+
+    // Number of evictable frames
+    virtual size_t size() const = 0;
+};
@@ -0,0 +1,15 @@
+#pragma once
+#include <memory>
+#include <string>
+#include "lru_replacer.hpp"
+#include "clock_replacer.hpp"
+#include "lru_k_replacer.hpp"
+#include "two_queue_replacer.hpp"
+
+// Replacement policy by name: lru (default), clock, lru-k, 2q
+inline std::unique_ptr<Replacer> make_replacer(const std::string& name, size_t frames) {
+    if (name == "clock") return std::make_unique<ClockReplacer>(frames);
+    if (name == "lru-k") return std::make_unique<LRUKReplacer>(frames);
+    if (name == "2q")    return std::make_unique<TwoQueueReplacer>(frames);
+    return std::make_unique<LRUReplacer>(frames);
+}
@@ -2,6 +2,9 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <string_view>
+#include <charconv>     // std::from_chars, std::to_chars
+#include <cstdint>
 #include <cstring>      // std::memcpy
 #include <cstddef>      // std::byte
 #include <stdexcept>
@@ -11,59 +14,208 @@
 /* ---------- Column alias (reuse ColumnDef from parser) ---------- */
 using Column = ColumnDef;     // keeps older code working
 
+/*
+ * Rows are fixed width: every column sits at the same offset in every
+ * tuple (INT as 4 native-endian bytes, CHAR(n) as n bytes '\0'-padded).
+ * The schema works the offsets out once; the typed accessors read one
+ * column in place and the encoders write a whole row into the caller's
+ * buffer. Row shapes that are common enough (all INT, INT + CHAR(n))
+ * have their own codec with the offsets fixed at compile time.
+ */
+enum class RowLayout : uint8_t { GENERIC, ALL_INT, INT_CHAR };
+
+template <RowLayout L> struct RowCodec;
+
 class Schema {
 public:
-    explicit Schema(std::vector<Column> cols) : cols_(std::move(cols)) {}
+    explicit Schema(std::vector<Column> cols) : cols_(std::move(cols)) {
+        size_t off = 0;
+        bool all_int = true;
+        for (const auto& col : cols_) {
+            offsets_.push_back(off);
+            off += width(col);
+            all_int = all_int && col.type == ColumnType::INT;
+        }
+        row_size_ = off;
+        if (!cols_.empty() && all_int) layout_ = RowLayout::ALL_INT;
+        else if (cols_.size() == 2 && cols_[0].type == ColumnType::INT && cols_[1].type == ColumnType::CHAR)
+            layout_ = RowLayout::INT_CHAR;
+    }
 
     const std::vector<Column>& columns() const { return cols_; }
+    size_t row_size() const { return row_size_; }              // bytes per tuple
+    size_t offset(size_t col) const { return offsets_[col]; }
+    RowLayout layout() const { return layout_; }
+
+    static size_t width(const Column& col) { return col.type == ColumnType::INT ? sizeof(int32_t) : col.len; }
+
+    /* -------- Typed access to one column of a row -------- */
+    int32_t get_int(TupleView row, size_t col) const {
+        int32_t v;
+        std::memcpy(&v, row.data() + offsets_[col], sizeof v);
+        return v;
+    }
+    // The CHAR value without its padding; points into the row
+    std::string_view get_char(TupleView row, size_t col) const {
+        const char* p = reinterpret_cast<const char*>(row.data() + offsets_[col]);
+        return std::string_view(p, ::strnlen(p, cols_[col].len));
+    }
+    // Either, as text (what deserialize gives for the column)
+    std::string value(TupleView row, size_t col) const {
+        if (cols_[col].type == ColumnType::CHAR) return std::string(get_char(row, col));
+        char buf[16];
+        auto [end, ec] = std::to_chars(buf, buf + sizeof buf, get_int(row, col));
+        return std::string(buf, end);
+    }
+
+    /* -------- Encode raw literals -> row bytes -------- */
+    // Writes row_size() bytes at out. S is std::string, std::string_view
+    // or Param.
+    template <class S>
+    void encode(const std::vector<S>& raw, std::byte* out) const;
+    // The same from columns().size() values at raw (not checked)
+    template <class S>
+    void encode(const S* raw, std::byte* out) const;
 
-    /* -------- Serialize raw literals -> Tuple bytes -------- */
     Tuple serialize(const std::vector<std::string>& raw) const {
-        if (raw.size() != cols_.size())
-            throw std::runtime_error("value/column count mismatch");
-
-        std::vector<std::byte> buf;
-        for (std::size_t i = 0; i < cols_.size(); ++i) {
-            const auto& col = cols_[i];
-
-            if (col.type == ColumnType::INT) {
-                int v = std::stoi(raw[i]);
-                const auto* p = reinterpret_cast<const std::byte*>(&v);
-                buf.insert(buf.end(), p, p + sizeof(int));
-            }
-            else {                                // CHAR(n)
-                std::string s = raw[i];
-                if (s.size() > col.len) s.resize(col.len);
-                while (s.size() < col.len) s.push_back('\0');   // pad
-                const auto* p = reinterpret_cast<const std::byte*>(s.data());
-                buf.insert(buf.end(), p, p + col.len);
-            }
-        }
-        return Tuple(buf.data(), buf.size());
+        Tuple t(row_size_);
+        encode(raw, t.data());
+        return t;
     }
 
-    /* -------- Deserialize Tuple -> vector<string> -------- */
-    std::vector<std::string> deserialize(const Tuple& tup) const {
-        std::vector<std::string> out;
-        const std::byte* p = tup.data();
+    /* -------- Decode row -> text of every column -------- */
+    // Reuses out's strings, so a loop over rows does not allocate per row
+    void deserialize(TupleView tup, std::vector<std::string>& out) const;
 
-        for (const auto& col : cols_) {
-            if (col.type == ColumnType::INT) {
-                int v;
-                std::memcpy(&v, p, sizeof(int));
-                out.push_back(std::to_string(v));
-                p += sizeof(int);
-            }
-            else {                                // CHAR(n)
-                std::string s(reinterpret_cast<const char*>(p), col.len);
-                while (!s.empty() && s.back() == '\0') s.pop_back(); // trim pad
-                out.push_back(s);
-                p += col.len;
-            }
-        }
+    std::vector<std::string> deserialize(TupleView tup) const {
+        std::vector<std::string> out;
+        deserialize(tup, out);
         return out;
     }
+    std::vector<std::string> deserialize(const Tuple& tup) const { return deserialize(tup.view()); }
+
+    /* -------- Field codecs shared by the row codecs -------- */
+    // As std::stoi, which handles anything from_chars does not take whole
+    // (leading blanks, '+', trailing text) and throws the same errors
+    template <class S>
+    static int32_t parse_int(const S& s) {
+        int32_t v;
+        auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), v);
+        if (ec == std::errc() && end == s.data() + s.size()) return v;
+        return std::stoi(std::string(s));
+    }
+    // A bound parameter: an INT as it is, text parsed
+    static int32_t parse_int(const Param& p) {
+        if (auto* v = std::get_if<int32_t>(&p)) return *v;
+        return parse_int(std::get<std::string>(p));
+    }
+    // s in len bytes, cut short or '\0'-padded
+    template <class S>
+    static void put_char(const S& s, size_t len, std::byte* out) {
+        size_t n = s.size() < len ? s.size() : len;
+        std::memcpy(out, s.data(), n);
+        std::memset(out + n, 0, len - n);
+    }
+    // A bound parameter; an INT as its digits
+    static void put_char(const Param& p, size_t len, std::byte* out) {
+        if (auto* s = std::get_if<std::string>(&p)) return put_char(*s, len, out);
+        char buf[16];
+        auto [end, ec] = std::to_chars(buf, buf + sizeof buf, std::get<int32_t>(p));
+        put_char(std::string_view(buf, end - buf), len, out);
+    }
+    static void put_int(int32_t v, std::byte* out) { std::memcpy(out, &v, sizeof v); }
+    static void int_text(const std::byte* p, std::string& out) {
+        int32_t v;
+        std::memcpy(&v, p, sizeof v);
+        char buf[16];
+        auto [end, ec] = std::to_chars(buf, buf + sizeof buf, v);
+        out.assign(buf, end);
+    }
+    static void char_text(const std::byte* p, size_t len, std::string& out) {
+        const char* c = reinterpret_cast<const char*>(p);
+        out.assign(c, ::strnlen(c, len));
+    }
 
 private:
     std::vector<Column> cols_;
+    std::vector<size_t> offsets_;
+    size_t              row_size_ = 0;
+    RowLayout           layout_ = RowLayout::GENERIC;
+};
+
+/* ---------- row codecs ---------- */
+
+// Any schema: column by column through the offsets
+template <>
+struct RowCodec<RowLayout::GENERIC> {
+    template <class S>
+    static void encode(const Schema& s, const S* raw, std::byte* out) {
+        const auto& cols = s.columns();
+        for (size_t i = 0; i < cols.size(); ++i) {
+            if (cols[i].type == ColumnType::INT) Schema::put_int(Schema::parse_int(raw[i]), out + s.offset(i));
+            else Schema::put_char(raw[i], cols[i].len, out + s.offset(i));
+        }
+    }
+    static void decode(const Schema& s, TupleView t, std::string* out) {
+        const auto& cols = s.columns();
+        for (size_t i = 0; i < cols.size(); ++i) {
+            if (cols[i].type == ColumnType::INT) Schema::int_text(t.data() + s.offset(i), out[i]);
+            else Schema::char_text(t.data() + s.offset(i), cols[i].len, out[i]);
+        }
+    }
+};
+
+// Only INT columns: column i at 4 * i, no type test per column
+template <>
+struct RowCodec<RowLayout::ALL_INT> {
+    template <class S>
+    static void encode(const Schema& s, const S* raw, std::byte* out) {
+        size_t n = s.columns().size();
+        for (size_t i = 0; i < n; ++i) Schema::put_int(Schema::parse_int(raw[i]), out + i * sizeof(int32_t));
+    }
+    static void decode(const Schema& s, TupleView t, std::string* out) {
+        size_t n = s.columns().size();
+        for (size_t i = 0; i < n; ++i) Schema::int_text(t.data() + i * sizeof(int32_t), out[i]);
+    }
+};
+
+// (INT, CHAR(n)): the id/name shape, CHAR at offset 4
+template <>
+struct RowCodec<RowLayout::INT_CHAR> {
+    template <class S>
+    static void encode(const Schema& s, const S* raw, std::byte* out) {
+        Schema::put_int(Schema::parse_int(raw[0]), out);
+        Schema::put_char(raw[1], s.columns()[1].len, out + sizeof(int32_t));
+    }
+    static void decode(const Schema& s, TupleView t, std::string* out) {
+        Schema::int_text(t.data(), out[0]);
+        Schema::char_text(t.data() + sizeof(int32_t), s.columns()[1].len, out[1]);
+    }
 };
+
+/* ---------- dispatch ---------- */
+
+template <class S>
+void Schema::encode(const std::vector<S>& raw, std::byte* out) const {
+    if (raw.size() != cols_.size())
+        throw std::runtime_error("value/column count mismatch");
+    encode(raw.data(), out);
+}
+
+template <class S>
+void Schema::encode(const S* raw, std::byte* out) const {
+    switch (layout_) {
+        case RowLayout::ALL_INT:  RowCodec<RowLayout::ALL_INT>::encode(*this, raw, out); break;
+        case RowLayout::INT_CHAR: RowCodec<RowLayout::INT_CHAR>::encode(*this, raw, out); break;
+        default:                  RowCodec<RowLayout::GENERIC>::encode(*this, raw, out); break;
+    }
+}
+
+inline void Schema::deserialize(TupleView tup, std::vector<std::string>& out) const {
+    out.resize(cols_.size());
+    switch (layout_) {
+        case RowLayout::ALL_INT:  RowCodec<RowLayout::ALL_INT>::decode(*this, tup, out.data()); break;
+        case RowLayout::INT_CHAR: RowCodec<RowLayout::INT_CHAR>::decode(*this, tup, out.data()); break;
+        default:                  RowCodec<RowLayout::GENERIC>::decode(*this, tup, out.data()); break;
+    }
+}
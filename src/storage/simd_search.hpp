@@ -0,0 +1,136 @@
+/************************  simd_search.hpp  ***********************
+ * Branch-light search over small sorted int32 arrays (B+-tree nodes),
+ * and byte matching over the tag arrays of hash buckets.
+ *
+ * Binary search narrows the range to a SIMD_WINDOW of keys, then a
+ * compare-and-movemask pass counts the keys below the probe, which for
+ * a sorted array is the answer. AVX2 compares 8 keys per step, SSE2
+ * compares 4; without either the window is finished with a scalar count.
+ *
+ * The build targets the base instruction set (SSE2 on x86-64). The AVX2
+ * kernels are compiled for AVX2 on their own (target attribute) and only
+ * run when the CPU reports it, checked once (has_avx2). MYDB_AVX2 in
+ * CMake compiles everything for AVX2 instead and skips the check.
+ *****************************************************************/
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MYDB_SIMD_X86 1
+#define MYDB_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace simd {
+
+inline constexpr size_t SIMD_WINDOW = 64;
+
+// Whether the AVX2 kernels may run on this CPU
+inline bool has_avx2() {
+#if defined(__AVX2__)
+    return true;
+#elif defined(MYDB_SIMD_X86)
+    static const bool yes = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+    }();
+    return yes;
+#else
+    return false;
+#endif
+}
+
+namespace detail {
+
+#if defined(MYDB_SIMD_X86)
+// count_below over whole groups of 8 keys; i ends after the last group
+template <bool Strict>
+MYDB_TARGET_AVX2 inline size_t count_below_avx2(const int32_t* keys, size_t n, int32_t key, size_t& i) {
+    size_t c = 0;
+    const __m256i probe = _mm256_set1_epi32(key);
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+        // Strict: key > v  means v < key;  otherwise v > key counts the rest
+        __m256i m = Strict ? _mm256_cmpgt_epi32(probe, v) : _mm256_cmpgt_epi32(v, probe);
+        unsigned bits = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(m)));
+        c += Strict ? std::popcount(bits) : 8 - std::popcount(bits);
+    }
+    return c;
+}
+
+MYDB_TARGET_AVX2 inline uint32_t match_bytes32_avx2(const uint8_t* bytes, uint8_t b) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(static_cast<char>(b)))));
+}
+#endif
+
+#if defined(__SSE2__)
+// The same, 4 keys at a time
+template <bool Strict>
+inline size_t count_below_sse2(const int32_t* keys, size_t n, int32_t key, size_t& i) {
+    size_t c = 0;
+    const __m128i probe = _mm_set1_epi32(key);
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i));
+        __m128i m = Strict ? _mm_cmpgt_epi32(probe, v) : _mm_cmpgt_epi32(v, probe);
+        unsigned bits = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(m)));
+        c += Strict ? std::popcount(bits) : 4 - std::popcount(bits);
+    }
+    return c;
+}
+#endif
+
+} // namespace detail
+
+// Number of keys in [keys, keys + n) that are < key (strict) or <= key
+template <bool Strict>
+inline size_t count_below(const int32_t* keys, size_t n, int32_t key) {
+    size_t i = 0, c = 0;
+#if defined(MYDB_SIMD_X86)
+    if (has_avx2()) c = detail::count_below_avx2<Strict>(keys, n, key, i);
+#if defined(__SSE2__)
+    else c = detail::count_below_sse2<Strict>(keys, n, key, i);
+#endif
+#endif
+    for (; i < n; ++i) c += Strict ? keys[i] < key : keys[i] <= key;
+    return c;
+}
+
+// Binary search down to SIMD_WINDOW keys, then count
+template <bool Strict>
+inline size_t search(const int32_t* keys, size_t n, int32_t key) {
+    size_t lo = 0;
+    while (n > SIMD_WINDOW) {
+        size_t half = n / 2;
+        bool right = Strict ? keys[lo + half] < key : keys[lo + half] <= key;
+        lo = right ? lo + half + 1 : lo;
+        n = right ? n - half - 1 : half;
+    }
+    return lo + count_below<Strict>(keys + lo, n, key);
+}
+
+// Same results as std::lower_bound / std::upper_bound on a sorted array
+inline size_t lower_bound(const int32_t* keys, size_t n, int32_t key) { return search<true>(keys, n, key); }
+inline size_t upper_bound(const int32_t* keys, size_t n, int32_t key) { return search<false>(keys, n, key); }
+
+// Bit i set where bytes[i] == b, for the 32 bytes from `bytes`
+inline uint32_t match_bytes32(const uint8_t* bytes, uint8_t b) {
+#if defined(MYDB_SIMD_X86)
+    if (has_avx2()) return detail::match_bytes32_avx2(bytes, b);
+#endif
+#if defined(__SSE2__)
+    const __m128i probe = _mm_set1_epi8(static_cast<char>(b));
+    __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+    __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + 16));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(lo, probe))) |
+           static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(hi, probe))) << 16;
+#else
+    uint32_t m = 0;
+    for (size_t i = 0; i < 32; ++i) m |= static_cast<uint32_t>(bytes[i] == b) << i;
+    return m;
+#endif
+}
+
+} // namespace simd
@@ -1,107 +1,476 @@
 #include "table_heap.hpp"
 #include "page.hpp"
-#include <cstring>
-#include <iostream>
+#include <algorithm>
 #include <stdexcept>
+#include <string>
 #include <cstdint>
 #include <cstring>
 
-constexpr size_t PAGE_HEADER_SIZE = 8; // 2 bytes free offset + 2 bytes slot count + reserved
+// Heap page header, placed after the generic Page header (page_id + lsn):
+// 2 bytes free offset + 2 bytes slot count + 4 bytes next page id
+constexpr size_t FREE_OFFSET_POS = Page::HEADER_SIZE;
+constexpr size_t SLOT_COUNT_POS = Page::HEADER_SIZE + 2;
+constexpr size_t NEXT_PAGE_POS = Page::HEADER_SIZE + 4;
+constexpr size_t SLOT_ARRAY_POS = Page::HEADER_SIZE + 8;
 constexpr size_t SLOT_ENTRY_SIZE = 4;  // 2 bytes offset, 2 bytes size
 
-TableHeap::TableHeap(BufferPoolManager* bpm)
-    : bpm_(bpm) {
+static size_t free_space(const std::byte* raw) {
+    uint16_t free_offset = *reinterpret_cast<const uint16_t*>(raw + FREE_OFFSET_POS);
+    uint16_t slot_count = *reinterpret_cast<const uint16_t*>(raw + SLOT_COUNT_POS);
+    size_t slot_array_end = SLOT_ARRAY_POS + slot_count * SLOT_ENTRY_SIZE;
+    return free_offset > slot_array_end ? free_offset - slot_array_end : 0;
+}
+
+// Free space once the page is compacted: all but the slot array and the
+// live tuples
+static size_t reclaimable(const std::byte* raw) {
+    uint16_t slot_count = *reinterpret_cast<const uint16_t*>(raw + SLOT_COUNT_POS);
+    size_t used = SLOT_ARRAY_POS + slot_count * SLOT_ENTRY_SIZE;
+    for (uint16_t i = 0; i < slot_count; ++i) {
+        const uint16_t* slot = reinterpret_cast<const uint16_t*>(raw + SLOT_ARRAY_POS + i * SLOT_ENTRY_SIZE);
+        if (slot[0] != 0) used += slot[1];
+    }
+    return Page::PAGE_SIZE - used;
+}
+
+static void init_heap_page(Page* page) {
+    // Zero out the page body and initialize slot metadata
+    std::byte* raw = page->data();
+    std::memset(raw + Page::HEADER_SIZE, 0, Page::PAGE_SIZE - Page::HEADER_SIZE);
+
+    // Initialize header: free offset = end of page, slot count = 0, no next page
+    *reinterpret_cast<uint16_t*>(raw + FREE_OFFSET_POS) = Page::PAGE_SIZE;
+    *reinterpret_cast<uint16_t*>(raw + SLOT_COUNT_POS) = 0;
+    *reinterpret_cast<uint32_t*>(raw + NEXT_PAGE_POS) = FreeSpaceMap::INVALID_PAGE;
+}
+
+// Slot for the next insert: the first one compaction freed, else a new one
+static uint16_t free_slot(const std::byte* raw) {
+    uint16_t slot_count = *reinterpret_cast<const uint16_t*>(raw + SLOT_COUNT_POS);
+    for (uint16_t i = 0; i < slot_count; ++i) {
+        if (*reinterpret_cast<const uint16_t*>(raw + SLOT_ARRAY_POS + i * SLOT_ENTRY_SIZE) == 0) return i;
+    }
+    return slot_count;
+}
+
+// Store a tuple in slot slot_id (free_slot()) of a page that has room for it
+static uint16_t place_tuple(std::byte* raw, uint16_t slot_id, const void* data, size_t size) {
+    uint16_t* free_offset_ptr = reinterpret_cast<uint16_t*>(raw + FREE_OFFSET_POS);
+    uint16_t* slot_count_ptr = reinterpret_cast<uint16_t*>(raw + SLOT_COUNT_POS);
+
+    // Insert tuple data at end of page (backward growth)
+    *free_offset_ptr -= size;
+    std::memcpy(reinterpret_cast<void*>(raw + *free_offset_ptr), data, size);
+
+    // Write slot entry (forward from front): offset and size
+    uint16_t* slot_entry = reinterpret_cast<uint16_t*>(raw + SLOT_ARRAY_POS + slot_id * SLOT_ENTRY_SIZE);
+    slot_entry[0] = *free_offset_ptr;               // tuple offset
+    slot_entry[1] = static_cast<uint16_t>(size);
+    if (slot_id == *slot_count_ptr) ++*slot_count_ptr;
+    return slot_id;
+}
+
+// Move the live tuples together at the end of the page, in slot order, and
+// free the slots of deleted rows, dropping those at the end of the array.
+// Depends only on the page, so redo does exactly the same.
+static void compact_page(std::byte* raw) {
+    uint16_t* slot_count_ptr = reinterpret_cast<uint16_t*>(raw + SLOT_COUNT_POS);
+    std::byte copy[Page::PAGE_SIZE];
+    std::memcpy(copy, raw, Page::PAGE_SIZE);
+
+    size_t free_offset = Page::PAGE_SIZE;
+    uint16_t slot_count = 0;
+    for (uint16_t i = 0; i < *slot_count_ptr; ++i) {
+        uint16_t* slot = reinterpret_cast<uint16_t*>(raw + SLOT_ARRAY_POS + i * SLOT_ENTRY_SIZE);
+        if (slot[0] == 0 || slot[1] == 0) {
+            slot[0] = slot[1] = 0;
+            continue;
+        }
+        free_offset -= slot[1];
+        std::memcpy(raw + free_offset, copy + slot[0], slot[1]);
+        slot[0] = static_cast<uint16_t>(free_offset);
+        slot_count = i + 1;
+    }
+    *slot_count_ptr = slot_count;
+    *reinterpret_cast<uint16_t*>(raw + FREE_OFFSET_POS) = static_cast<uint16_t>(free_offset);
+}
+
+TableHeap::TableHeap(BufferPoolManager* bpm, LogManager* log)
+    : bpm_(bpm), log_(log), fsm_(bpm) {
     Page* page = bpm_->new_page(first_page_id_);
     if (!page) {
         throw std::runtime_error("Failed to allocate first table page");
     }
+    page->w_latch();
+    init_heap_page(page);
+    log_change(page, LogRecord::new_page(first_page_id_, LogRecord::NO_PAGE), nullptr);
+    size_t avail = free_space(page->data());
+    page->w_unlatch();
+    bpm_->unpin_page(first_page_id_, true);
 
-    // Zero out the page and initialize slot metadata
-    std::memset(page->data(), 0, Page::PAGE_SIZE);
+    last_page_id_ = first_page_id_;
+    chain_.push_back(first_page_id_);
+    fsm_.add_page(first_page_id_, avail);
+}
 
-    // Initialize header: free offset = end of page, slot count = 0
-    uint16_t* free_offset_ptr = reinterpret_cast<uint16_t*>(page->data());
-    uint16_t* slot_count_ptr = reinterpret_cast<uint16_t*>(page->data() + 2);
-    *free_offset_ptr = Page::PAGE_SIZE;
-    *slot_count_ptr = 0;
+TableHeap::TableHeap(BufferPoolManager* bpm, LogManager* log, uint32_t first_page_id, uint32_t fsm_root)
+    : bpm_(bpm), log_(log), first_page_id_(first_page_id), last_page_id_(first_page_id), fsm_(bpm, fsm_root, true) {
+    // Walk the chain once for the page list and the free-space map
+    for (uint32_t page_id = first_page_id; page_id != FreeSpaceMap::INVALID_PAGE;) {
+        Page* page = bpm_->fetch_page(page_id);
+        if (!page) throw std::runtime_error("Failed to fetch table page");
+        page->r_latch();
+        const std::byte* raw = page->data();
+        size_t avail = reclaimable(raw);
+        uint32_t next = *reinterpret_cast<const uint32_t*>(raw + NEXT_PAGE_POS);
+        uint16_t slot_count = *reinterpret_cast<const uint16_t*>(raw + SLOT_COUNT_POS);
+        for (uint16_t i = 0; i < slot_count; ++i) {
+            const uint16_t* slot = reinterpret_cast<const uint16_t*>(raw + SLOT_ARRAY_POS + i * SLOT_ENTRY_SIZE);
+            if (slot[0] != 0 && slot[1] != 0) ++rows_;
+        }
+        page->r_unlatch();
+        bpm_->unpin_page(page_id, false);
 
-    bpm_->unpin_page(first_page_id_, true);
+        chain_.push_back(page_id);
+        fsm_.add_page(page_id, avail);
+        last_page_id_ = page_id;
+        page_id = next;
+    }
 }
 
-bool TableHeap::insert_tuple(const Tuple& tuple, RID& rid) {
-    Page* page = bpm_->fetch_page(first_page_id_);
-    if (!page) return false;
+TableHeap::TableHeap(BufferPoolManager* bpm, LogManager* log, uint32_t first_page_id, uint32_t fsm_root, size_t rows)
+    : bpm_(bpm), log_(log), first_page_id_(first_page_id), fsm_(bpm, fsm_root), chain_(fsm_.heap_pages()), rows_(rows) {
+    if (chain_.empty() || chain_.front() != first_page_id) {
+        throw std::runtime_error("free-space map does not belong to this table");
+    }
+    last_page_id_ = chain_.back();
+}
+
+uint32_t TableHeap::append_page() {
+    uint32_t new_id;
+    Page* page = bpm_->new_page(new_id);
+    if (!page) throw std::runtime_error("Failed to allocate table page");
+    page->w_latch();
+    init_heap_page(page);
+    // Dirty from before its NEW_PAGE record, for checkpoints in between
+    if (log_) page->note_change(log_->last_lsn() + 1);
+    size_t avail = free_space(page->data());
+    page->w_unlatch();
+    bpm_->unpin_page(new_id, true);
+
+    // Link the old tail to the new page; one record covers both pages
+    Page* tail = bpm_->fetch_page(last_page_id_);
+    if (!tail) throw std::runtime_error("Failed to fetch tail page");
+    tail->w_latch();
+    *reinterpret_cast<uint32_t*>(tail->data() + NEXT_PAGE_POS) = new_id;
+    log_change(tail, LogRecord::new_page(new_id, last_page_id_), nullptr);
+    lsn_t lsn = tail->get_lsn();
+    tail->w_unlatch();
+    bpm_->unpin_page(last_page_id_, true);
+
+    // One page pinned at a time. Unlinked until now, the new page could be
+    // written without its record; redo formats it again anyway.
+    if (log_) {
+        page = bpm_->fetch_page(new_id);
+        page->w_latch();
+        page->set_lsn(lsn);
+        page->w_unlatch();
+        bpm_->unpin_page(new_id, true);
+    }
+
+    last_page_id_ = new_id;
+    chain_.push_back(new_id);
+    fsm_.add_page(new_id, avail);
+    return new_id;
+}
 
+void TableHeap::log_change(Page* page, LogRecord rec, Txn* txn) {
+    if (!log_) return;
+    page->note_change(log_->last_lsn() + 1);     // a lower bound for rec's LSN
+    page->set_lsn(log_->append(rec, txn));
+}
+
+void TableHeap::redo(Page* page, const LogRecord& rec) {
     std::byte* raw = page->data();
-    uint16_t* free_offset_ptr = reinterpret_cast<uint16_t*>(raw);
-    uint16_t* slot_count_ptr = reinterpret_cast<uint16_t*>(raw + 2);
+    uint16_t slot_count = *reinterpret_cast<const uint16_t*>(raw + SLOT_COUNT_POS);
+    uint16_t* slot_entry = reinterpret_cast<uint16_t*>(raw + SLOT_ARRAY_POS + rec.rid.slot_id() * SLOT_ENTRY_SIZE);
+    switch (rec.type) {
+    case LogType::NEW_PAGE:
+        if (page->get_page_id() == rec.rid.page_id()) init_heap_page(page);
+        else *reinterpret_cast<uint32_t*>(raw + NEXT_PAGE_POS) = rec.rid.page_id();   // the previous tail
+        return;
+    case LogType::INSERT:
+        // Inserts take the first free slot, so the row lands where it did before
+        if (rec.rid.slot_id() != free_slot(raw) ||
+            free_space(raw) < rec.tuple.size() + (rec.rid.slot_id() == slot_count ? SLOT_ENTRY_SIZE : 0)) break;
+        place_tuple(raw, rec.rid.slot_id(), rec.tuple.data(), rec.tuple.size());
+        return;
+    case LogType::MARK_DELETE:
+        if (rec.rid.slot_id() >= slot_count) break;
+        slot_entry[1] = 0;
+        return;
+    case LogType::CLR:
+        if (rec.rid.slot_id() >= slot_count) break;
+        slot_entry[1] = rec.undone == LogType::INSERT ? 0 : static_cast<uint16_t>(rec.tuple.size());
+        return;
+    case LogType::COMPACT:
+        compact_page(raw);
+        return;
+    default:
+        break;
+    }
+    throw std::runtime_error("log record does not match heap page " + std::to_string(page->get_page_id()));
+}
 
+bool TableHeap::insert_tuple(TupleView tuple, RID& rid, Txn* txn) {
     size_t tuple_size = tuple.size();
     size_t required_space = tuple_size + SLOT_ENTRY_SIZE;
+    if (required_space > Page::PAGE_SIZE - SLOT_ARRAY_POS) return false; // can never fit
 
-    size_t slot_array_end = 4 + (*slot_count_ptr) * SLOT_ENTRY_SIZE;
+    // Serializes page choice, FSM updates and chain growth for this table
+    std::lock_guard<std::mutex> lk(insert_latch_);
+    for (;;) {
+        uint32_t page_id = fsm_.find_page(required_space);
+        if (page_id == FreeSpaceMap::INVALID_PAGE) page_id = append_page();
 
-    if (*free_offset_ptr < slot_array_end + tuple_size) {
-        bpm_->unpin_page(first_page_id_, false);
-        return false; // Not enough space
-    }
+        Page* page = bpm_->fetch_page(page_id);
+        if (!page) return false;
+        page->w_latch();
 
-    // Insert tuple data at end of page (backward growth)
-    *free_offset_ptr -= tuple_size;
-    std::memcpy(reinterpret_cast<void*>(raw + *free_offset_ptr), tuple.data(), tuple_size);
+        // The map counts deleted rows as free: get their space back first
+        std::byte* raw = page->data();
+        if (free_space(raw) < required_space && reclaimable(raw) >= required_space && can_compact(page)) {
+            compact_page(raw);
+            log_change(page, LogRecord::compact(page_id), nullptr);
+        }
+        if (free_space(raw) < required_space) {
+            // Not yet: the map keeps only what the page has in one piece,
+            // which is too little for this row, so the next lookup moves on
+            size_t avail = free_space(raw);
+            page->w_unlatch();
+            bpm_->unpin_page(page_id, false);
+            fsm_.update(page_id, avail);
+            continue;
+        }
 
-    // Write slot entry (forward from front): offset and size
-    uint16_t* slot_entry = reinterpret_cast<uint16_t*>(raw + 4 + (*slot_count_ptr) * SLOT_ENTRY_SIZE);
-    slot_entry[0] = *free_offset_ptr;               // tuple offset
-    slot_entry[1] = static_cast<uint16_t>(tuple_size);
+        rid = RID(page_id, place_tuple(raw, free_slot(raw), tuple.data(), tuple_size));
+        log_change(page, LogRecord::insert(rid, tuple.data(), tuple_size), txn);
+        ++rows_;
+        size_t avail = reclaimable(raw);
+        page->w_unlatch();
+        bpm_->unpin_page(page_id, true);
 
-    // Set RID
-    rid = RID(first_page_id_, *slot_count_ptr);
+        fsm_.update(page_id, avail);
+        return true;
+    }
+}
 
-    (*slot_count_ptr)++;
-    bpm_->unpin_page(first_page_id_, true);
+bool TableHeap::can_compact(Page* page) {
+    // A TupleView may point into a page someone else has pinned
+    if (bpm_->pin_count(page->get_page_id()) != 1) return false;
+    if (!log_) return true;
+    // A transaction that began before the page's last change may have
+    // deleted a row here and need its bytes back for undo
+    for (const ActiveTxn& t : log_->active_txns()) {
+        if (t.first_lsn <= page->get_lsn()) return false;
+    }
     return true;
 }
+
 bool TableHeap::get_tuple(const RID& rid, Tuple& tuple) {
-    // 1. Fetch the page
+    PageGuard guard;
+    TupleView view;
+    if (!get_tuple(rid, view, guard)) return false;
+    tuple = Tuple(view);
+    return true;
+}
+
+bool TableHeap::get_tuple(const RID& rid, TupleView& view, PageGuard& guard) {
+    if (!guard || guard.page_id() != rid.page_id()) {
+        guard = PageGuard(bpm_, rid.page_id());
+        if (!guard) return false;
+    }
+    const std::byte* data = guard->data();
+    guard->r_latch();
+    // Each slot entry: [offset (2 bytes), size (2 bytes)]
+    uint16_t slot_count = *reinterpret_cast<const uint16_t*>(data + SLOT_COUNT_POS);
+    const uint16_t* slot_entry = reinterpret_cast<const uint16_t*>(data + SLOT_ARRAY_POS + rid.slot_id() * SLOT_ENTRY_SIZE);
+    bool live = rid.slot_id() < slot_count && slot_entry[0] != 0 && slot_entry[1] != 0;
+    if (live) view = TupleView(data + slot_entry[0], slot_entry[1]);
+    guard->r_unlatch();
+    return live;
+}
+
+bool TableHeap::delete_tuple(const RID& rid, Txn* txn) {
     Page* page = bpm_->fetch_page(rid.page_id());
     if (!page) return false;
+    page->w_latch();
+    auto* data = page->data();
+    uint16_t* slot = reinterpret_cast<uint16_t*>(data + SLOT_ARRAY_POS + rid.slot_id() * SLOT_ENTRY_SIZE);
+    // The old image goes to the log, so the delete can be undone
+    if (slot[0] != 0 && slot[1] != 0) {
+        log_change(page, LogRecord::mark_delete(rid, data + slot[0], slot[1]), txn);
+        --rows_;
+    }
+    slot[1] = 0;          // mark empty; the offset stays so that undo can restore the row
+    size_t avail = reclaimable(data);
+    page->w_unlatch();
+    bpm_->unpin_page(rid.page_id(), true);
 
-    std::byte* data = page->data();
+    // The next insert that picks this page compacts it
+    std::lock_guard<std::mutex> lk(insert_latch_);
+    fsm_.update(rid.page_id(), avail);
+    return true;
+}
 
-    // 2. Read slot directory
-    uint16_t slot_count = *reinterpret_cast<uint16_t*>(data + 2);
-    if (rid.slot_id() >= slot_count) {
-        bpm_->unpin_page(rid.page_id(), false);
-        return false; // Invalid slot
-    }
+uint32_t TableHeap::next_page(uint32_t page_id) {
+    Page* page = bpm_->fetch_page(page_id);
+    if (!page) throw std::runtime_error("Failed to fetch table page");
+    page->r_latch();
+    uint32_t next = *reinterpret_cast<const uint32_t*>(page->data() + NEXT_PAGE_POS);
+    page->r_unlatch();
+    bpm_->unpin_page(page_id, false);
+    return next;
+}
 
-    // Each slot entry: [offset (2 bytes), size (2 bytes)]
-    uint16_t* slot_entry = reinterpret_cast<uint16_t*>(data + 4 + rid.slot_id() * 4);
-    uint16_t tuple_offset = slot_entry[0];
-    uint16_t tuple_size = slot_entry[1];
+std::vector<uint32_t> TableHeap::chain_pages(size_t pos, size_t count) {
+    std::lock_guard<std::mutex> lk(insert_latch_);
+    if (pos >= chain_.size()) return {};
+    auto first = chain_.begin() + pos;
+    return std::vector<uint32_t>(first, first + std::min(count, chain_.size() - pos));
+}
+
+TableIterator TableHeap::scan() {
+    return TableIterator(this, first_page_id_);
+}
 
-    if (tuple_offset == 0 || tuple_size == 0) {
-        bpm_->unpin_page(rid.page_id(), false);
-        return false; // Deleted or empty slot
+TableIterator TableHeap::scan(size_t pos) {
+    uint32_t page_id = FreeSpaceMap::INVALID_PAGE;
+    {
+        std::lock_guard<std::mutex> lk(insert_latch_);
+        if (pos < chain_.size()) page_id = chain_[pos];
     }
+    return TableIterator(this, page_id, pos);
+}
+
+/* ---------- Appender ---------- */
+
+TableHeap::Appender::Appender(TableHeap& heap, Txn* txn)
+    : heap_(heap), txn_(txn), lk_(heap.insert_latch_), first_pos_(heap.chain_.size()) {}
 
-    // 3. Copy tuple data
-    tuple = Tuple(reinterpret_cast<const std::byte*>(data + tuple_offset), tuple_size);
+bool TableHeap::Appender::append(TupleView tuple, RID& rid) {
+    size_t required_space = tuple.size() + SLOT_ENTRY_SIZE;
+    if (required_space > Page::PAGE_SIZE - SLOT_ARRAY_POS) return false; // can never fit
+    if (!page_ || free_space(page_->data()) < required_space) next_page();
 
-    bpm_->unpin_page(rid.page_id(), false);
+    // A page of its own, so the slots fill in order
+    uint16_t slot_id = *reinterpret_cast<const uint16_t*>(page_->data() + SLOT_COUNT_POS);
+    rid = RID(page_id_, place_tuple(page_->data(), slot_id, tuple.data(), tuple.size()));
+    heap_.log_change(page_, LogRecord::insert(rid, tuple.data(), tuple.size()), txn_);
+    ++heap_.rows_;
+    ++rows_;
     return true;
 }
-// table_heap.cpp
-bool TableHeap::delete_tuple(const RID& rid) {
-    Page* page = bpm_->fetch_page(rid.page_id());
-    if (!page) return false;
-    auto* data = page->data();
-    uint16_t* slot = reinterpret_cast<uint16_t*>(data + 4 + rid.slot_id() * 4);
-    slot[0] = slot[1] = 0;          // mark empty
-    bpm_->unpin_page(rid.page_id(), true);
-    return true;
+
+// The full page goes back to the pool and the map; the next one is the
+// tail if nothing was ever put there (a new table's first page), else new
+void TableHeap::Appender::next_page() {
+    uint32_t page_id;
+    if (page_) {
+        release_page();
+        page_id = heap_.append_page();
+    } else {
+        page_id = heap_.last_page_id_;
+        Page* tail = heap_.bpm_->fetch_page(page_id);
+        if (!tail) throw std::runtime_error("Failed to fetch tail page");
+        bool empty = *reinterpret_cast<const uint16_t*>(tail->data() + SLOT_COUNT_POS) == 0;
+        heap_.bpm_->unpin_page(page_id, false);
+        if (empty) first_pos_ = heap_.chain_.size() - 1;
+        else page_id = heap_.append_page();
+    }
+
+    page_ = heap_.bpm_->fetch_page(page_id);
+    if (!page_) throw std::runtime_error("Failed to fetch table page");
+    page_id_ = page_id;
+    page_->w_latch();
+}
+
+void TableHeap::Appender::release_page() {
+    size_t avail = free_space(page_->data());
+    page_->w_unlatch();
+    heap_.bpm_->unpin_page(page_id_, true);
+    heap_.fsm_.update(page_id_, avail);
+    page_ = nullptr;
+}
+
+void TableHeap::Appender::finish() {
+    if (page_) release_page();
+    if (lk_.owns_lock()) lk_.unlock();
+}
+
+/* ---------- TableIterator ---------- */
+
+TableIterator::TableIterator(TableHeap* heap, uint32_t page_id)
+    : TableIterator(heap, page_id, 0) {}
+
+TableIterator::TableIterator(TableHeap* heap, uint32_t page_id, size_t pos)
+    : heap_(heap), page_id_(page_id), pos_(pos), ra_next_(pos + 1), ra_mark_(pos) {
+    pin(page_id);
+}
+
+void TableIterator::pin(uint32_t page_id) {
+    page_id_ = page_id;
+    slot_ = 0;
+    page_.reset();
+    if (page_id == FreeSpaceMap::INVALID_PAGE) return;
+    readahead();
+    page_ = PageGuard(heap_->bpm_, page_id);
+    if (!page_) throw std::runtime_error("Failed to fetch table page");
+}
+
+void TableIterator::readahead() {
+    if (pos_ < ra_mark_) return;
+    size_t limit = std::clamp<size_t>(heap_->bpm_->pool_size() / 4, 1, MAX_READAHEAD);
+    ra_window_ = std::min(ra_window_ ? ra_window_ * 2 : MIN_READAHEAD, limit);
+
+    std::vector<uint32_t> ids = heap_->chain_pages(ra_next_, ra_window_);
+    if (ids.empty()) {
+        ra_mark_ = SIZE_MAX;             // caught up with the tail
+        return;
+    }
+    if (heap_->bpm_->prefetch(ids) == 0) ra_window_ = 0;   // cached: start small again
+    ra_next_ += ids.size();
+    ra_mark_ = ra_next_ - 1;
 }
 
+bool TableIterator::next(TupleView& tuple, RID& rid) {
+    while (page_) {
+        const std::byte* raw = page_->data();
+        page_->r_latch();
+        uint16_t slot_count = *reinterpret_cast<const uint16_t*>(raw + SLOT_COUNT_POS);
+
+        while (slot_ < slot_count) {
+            const uint16_t* slot_entry = reinterpret_cast<const uint16_t*>(raw + SLOT_ARRAY_POS + slot_ * SLOT_ENTRY_SIZE);
+            uint16_t slot_id = slot_++;
+            if (slot_entry[0] == 0 || slot_entry[1] == 0) continue;   // skip deleted / empty
+            tuple = TupleView(raw + slot_entry[0], slot_entry[1]);
+            page_->r_unlatch();
+            rid = RID(page_id_, slot_id);
+            return true;
+        }
 
+        // Page exhausted: move along the chain
+        uint32_t next = *reinterpret_cast<const uint32_t*>(raw + NEXT_PAGE_POS);
+        page_->r_unlatch();
+        ++pos_;
+        pin(next);
+    }
+    return false;
+}
 
+bool TableIterator::next(Tuple& tuple, RID& rid) {
+    TupleView view;
+    if (!next(view, rid)) return false;
+    tuple = Tuple(view);
+    return true;
+}
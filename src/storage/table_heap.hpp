@@ -1,22 +1,182 @@
 #pragma once
 
 #include "buffer_pool_manager.hpp"
+#include "free_space_map.hpp"
+#include "page_guard.hpp"
+#include "recovery/log_manager.hpp"
 #include "tuple.hpp"
 #include "rid.hpp"
+#include <atomic>
 #include <optional>
+#include <mutex>
 
+class TableIterator;
+
+/*
+ * Heap file: a chain of slotted pages.
+ *
+ * With a LogManager every change to a heap page is logged before the page
+ * latch is released, and the page takes the record's LSN: INSERT and
+ * MARK_DELETE as part of the caller's transaction (a system record if
+ * txn is null), NEW_PAGE as a system record when the chain grows. The
+ * free-space map is not logged; it can be rebuilt from the heap pages.
+ * Deleting a row only zeroes its slot's size, so undo can bring it back,
+ * and hands the row's bytes to the free-space map. The insert that next
+ * picks the page compacts it (a COMPACT system record): live tuples move
+ * together and deleted rows' slots are freed for reuse. That waits until
+ * nobody else has the page pinned and no transaction still running could
+ * have deleted anything on it, so a TupleView into a page is good for as
+ * long as the page stays pinned and undo always finds the deleted bytes.
+ * Restart recovery replays records through redo().
+ */
 class TableHeap {
 public:
-    explicit TableHeap(BufferPoolManager* bpm);
+    class Appender;
+
+    explicit TableHeap(BufferPoolManager* bpm, LogManager* log = nullptr);
+    // Open the heap whose chain starts at first_page_id: reads every page
+    // to count the rows and fill its free-space map again, over the pages
+    // the map rooted at fsm_root already has
+    TableHeap(BufferPoolManager* bpm, LogManager* log, uint32_t first_page_id, uint32_t fsm_root);
+    // Open it from its free-space map, which lists the chain, without
+    // reading any heap page; rows as counted when it was last closed
+    TableHeap(BufferPoolManager* bpm, LogManager* log, uint32_t first_page_id, uint32_t fsm_root, size_t rows);
 
     // Inserts tuple into the table
-    bool insert_tuple(const Tuple& tuple, RID& rid);
+    bool insert_tuple(const Tuple& tuple, RID& rid, Txn* txn = nullptr) { return insert_tuple(tuple.view(), rid, txn); }
+    bool insert_tuple(TupleView tuple, RID& rid, Txn* txn = nullptr);
     bool get_tuple(const RID& rid, Tuple& tuple);
-    // table_heap.hpp
-    bool delete_tuple(const RID& rid);          // NEW
+    // The tuple in place: guard ends up holding rid's page (kept if it
+    // already does) and view points into it. False if the slot is empty.
+    bool get_tuple(const RID& rid, TupleView& view, PageGuard& guard);
+    bool delete_tuple(const RID& rid, Txn* txn = nullptr);
     uint32_t first_page() const { return first_page_id_; }   // one-liner
-    friend class QueryExecutor;
+    uint32_t fsm_root() const { return fsm_.root_page(); }
+    size_t row_count() const { return rows_.load(); }          // live rows
+
+    // Cursor over every live tuple, following the page chain
+    TableIterator scan();
+    // The same from chain position pos on
+    TableIterator scan(size_t pos);
+
+    // Next page in the chain (FreeSpaceMap::INVALID_PAGE at the tail)
+    uint32_t next_page(uint32_t page_id);
+
+    // Up to count page ids of the chain starting at position pos (0 = first
+    // page), without touching the pages themselves
+    std::vector<uint32_t> chain_pages(size_t pos, size_t count);
+
+    // Recovery: apply a logged change (INSERT, MARK_DELETE, NEW_PAGE, CLR,
+    // COMPACT) again to page, one of the pages it changed, write-latched by the
+    // caller. Throws if the page cannot have come before the record.
+    static void redo(Page* page, const LogRecord& rec);
+
+    friend class TableIterator;
+    friend class Appender;
 private:
+    // Allocate, format and link a new page at the tail of the chain
+    uint32_t append_page();
+
+    // Log a change to page (write-latched by the caller) and stamp its LSN
+    void log_change(Page* page, LogRecord rec, Txn* txn);
+
+    // Whether page (pinned and write-latched by the caller) may have its
+    // tuples moved: no other pin, no running transaction touched it
+    bool can_compact(Page* page);
+
     BufferPoolManager* bpm_;
+    LogManager* log_;
     uint32_t first_page_id_;
+    uint32_t last_page_id_;
+    FreeSpaceMap fsm_;
+    std::vector<uint32_t> chain_;    // every page id, in chain order
+    std::atomic<size_t> rows_{ 0 };
+    std::mutex insert_latch_;        // guards fsm_, last_page_id_ and chain_
+};
+
+/*
+ * Bulk append, for loads: rows go onto fresh pages at the tail of the
+ * chain, bypassing the free-space map. The page being filled stays pinned
+ * and write-latched until it is full, so it costs one fetch and the pool
+ * never writes it half filled; the map hears of it once it is done. Each
+ * row is still logged as an INSERT of txn. Holds the heap's insert latch
+ * until finish(), so other inserts into the table wait.
+ *
+ *   TableHeap::Appender app(heap, &txn);
+ *   while (...) app.append(row, rid);
+ *   app.finish();
+ *   auto it = heap.scan(app.first_pos());   // just the appended rows
+ */
+class TableHeap::Appender {
+public:
+    Appender(TableHeap& heap, Txn* txn);
+    ~Appender() { finish(); }
+
+    Appender(const Appender&) = delete;
+    Appender& operator=(const Appender&) = delete;
+
+    // False if the tuple can never fit in a page
+    bool append(TupleView tuple, RID& rid);
+    // Release the last page and the insert latch; appending ends here
+    void finish();
+
+    size_t rows() const { return rows_; }
+    // Chain position of the first page appended
+    size_t first_pos() const { return first_pos_; }
+
+private:
+    void next_page();
+    void release_page();
+
+    TableHeap&                   heap_;
+    Txn*                         txn_;
+    std::unique_lock<std::mutex> lk_;
+    Page*                        page_ = nullptr;   // being filled
+    uint32_t                     page_id_ = FreeSpaceMap::INVALID_PAGE;
+    size_t                       first_pos_;
+    size_t                       rows_ = 0;
+};
+
+/*
+ * Forward scan over the heap. Keeps the current page pinned between calls,
+ * so a TupleView it returned stays valid until the scan leaves that page.
+ *
+ * Reads ahead along the chain. When the scan reaches the last page of the
+ * current readahead window it prefetches the next window. The window
+ * starts at MIN_READAHEAD pages and doubles while the scan keeps going, up
+ * to a quarter of the pool. It drops back to MIN_READAHEAD when a window
+ * turns out to be resident already. A scan that stops early has only fetched one small
+ * window too many.
+ */
+class TableIterator {
+public:
+    static constexpr size_t MIN_READAHEAD = 4;
+    static constexpr size_t MAX_READAHEAD = 64;
+
+    TableIterator(TableHeap* heap, uint32_t page_id);
+    // Starting at page_id, which is at chain position pos
+    TableIterator(TableHeap* heap, uint32_t page_id, size_t pos);
+
+    TableIterator(const TableIterator&) = delete;
+    TableIterator& operator=(const TableIterator&) = delete;
+
+    // The next live tuple in place, valid until the following call; false
+    // once the chain is exhausted
+    bool next(TupleView& tuple, RID& rid);
+    // The same, copied out
+    bool next(Tuple& tuple, RID& rid);
+
+private:
+    void pin(uint32_t page_id);
+    void readahead();
+
+    TableHeap* heap_;
+    uint32_t   page_id_;
+    PageGuard  page_;
+    uint16_t   slot_ = 0;
+
+    size_t     pos_ = 0;            // chain position of page_id_
+    size_t     ra_next_ = 1;        // first chain position not prefetched yet
+    size_t     ra_mark_ = 0;        // position that triggers the next window
+    size_t     ra_window_ = 0;
 };
@@ -6,10 +6,31 @@
 #include <cstring>   // memcpy
 #include <stdexcept>
 
+// A tuple's bytes where they already are, typically inside a pinned page
+// (see PageGuard). Copies nothing and is only valid as long as the bytes are.
+class TupleView {
+public:
+    TupleView() = default;
+    TupleView(const std::byte* data, size_t size) : data_(data), size_(size) {}
+
+    const std::byte* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const std::byte* data_ = nullptr;
+    size_t           size_ = 0;
+};
+
 class Tuple {
 public:
     Tuple() = default;
 
+    // size zero bytes, to be written through data()
+    explicit Tuple(size_t size) : data_(size) {}
+
+    // Copy of the viewed bytes
+    explicit Tuple(TupleView v) : Tuple(v.data(), v.size()) {}
+
     // Construct from raw bytes pointer
     Tuple(const std::byte* data, size_t size) {
         assign(data, data + size);
@@ -33,12 +54,15 @@ public:
     const std::byte* data() const {
         return data_.data();
     }
+    std::byte* data() { return data_.data(); }
 
     // Size of the tuple data
     size_t size() const {
         return data_.size();
     }
 
+    TupleView view() const { return TupleView(data_.data(), data_.size()); }
+
     // Convert tuple content to std::string (for debugging / text data)
     std::string to_string() const {
         return std::string(reinterpret_cast<const char*>(data_.data()), data_.size());
@@ -0,0 +1,201 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "replacer.hpp"
+
+/*
+ * 2Q replacer (Johnson & Shasha, full version).
+ *
+ * Newly loaded pages enter A1in, a FIFO holding about a quarter of the
+ * pool. When an A1in page is evicted its id is remembered in the ghost
+ * queue A1out; if it is loaded again while still remembered it goes to Am,
+ * an LRU list for pages with proven reuse. A page re-referenced while
+ * still in A1in is promoted too, unless the re-reference falls inside the
+ * correlation window (fewer than Kin accesses since it was loaded). A scan
+ * therefore only churns A1in and leaves the hot pages in Am alone.
+ *
+ * Both resident queues are intrusive doubly-linked lists over per-frame
+ * arrays and only hold evictable frames.
+ */
+class TwoQueueReplacer : public Replacer {
+public:
+    explicit TwoQueueReplacer(size_t capacity)
+        : kin_(std::max<size_t>(1, capacity / 4)),
+        kout_(std::max<size_t>(1, capacity / 2)),
+        prev_(capacity, NIL), next_(capacity, NIL),
+        queue_(capacity, A1IN), fresh_(capacity, true), cold_(capacity, false),
+        evictable_(capacity, false), page_(capacity, 0), loaded_at_(capacity, 0),
+        ghost_(kout_, NO_PAGE) {
+    }
+
+    void record_access(size_t frame_id, uint32_t page_id) override {
+        std::lock_guard<std::mutex> lk(latch_);
+        ++tick_;
+        page_[frame_id] = page_id;
+        if (fresh_[frame_id]) {
+            // First access since the page was loaded: decide its queue
+            fresh_[frame_id] = false;
+            if (cold_[frame_id]) {
+                cold_[frame_id] = false;
+                --resident_[queue_[frame_id]];
+            }
+            loaded_at_[frame_id] = tick_;
+            auto g = ghost_pos_.find(page_id);
+            if (g != ghost_pos_.end()) {
+                ghost_pos_.erase(g);
+                set_queue(frame_id, AM);
+            }
+            else {
+                set_queue(frame_id, A1IN);
+            }
+        }
+        else if (queue_[frame_id] == A1IN) {
+            // Correlated re-references (right after the load) do not count
+            if (tick_ - loaded_at_[frame_id] > kin_) move_queue(frame_id, AM);
+        }
+        else if (evictable_[frame_id]) {
+            unlink(frame_id);                  // LRU refresh
+            push_front(frame_id);
+        }
+    }
+
+    void insert(size_t frame_id) override {
+        std::lock_guard<std::mutex> lk(latch_);
+        if (evictable_[frame_id]) return;
+        evictable_[frame_id] = true;
+        push_front(frame_id);
+    }
+
+    // Readahead pages wait at the A1in tail. They stay fresh, so their
+    // first real access files them as if they had just been loaded.
+    void insert_cold(size_t frame_id, uint32_t page_id) override {
+        std::lock_guard<std::mutex> lk(latch_);
+        if (evictable_[frame_id]) return;
+        page_[frame_id] = page_id;
+        queue_[frame_id] = A1IN;
+        cold_[frame_id] = true;
+        ++resident_[A1IN];
+        evictable_[frame_id] = true;
+        push_back(frame_id);
+    }
+
+    bool erase(size_t frame_id) override {
+        std::lock_guard<std::mutex> lk(latch_);
+        if (!evictable_[frame_id]) return false;
+        unlink(frame_id);
+        evictable_[frame_id] = false;
+        return true;
+    }
+
+    bool victim(size_t& frame_id) override {
+        std::lock_guard<std::mutex> lk(latch_);
+        int q;
+        if (tail_[A1IN] != NIL && (resident_[A1IN] > kin_ || tail_[AM] == NIL)) q = A1IN;
+        else if (tail_[AM] != NIL) q = AM;
+        else return false;
+
+        frame_id = tail_[q];
+        unlink(frame_id);
+        evictable_[frame_id] = false;
+        return true;
+    }
+
+    // The frame stays counted in its queue until its page is really gone:
+    // a victim the pool finds re-pinned is then just an accessed frame
+    void forget(size_t frame_id) override {
+        std::lock_guard<std::mutex> lk(latch_);
+        int q = queue_[frame_id];
+        --resident_[q];
+        fresh_[frame_id] = true;
+        // Never-used readahead pages prove nothing about reuse
+        if (q == A1IN && !cold_[frame_id]) remember(page_[frame_id]);
+        cold_[frame_id] = false;
+    }
+
+    size_t size() const override {
+        std::lock_guard<std::mutex> lk(latch_);
+        return size_;
+    }
+
+private:
+    static constexpr size_t NIL = SIZE_MAX;
+    static constexpr uint32_t NO_PAGE = UINT32_MAX;
+    enum : int { A1IN = 0, AM = 1 };
+
+    // Assign a newly loaded frame to queue q
+    void set_queue(size_t frame_id, int q) {
+        bool linked = evictable_[frame_id];
+        if (linked) unlink(frame_id);
+        queue_[frame_id] = q;
+        ++resident_[q];
+        if (linked) push_front(frame_id);
+    }
+
+    // Move a resident frame between queues
+    void move_queue(size_t frame_id, int q) {
+        --resident_[queue_[frame_id]];
+        set_queue(frame_id, q);
+    }
+
+    void push_front(size_t f) {
+        int q = queue_[f];
+        prev_[f] = NIL;
+        next_[f] = head_[q];
+        if (head_[q] != NIL) prev_[head_[q]] = f;
+        head_[q] = f;
+        if (tail_[q] == NIL) tail_[q] = f;
+        ++size_;
+    }
+
+    void push_back(size_t f) {
+        int q = queue_[f];
+        next_[f] = NIL;
+        prev_[f] = tail_[q];
+        if (tail_[q] != NIL) next_[tail_[q]] = f;
+        tail_[q] = f;
+        if (head_[q] == NIL) head_[q] = f;
+        ++size_;
+    }
+
+    void unlink(size_t f) {
+        int q = queue_[f];
+        if (prev_[f] != NIL) next_[prev_[f]] = next_[f]; else head_[q] = next_[f];
+        if (next_[f] != NIL) prev_[next_[f]] = prev_[f]; else tail_[q] = prev_[f];
+        prev_[f] = next_[f] = NIL;
+        --size_;
+    }
+
+    // A1out: fixed-size ring of page ids evicted from A1in
+    void remember(uint32_t page_id) {
+        uint32_t old = ghost_[ghost_head_];
+        if (old != NO_PAGE) {
+            auto it = ghost_pos_.find(old);
+            if (it != ghost_pos_.end() && it->second == ghost_head_) ghost_pos_.erase(it);
+        }
+        ghost_[ghost_head_] = page_id;
+        ghost_pos_[page_id] = ghost_head_;
+        ghost_head_ = (ghost_head_ + 1) % kout_;
+    }
+
+    size_t kin_, kout_;
+    mutable std::mutex latch_;
+    std::vector<size_t> prev_, next_;
+    std::vector<int> queue_;
+    std::vector<bool> fresh_;              // no access recorded since load
+    std::vector<bool> cold_;               // queued by insert_cold, never accessed
+    std::vector<bool> evictable_;
+    std::vector<uint32_t> page_;
+    std::vector<uint64_t> loaded_at_;      // tick of the first access after load
+    uint64_t tick_ = 0;
+    size_t head_[2] = { NIL, NIL };
+    size_t tail_[2] = { NIL, NIL };
+    size_t resident_[2] = { 0, 0 };        // frames per queue, pinned or not
+    size_t size_ = 0;                      // evictable frames
+
+    std::vector<uint32_t> ghost_;
+    std::unordered_map<uint32_t, size_t> ghost_pos_;
+    size_t ghost_head_ = 0;
+};
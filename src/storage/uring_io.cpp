@@ -0,0 +1,202 @@
+#include "uring_io.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static int uring_setup(unsigned entries, io_uring_params* p) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, p));
+}
+
+static int uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+template <typename T>
+static T* at(void* base, unsigned offset) {
+    return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+}
+
+static unsigned load_acquire(unsigned* p) {
+    return std::atomic_ref<unsigned>(*p).load(std::memory_order_acquire);
+}
+
+static void store_release(unsigned* p, unsigned v) {
+    std::atomic_ref<unsigned>(*p).store(v, std::memory_order_release);
+}
+
+IoUringIO::IoUringIO(int fd, bool direct)
+    : PosixIO(fd, direct) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    ring_fd_ = uring_setup(QUEUE_DEPTH, &params);
+    if (ring_fd_ < 0) {
+        throw std::runtime_error(std::string("io_uring_setup failed: ") + std::strerror(errno));
+    }
+    sq_entries_ = params.sq_entries;
+    cq_entries_ = params.cq_entries;
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+
+    sq_ptr_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ptr_ == MAP_FAILED) { ::close(ring_fd_); throw std::runtime_error("io_uring SQ mmap failed"); }
+
+    cq_ptr_ = single_mmap ? sq_ptr_
+        : ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            ring_fd_, IORING_OFF_CQ_RING);
+    if (cq_ptr_ == MAP_FAILED) {
+        ::munmap(sq_ptr_, sq_ring_size_);
+        ::close(ring_fd_);
+        throw std::runtime_error("io_uring CQ mmap failed");
+    }
+
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        ring_fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        if (!single_mmap) ::munmap(cq_ptr_, cq_ring_size_);
+        ::munmap(sq_ptr_, sq_ring_size_);
+        ::close(ring_fd_);
+        throw std::runtime_error("io_uring SQE mmap failed");
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    sq_head_ = at<unsigned>(sq_ptr_, params.sq_off.head);
+    sq_tail_ = at<unsigned>(sq_ptr_, params.sq_off.tail);
+    sq_mask_ = at<unsigned>(sq_ptr_, params.sq_off.ring_mask);
+    sq_array_ = at<unsigned>(sq_ptr_, params.sq_off.array);
+    cq_head_ = at<unsigned>(cq_ptr_, params.cq_off.head);
+    cq_tail_ = at<unsigned>(cq_ptr_, params.cq_off.tail);
+    cq_mask_ = at<unsigned>(cq_ptr_, params.cq_off.ring_mask);
+    cqes_ = at<io_uring_cqe>(cq_ptr_, params.cq_off.cqes);
+}
+
+IoUringIO::~IoUringIO() {
+    {
+        // Never unmap while the kernel may still post completions
+        std::lock_guard<std::mutex> lk(ring_latch_);
+        while (inflight_ > 0) {
+            if (reap() == 0) uring_enter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS);
+        }
+    }
+    ::munmap(sqes_, sqes_size_);
+    if (cq_ptr_ != sq_ptr_) ::munmap(cq_ptr_, cq_ring_size_);
+    ::munmap(sq_ptr_, sq_ring_size_);
+    ::close(ring_fd_);
+}
+
+void IoUringIO::submit(std::span<IORequest* const> batch) {
+    std::lock_guard<std::mutex> lk(ring_latch_);
+    size_t next = 0;
+    while (next < batch.size()) {
+        // Keep the completion queue from overflowing: reap before adding more
+        while (inflight_ >= cq_entries_) {
+            if (reap() == 0) uring_enter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS);
+        }
+
+        unsigned tail = *sq_tail_;
+        unsigned head = load_acquire(sq_head_);
+        unsigned queued = 0;
+        while (next < batch.size() && tail - head < sq_entries_ && inflight_ + queued < cq_entries_) {
+            IORequest* r = batch[next++];
+            r->done.store(false, std::memory_order_relaxed);
+
+            unsigned idx = tail & *sq_mask_;
+            io_uring_sqe& sqe = sqes_[idx];
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = r->write ? IORING_OP_WRITE : IORING_OP_READ;
+            sqe.fd = fd_;
+            sqe.off = static_cast<uint64_t>(r->page_id) * Page::PAGE_SIZE;
+            sqe.addr = reinterpret_cast<uint64_t>(r->buffer);
+            sqe.len = Page::PAGE_SIZE;
+            sqe.user_data = reinterpret_cast<uint64_t>(r);
+            sq_array_[idx] = idx;
+            ++tail;
+            ++queued;
+        }
+        store_release(sq_tail_, tail);
+
+        unsigned left = queued;
+        while (left > 0) {
+            int n = uring_enter(ring_fd_, left, 0, 0);
+            if (n < 0) {
+                if (errno == EINTR || errno == EAGAIN || errno == EBUSY) { reap(); continue; }
+                int err = errno;
+                // Take back the entries the kernel has not consumed, fail
+                // them and the rest of the batch, and let the ones in
+                // flight finish: the caller frees the requests on the throw
+                store_release(sq_tail_, tail - left);
+                inflight_ += queued - left;
+                for (size_t i = next - left; i < batch.size(); ++i) {
+                    batch[i]->result = -err;
+                    batch[i]->done.store(true, std::memory_order_release);
+                }
+                drain(batch);
+                throw std::runtime_error(std::string("io_uring_enter failed: ") + std::strerror(err));
+            }
+            left -= static_cast<unsigned>(n);
+        }
+        inflight_ += queued;
+    }
+}
+
+size_t IoUringIO::reap() {
+    unsigned head = *cq_head_;
+    unsigned tail = load_acquire(cq_tail_);
+    size_t reaped = 0;
+    while (head != tail) {
+        const io_uring_cqe& cqe = cqes_[head & *cq_mask_];
+        IORequest* r = reinterpret_cast<IORequest*>(cqe.user_data);
+        r->result = cqe.res;
+
+        // Short read at end of file: the rest of the page is zeros
+        if (!r->write && cqe.res >= 0 && static_cast<size_t>(cqe.res) < Page::PAGE_SIZE) {
+            std::memset(r->buffer + cqe.res, 0, Page::PAGE_SIZE - cqe.res);
+            r->result = static_cast<int>(Page::PAGE_SIZE);
+        }
+        r->done.store(true, std::memory_order_release);
+        ++head;
+        ++reaped;
+    }
+    store_release(cq_head_, head);
+    inflight_ -= static_cast<unsigned>(reaped);
+    return reaped;
+}
+
+void IoUringIO::drain(std::span<IORequest* const> batch) {
+    // Reaping and blocking happen under the latch: a request that is not
+    // done yet is still in flight, so its completion is bound to arrive
+    for (IORequest* r : batch) {
+        while (!r->done.load(std::memory_order_acquire)) {
+            if (reap() == 0) uring_enter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS);
+        }
+    }
+}
+
+void IoUringIO::wait(std::span<IORequest* const> batch) {
+    std::lock_guard<std::mutex> lk(ring_latch_);
+    drain(batch);
+    // Only now that none is in flight may the caller unwind past them
+    for (IORequest* r : batch) {
+        if (r->result != static_cast<int>(Page::PAGE_SIZE)) {
+            throw std::runtime_error(std::string("io_uring ") + (r->write ? "write" : "read") +
+                " failed: " + (r->result < 0 ? std::strerror(-r->result) : "short transfer"));
+        }
+    }
+}
+
+void IoUringIO::poll() {
+    // Somebody else holding the latch is reaping already
+    std::unique_lock<std::mutex> lk(ring_latch_, std::try_to_lock);
+    if (lk.owns_lock()) reap();
+}
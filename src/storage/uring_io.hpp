@@ -0,0 +1,54 @@
+#pragma once
+#include <mutex>
+#include <linux/io_uring.h>
+#include "posix_io.hpp"
+
+/*
+ * io_uring backend, driven through the raw syscalls (no liburing).
+ *
+ * submit() turns a batch into IORING_OP_READ / IORING_OP_WRITE entries and
+ * returns once the kernel has accepted them; wait() reaps completions for
+ * every caller and returns when its own requests are done. Synchronous
+ * read_page/write_page and sync() fall through to pread/pwrite/fdatasync.
+ */
+class IoUringIO : public PosixIO {
+public:
+    static constexpr unsigned QUEUE_DEPTH = 256;
+
+    // Throws std::runtime_error if the kernel refuses to set up a ring
+    IoUringIO(int fd, bool direct);
+    ~IoUringIO() override;
+
+    IoUringIO(const IoUringIO&) = delete;
+    IoUringIO& operator=(const IoUringIO&) = delete;
+
+    void submit(std::span<IORequest* const> batch) override;
+    void wait(std::span<IORequest* const> batch) override;
+    bool async() const override { return true; }
+    void poll() override;
+    const char* name() const override { return direct_ ? "io_uring+O_DIRECT" : "io_uring"; }
+
+private:
+    // Drain the completion queue. Caller holds ring_latch_.
+    size_t reap();
+    // Reap until every request of the batch is done. Caller holds ring_latch_.
+    void drain(std::span<IORequest* const> batch);
+
+    int ring_fd_ = -1;
+
+    void*  sq_ptr_ = nullptr;
+    void*  cq_ptr_ = nullptr;
+    size_t sq_ring_size_ = 0;
+    size_t cq_ring_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+
+    unsigned* sq_head_; unsigned* sq_tail_; unsigned* sq_mask_; unsigned* sq_array_;
+    unsigned* cq_head_; unsigned* cq_tail_; unsigned* cq_mask_;
+    io_uring_cqe* cqes_;
+    unsigned sq_entries_ = 0;
+    unsigned cq_entries_ = 0;
+    unsigned inflight_ = 0;            // submitted, not yet reaped
+
+    std::mutex ring_latch_;
+};